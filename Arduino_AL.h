@@ -50,6 +50,7 @@ extern "C" {
 #define FILEAPPEND 2
 
 #define Log(...)  { sprintf(LogBuf,__VA_ARGS__); DebugPrint(LogBuf); } // Stuff string and parms via sprintf and output
+// Log() costs a sprintf and waits for the serial port - use the DLOG macros in dlog.h anywhere that matters.
 // #define Log(...) // Liberate (a lot of) RAM by uncommenting this empty definition
 
 #define LogBufSize 64
@@ -73,7 +74,10 @@ void HAL_SPI_ReadBuffer(uint8_t *Buffer, uint32_t Length);
 // These functions encapsulate Arduino core functions
 void Init_Keys(void);
 void DebugPrint(char *str);
+void DebugWrite(uint8_t *data, uint16_t len);
 void HAL_Delay(uint32_t DLY);
+uint32_t HAL_Millis(void);
+uint32_t HAL_Micros(void);
 bool SaveTouchMatrix(void);
 bool LoadTouchMatrix(void);
 void Eve_Reset_HW(void);
@@ -83,7 +87,10 @@ void FileOpen(char *filename, uint8_t mode);
 void FileClose(void);
 uint8_t FileReadByte(void);
 void FileReadBuf(uint8_t *data, uint32_t NumBytes);
+void FileReadStart(uint8_t *data, uint32_t NumBytes);
+void FileReadWait(void);
 void FileWriteByte(uint8_t data);
+void FileWriteBuf(uint8_t *data, uint32_t NumBytes);
 uint32_t FileSize(void);
 uint32_t FilePosition(void);
 bool FileSeek(uint32_t offset);
@@ -2,11 +2,24 @@
 #include <stdbool.h>        // Find type "bool"
 #include <SPI.h>            // Arduino SPI library
 #include <SD.h>             // Arduino SD card library
+#ifdef __AVR__
+#include <avr/sleep.h>      // Sleep while idle
+#endif
 
 
 #include "Eve2_81x.h"       // Matrix Orbital EVE Library      
 #include "Arduino_AL.h"     // Hardware abstraction layer for Arduino
 #include "process.h"        // More application level code
+#include "input.h"          // Touch tag and key events
+#include "sched.h"          // Cooperative task scheduler
+#include "sound.h"          // Sound effects
+#include "pcm.h"            // Streamed audio
+#include "dlog.h"           // Deferred logging
+#include "perf.h"           // Screen transition timing
+#include "dlcheck.h"        // Display list budget
+#include "power.h"          // Idle power states
+#include "peep.h"           // Peephole pass on the FIFO
+#include "shot.h"           // Screenshots
 #include "MatrixEve2Conf.h" // Display select
 
 // The file of type File and named myFile is global and used for any and all files.  
@@ -24,6 +37,7 @@ void setup()
   GlobalInit();                                     // EVE display interface initialization
   FT81x_Init(DISPLAY_43, BOARD_EVE2, TOUCH_TPC);    // Reset and initialize the EVE
   SD_Init();
+  FlashAssets_Init();                               // EVE3/EVE4: copy the images into flash once and load them from there
 
   if (!LoadTouchMatrix())
   {
@@ -53,116 +67,136 @@ void loop()
   MainLoop(); // jump to "main()"
 }
 
-// MainLoop is called from loop() and it never leaves (which is better than loop() which is called repeatedly)
-// Note that if you use loop() instead, you will need to define variables "static" (since loop() is not actually a loop).
-// In this infinite loop we are responding to many different signals including: Virtual key presses on screens, Real
-// key presses of Real Keys, Slider touch, and timeouts.  We have to keep track of which screen we are on.
-void MainLoop(void)
+// State shared by the tasks below
+static uint8_t ScreenNumber = SCR_FTDI;
+static char ShotFile[] = "SHOT.TGA";                         // Key 3 saves the screen here
+static ShotStats Shot;
+
+// Act on the input events which have arrived since last time: Virtual key presses on screens and Real key
+// presses of Real Keys.  We have to keep track of which screen we are on.
+static void HandleInput(void)
 {
+  InputEvent Events[4];
+  uint8_t Count, n;
   uint8_t Tag = 0;
   uint8_t Key = 0;
-  uint8_t ScreenNumber = SCR_FTDI;
-  uint64_t TouchTimeout = 100;
-  uint64_t Time2CheckKeys = 100;
 
-  while(1)
+  Count = Input_GetEvents(Events, 4);                        // Handled in a batch, oldest first
+  for (n = 0; n < Count; n++)
   {
-    if (millis() > TouchTimeout)
+    if (Power_Activity())                                    // This one just woke the panel up
+      continue;
+    Tag = (Events[n].Type == INPUT_TAG_DOWN) ? Events[n].Code : 0;
+    Key = (Events[n].Type == INPUT_KEY_DOWN) ? Events[n].Code : 0;
+
+    if(Tag)
     {
-      Tag = rd8(REG_TOUCH_TAG + RAM_REG);                    // Check for touches
-      if(Tag)
+      Log("Touch Tag %d", Tag);
+      switch (Tag)
       {
-        Log("Touch Tag %d", Tag);
-        switch (Tag)
-        {
-        case 1:
-        case 2:
-          SelectScreen(SCR_FTDI);
-          ScreenNumber = SCR_FTDI;
-          break;
-        case 10:                                             // Sound Demo Screen (Makescreen_Button)
-          Log(" - 10\n");
-          SetPin(EveAudioEnable_PIN, HIGH);                  // Enable Audio
-          wr8(REG_VOL_SOUND + RAM_REG, 0xFF);                // Set the volume to maximum
-          wr16(REG_SOUND + RAM_REG, 0x3041);                 // Select Xylophone note C3
-          wr8(REG_PLAY + RAM_REG, 1);                        // Play the sound
-           break;
-        case 11:                                             // Sound Demo Screen (Makescreen_Button) 
-          Log(" - 11\n");
-          SetPin(EveAudioEnable_PIN, HIGH);                  // Enable Audio
-          wr8(REG_VOL_SOUND + RAM_REG, 0xFF);                // Set the volume to maximum
-          wr16(REG_SOUND + RAM_REG, 0x4841);                 // Select Xylophone note C5
-          wr8(REG_PLAY + RAM_REG, 1);                        // Play the sound
-          break;
-        case 12:                                             // Sound Demo Screen (Makescreen_Button) 
-          Log(" - 12\n");
-          SetPin(EveAudioEnable_PIN, HIGH);                  // Enable Audio
-          wr8(REG_VOL_SOUND + RAM_REG, 0xFF);                // Set the volume to maximum
-          wr16(REG_SOUND + RAM_REG, 0x4146);                 // Select Piano note F2
-          wr8(REG_PLAY + RAM_REG, 1);                        // Play the sound
-          break;
-        case 13:                                             // Sound Demo Screen (Makescreen_Button) 
-          Log(" - 13\n");
-          SetPin(EveAudioEnable_PIN, HIGH);                  // Enable Audio
-          wr8(REG_VOL_SOUND + RAM_REG, 0xFF);                // Set the volume to maximum
-          wr16(REG_SOUND + RAM_REG, 0x5346);                 // Select Piano note F3
-          wr8(REG_PLAY + RAM_REG, 1);                        // Play the sound
-          break;
-        default:                                             // Invalid tag value (importantly includes value 255)
-          Log("\n");
-          break;                                             // unrequired break
-        } 
-        while(rd8(REG_PLAY + RAM_REG));                      // Wait until sound finished
-        SetPin(EveAudioEnable_PIN, LOW);                     // Disable Audio
-      }
-      TouchTimeout = millis() + 20;                          // This sets the sample rate for slider finger movement as well
+      case 1:
+      case 2:
+        SelectScreen(SCR_FTDI);
+        ScreenNumber = SCR_FTDI;
+        break;
+      case 10:                                             // Sound Demo Screen (Makescreen_Button)
+        Log(" - 10\n");
+        Sound_Play(SOUND_XYLOPHONE, MIDI_NOTE(NOTE_C, 3), 0xFF, true);  // Xylophone note C3 at full volume
+         break;
+      case 11:                                             // Sound Demo Screen (Makescreen_Button) 
+        Log(" - 11\n");
+        Sound_Play(SOUND_XYLOPHONE, MIDI_NOTE(NOTE_C, 5), 0xFF, true);  // Xylophone note C5 at full volume
+        break;
+      case 12:                                             // Sound Demo Screen (Makescreen_Button) 
+        Log(" - 12\n");
+        Sound_Play(SOUND_PIANO, MIDI_NOTE(NOTE_F, 4), 0xFF, true);  // Piano note F4 at full volume
+        break;
+      case 13:                                             // Sound Demo Screen (Makescreen_Button) 
+        Log(" - 13\n");
+        Sound_Play(SOUND_PIANO, MIDI_NOTE(NOTE_B, 5), 0xFF, true);  // Piano note B5 at full volume
+        break;
+      default:                                             // Invalid tag value (importantly includes value 255)
+        Log("\n");
+        break;                                             // unrequired break
+      } 
     }
 
-
-    if (millis() > Time2CheckKeys)
+    switch (Key)
     {
-      if(Key)              // If there was a key and there has not yet been a no-key read
-      {
-        Key = CheckKeys(); // When previous key released, this resets to zero
-      }
-      else
+    case 0: break; // No key seen
+    case 1:
+      Log("Key 1\n");
+      ScreenNumber++; 
+      if(ScreenNumber > SCR_PAL) ScreenNumber = SCR_FTDI;
+      SelectScreen(ScreenNumber);
+      break;
+    case 2:
+      Log("Key 2\n");
+      ScreenNumber--; 
+      if(ScreenNumber < SCR_FTDI) ScreenNumber = SCR_PAL;
+      SelectScreen(ScreenNumber);
+      break;
+    case 3:
+      Log("Key 3\n");
+      switch(ScreenNumber)
       {
-        Key = CheckKeys();
-        switch (Key)
+      case SCR_FTDI: // we are on the initial screen so this is for calibrate
+        SelectScreen(SCR_Calibrate); // Doing a touch calibration
+        SaveTouchMatrix();
+        SelectScreen(SCR_FTDI);  // So, we go back to the initial screen
+        break;
+      default:                     // Anywhere else it takes a screenshot
+        if (Pcm_Playing())
         {
-        case 0: break; // No key seen
-        case 1:
-          Log("Key 1\n");
-          ScreenNumber++; 
-          if(ScreenNumber > SCR_RAW) ScreenNumber = SCR_FTDI;
-          SelectScreen(ScreenNumber);
-          break;
-        case 2:
-          Log("Key 2\n");
-          ScreenNumber--; 
-          if(ScreenNumber < SCR_FTDI) ScreenNumber = SCR_RAW;
-          SelectScreen(ScreenNumber);
-          break;
-        case 3:
-          Log("Key 3\n");
-          switch(ScreenNumber)
-          {
-          case SCR_FTDI: // we are on the initial screen so this is for calibrate
-            SelectScreen(SCR_Calibrate); // Doing a touch calibration
-            SaveTouchMatrix();
-            SelectScreen(SCR_FTDI);  // So, we go back to the initial screen
-            break;
-          default:
-            break;
-          }
-          break;
+          Log("No shot while PCM plays\n");                   // The ring is in the scratch space
         }
+        else if (Shot_Capture(ShotFile, SHOT_SCRATCH, SHOT_SCRATCH_SIZE, &Shot))
+          Shot_LogStats(ShotFile, &Shot);
+        break;
       }
-      Time2CheckKeys = millis() + 100; // Key check interval
+      break;
     }
   }
 }
 
+// Put the current screen back after the panel has been powered down
+static void Redraw(void)
+{
+  SelectScreen(ScreenNumber);
+}
+
+// Nothing to do until UntilMs.  Sleep - the millis() timer interrupt wakes us again within a millisecond.
+static void Idle(uint32_t UntilMs)
+{
+#ifdef __AVR__
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_mode();
+#endif
+}
+
+// MainLoop is called from loop() and it never leaves (which is better than loop() which is called repeatedly)
+// The work is done by tasks run by the scheduler, each at its own rate, and the processor sleeps in between.
+void MainLoop(void)
+{
+  Input_Init(false, false);                                  // INT_N is not wired on this board, so the tag is polled, as are the keys
+  Sound_Init();
+  DlCheck_Enable(DLCHECK_OFF);                               // DLCHECK_SIZE keeps the high water mark of each screen's display list
+  Peep_Enable(true);                                         // Drop display list words that change nothing on the way into the FIFO (with EVE_PEEP)
+  Power_Init(DISPLAY_43, BOARD_EVE2, TOUCH_TPC, Redraw);     // As given to FT81x_Init()
+
+  Sched_Add("input", Input_Poll, 2, 0);                      // Debounced keys and tag changes go into the event queue
+  Sched_Add("ui", HandleInput, 10, 1);                       // Respond to them
+  Sched_Add("audio", Sound_Service, 20, 5);                  // Starts queued sounds and turns the amplifier off
+  Sched_Add("pcm", Pcm_Service, 50, 7);                      // Keeps the PCM ring ahead of Eve (does nothing when idle)
+  Sched_Add("log", Dlog_Flush, 100, 9);                      // Sends the deferred log out of the serial port
+#ifdef EVE_PERF
+  Sched_Add("perf", Perf_Poll, PERF_POLL_MS, 0);             // Follows each new screen through Eve onto the glass
+#endif
+  Sched_Add("power", Power_Poll, 50, 3);                     // Dims, then puts Eve to sleep when nobody is about
+  Sched_SetIdle(Idle);
+  Sched_Run();                                               // Never returns
+}
+
 // ************************************************************************************
 // Following are wrapper functions for C++ Arduino functions so that they may be      *
 // called from outside of C++ files.  These are also your opportunity to use a common *
@@ -208,6 +242,12 @@ void DebugPrint(char *str)
   Serial.print(str);
 }
 
+// Binary output for the deferred log (dlog.c)
+void DebugWrite(uint8_t *data, uint16_t len)
+{
+  Serial.write(data, len);
+}
+
 // An abstracted pin write that may be called from outside this file.
 void SetPin(uint8_t pin, bool state)
 {
@@ -312,6 +352,9 @@ void FileOpen(char *filename, uint8_t mode)
     myFile = SD.open(filename, FILE_READ);
     break;
   case FILEWRITE:
+    myFile = SD.open(filename, O_WRITE | O_CREAT | O_TRUNC);      // Start empty - FILE_WRITE adds to the end
+    break;
+  case FILEAPPEND:
     myFile = SD.open(filename, FILE_WRITE);
     break;
   default:;
@@ -339,11 +382,29 @@ void FileReadBuf(uint8_t *data, uint32_t NumBytes)
   myFile.read(data, NumBytes);
 }
 
+// Start reading bytes from a file into a provided buffer.  Hardware which can read in the background returns
+// straight away and finishes in FileReadWait().  Here the SD card shares the SPI bus with Eve, so just read.
+void FileReadStart(uint8_t *data, uint32_t NumBytes)
+{
+  myFile.read(data, NumBytes);
+}
+
+// Wait for the read begun by FileReadStart() to finish
+void FileReadWait(void)
+{
+}
+
 void FileWriteByte(uint8_t data)
 {
   myFile.write(data);
 }
 
+// Write bytes from a provided buffer to a file
+void FileWriteBuf(uint8_t *data, uint32_t NumBytes)
+{
+  myFile.write(data, NumBytes);
+}
+
 uint32_t FileSize(void)
 {
   return(myFile.size());
@@ -41,42 +41,87 @@
 #include "Eve2_81x.h"            // Header for this file with prototypes, defines, and typedefs
 #include "MatrixEve2Conf.h"      // Header for display selection 
 #include "hw_api.h"				 // for spi abstraction 
+#include "dlog.h"                // Deferred logging
 
-#define WorkBuffSz 512
-#define Log printf
+#define CoProChunkSz 512         // FIFO space CoProWrCmdBuf() waits for and fills at a time
+#define Log printf               // The application owns LogBuf and the Log() that uses it - this one needs neither
 
 // Global Variables 
-uint16_t FifoWriteLocation = 0;
-char LogBuf[WorkBuffSz];         // The singular universal data array used for all things including logging
+static EveContext DefaultContext;        // The one Eve of a single panel host
+EVE_TLS EveContext *EveCurrent = &DefaultContext;
+void (*CmdWordHook)(uint32_t Word) = 0;  // Normally none - the profiler hooks in here
+void (*CmdFilter)(uint32_t Word) = 0;    // Normally none - the peephole pass hooks in here
+void (*CmdFilterFlush)(bool Unseen) = 0;
+
+// Command recording (per thread, with EVE_THREADS).  While Buf is set Send_CMD() stores words here instead.
+static EVE_TLS uint32_t *RecordBuf;
+static EVE_TLS uint32_t RecordWords, RecordMax;
+
+// Get a context ready for a panel.  Hal tells the HAL which panel it is (see the HAL for what it points at).
+void Eve_ContextInit(EveContext *Ctx, void *Hal)
+{
+  memset(Ctx, 0, sizeof(EveContext));
+  Ctx->Hal = Hal;
+}
+
+// Direct everything that follows (on this thread, with EVE_THREADS) at one panel.  0 goes back to the default.
+void Eve_Bind(EveContext *Ctx)
+{
+  EveCurrent = Ctx ? Ctx : &DefaultContext;
+}
+
+// Record instead of send.  Until Eve_RecordStop() every command built with Send_CMD(), the Cmd_ functions and
+// CoProWrCmdBuf() is stored in Buf and nothing goes near the bus, so a thread which does not own the bus can
+// build a batch for one that does (see submit.c).  UpdateFIFO() does nothing while recording.  Commands which
+// hand back a result (CMD_GETPTR, CMD_MEMCRC...) can be recorded but their results can not be read back.
+void Eve_RecordStart(uint32_t *Buf, uint32_t MaxWords)
+{
+  RecordBuf = Buf;
+  RecordWords = 0;
+  RecordMax = MaxWords;
+}
+
+// Stop recording.  Returns the number of words recorded, or 0 if they did not all fit in the buffer.
+uint32_t Eve_RecordStop(void)
+{
+  uint32_t Words = RecordWords;
+
+  RecordBuf = 0;
+  if (Words > RecordMax)
+  {
+    Log("Recording overflow %lu words\n", (unsigned long)Words);
+    return 0;
+  }
+  return (Words);
+}
 
-static uint32_t Width;
-static uint32_t Height;
-static uint32_t HOffset;
-static uint32_t VOffset;
-static uint8_t Touch;
+bool Eve_Recording(void)
+{
+  return (RecordBuf != 0);
+}
 
 uint32_t Display_Width()
 {
-	return Width;
+	return EveCurrent->Width;
 }
 
 uint32_t Display_Height()
 {
-	return Height;
+	return EveCurrent->Height;
 }
 
 uint8_t Display_Touch()
 {
-	return Touch;
+	return EveCurrent->Touch;
 }
 
 uint32_t Display_HOffset()
 {
-	return HOffset;
+	return EveCurrent->HOffset;
 }
 uint32_t Display_VOffset()
 {
-	return VOffset;
+	return EveCurrent->VOffset;
 }
 
 
@@ -302,12 +347,13 @@ int FT81x_Init(int display, int board, int touch)
 		return 0;
 		break;
 	}
-	Width = DWIDTH;
-	Height = DHEIGHT;
-	HOffset = PIXHOFFSET;
-	VOffset = PIXVOFFSET;
-	Touch = touch;
+	EveCurrent->Width = DWIDTH;
+	EveCurrent->Height = DHEIGHT;
+	EveCurrent->HOffset = PIXHOFFSET;
+	EveCurrent->VOffset = PIXVOFFSET;
+	EveCurrent->Touch = touch;
 	Eve_Reset(); // Hard reset of the Eve chip
+	FifoWriteLocation = 0;                   // Eve starts over at 0, which matters when this is not the first time
 
 	// Wakeup Eve	
 	if (board >= BOARD_EVE3)
@@ -325,6 +371,7 @@ int FT81x_Init(int display, int board, int touch)
 	//  Log("Eve now ACTIVE\n");         //
 
 	Ready = rd32(REG_CHIP_ID);
+	EveCurrent->Chip = (Ready >> 8) & 0xFF;
 	uint16_t ValH = Ready >> 16;
 	uint16_t ValL = Ready & 0xFFFF;
 	Log("Chip ID = 0x%04x%04x\n", ValH, ValL);
@@ -342,14 +389,7 @@ int FT81x_Init(int display, int board, int touch)
 	// that happened before the last reset.  If Eve has just done a power cycle, this would be unnecessary.
 	if (rd16(REG_CMD_READ + RAM_REG) == 0xFFF)
 	{
-		// Eve is unhappy - needs a paddling.
-		uint32_t Patch_Add = rd32(REG_COPRO_PATCH_PTR + RAM_REG);
-		wr8(REG_CPU_RESET + RAM_REG, 1);
-		wr16(REG_CMD_READ + RAM_REG, 0);
-		wr16(REG_CMD_WRITE + RAM_REG, 0);
-		wr16(REG_CMD_DL + RAM_REG, 0);
-		wr8(REG_CPU_RESET + RAM_REG, 0);
-		wr32(REG_COPRO_PATCH_PTR + RAM_REG, Patch_Add);
+		CoProReset();                        // Eve is unhappy - needs a paddling.
 	}
 
 	// turn off screen output during startup
@@ -569,6 +609,26 @@ uint8_t rd8(uint32_t address)
 // Don't miss section 5.3 - Interaction with RAM_DL
 void Send_CMD(uint32_t data)
 {
+  if (RecordBuf)
+  {
+    if (RecordWords < RecordMax)
+      RecordBuf[RecordWords] = data;
+    RecordWords++;                                                 // Counts on past the end so the stop sees it
+    return;
+  }
+  if (CmdFilter)                                                   // The filter writes it, or something better, or nothing
+  {
+    CmdFilter(data);
+    return;
+  }
+  Send_CMD_Direct(data);
+}
+
+// Send_CMD() without the filter - for the filter itself
+void Send_CMD_Direct(uint32_t data)
+{
+  if (CmdWordHook)
+    CmdWordHook(data);
   wr32(FifoWriteLocation + RAM_CMD, data);                         // write the command at the globally tracked "write pointer" for the FIFO
 
   FifoWriteLocation += FT_CMD_SIZE;                                // Increment the Write Address by the size of a command - which we just sent
@@ -580,6 +640,10 @@ void Send_CMD(uint32_t data)
 // nothing until you tell it that the write position in the FIFO RAM has changed
 void UpdateFIFO(void)
 {
+  if (RecordBuf)
+    return;
+  if (CmdFilterFlush)
+    CmdFilterFlush(false);
   wr16(REG_CMD_WRITE + RAM_REG, FifoWriteLocation);               // We manually update the write position pointer
 }
 
@@ -756,6 +820,155 @@ void Cmd_SetBitmap(uint32_t addr, uint16_t fmt, uint16_t width, uint16_t height)
   Send_CMD( (uint32_t)height);
 }
 
+// *** Cmd_Snapshot - copy the screen into RAM_G as ARGB4 - FT81x Series Programmers Guide Section 5.57 **********
+// The whole screen, Width * Height * 2 bytes.  Turn the pixel clock off (REG_PCLK 0) while it runs.
+void Cmd_Snapshot(uint32_t ptr)
+{
+  Send_CMD(CMD_SNAPSHOT);
+  Send_CMD(ptr);
+}
+
+// *** Cmd_Snapshot2 - copy part of the screen into RAM_G - BT81x Series Programming Guide Section 5.58 **********
+// fmt is RGB565, ARGB4 or 0x20 for ARGB8.  Lines of w pixels, so w * 2 (or w * 4) bytes apart.
+void Cmd_Snapshot2(uint32_t fmt, uint32_t ptr, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+  Send_CMD(CMD_SNAPSHOT2);
+  Send_CMD(fmt);
+  Send_CMD(ptr);
+  Send_CMD(((uint32_t)y << 16) | x);
+  Send_CMD(((uint32_t)h << 16) | w);
+}
+
+// Register the metric block at ptr as font number font.  The bitmap handle of the same number still has to
+// be set up in each display list that uses it.
+void Cmd_SetFont(uint32_t font, uint32_t ptr)
+{
+  Send_CMD(CMD_SETFONT);
+  Send_CMD(font);
+  Send_CMD(ptr);
+}
+
+// Make ROM font romslot (16 - 34) available as font number font
+void Cmd_RomFont(uint32_t font, uint32_t romslot)
+{
+  Send_CMD(CMD_ROMFONT);
+  Send_CMD(font);
+  Send_CMD(romslot);
+}
+
+// ASTC block footprints in pixels, in the order of the COMPRESSED_RGBA_ASTC_*_KHR values.  Every block is 16 bytes.
+static const uint8_t AstcBlock[14][2] = { {4,4}, {5,4}, {5,5}, {6,5}, {6,6}, {8,5}, {8,6}, {8,8}, {10,5}, {10,6}, {10,8}, {10,10}, {12,10}, {12,12} };
+
+// Get the block width and height of an ASTC format.  Returns false for anything that is not ASTC.
+bool Astc_BlockSize(uint16_t fmt, uint8_t *bw, uint8_t *bh)
+{
+  if (!IS_ASTC(fmt))
+    return false;
+  *bw = AstcBlock[fmt - COMPRESSED_RGBA_ASTC_4x4_KHR][0];
+  *bh = AstcBlock[fmt - COMPRESSED_RGBA_ASTC_4x4_KHR][1];
+  return true;
+}
+
+// Bytes per line of a bitmap - FT81x Series Programmers Guide Section 4.7 Table 7.  For ASTC a line is a row
+// of 16 byte blocks, partial blocks at the right hand edge being rounded up.
+uint32_t Bitmap_Stride(uint16_t fmt, uint16_t width)
+{
+  uint8_t bw, bh;
+
+  if (Astc_BlockSize(fmt, &bw, &bh))
+    return ((((uint32_t)width + bw - 1) / bw) * 16);
+
+  switch (fmt)
+  {
+  case L1:
+    return (((uint32_t)width + 7) / 8);
+  case L2:
+    return (((uint32_t)width + 3) / 4);
+  case L4:
+    return (((uint32_t)width + 1) / 2);
+  case L8:
+  case RGB332:
+  case ARGB2:
+  case PALETTED565:
+  case PALETTED4444:
+  case PALETTED8:
+    return (width);
+  default:                                                           // ARGB1555, ARGB4, RGB565
+    return ((uint32_t)width * 2);
+  }
+}
+
+// Number of lines BITMAP_LAYOUT wants.  For ASTC that is the number of block rows.
+uint32_t Bitmap_Lines(uint16_t fmt, uint16_t height)
+{
+  uint8_t bw, bh;
+
+  if (Astc_BlockSize(fmt, &bw, &bh))
+    return (((uint32_t)height + bh - 1) / bh);
+  return (height);
+}
+
+// Define a bitmap handle with display list commands only - what CMD_SETBITMAP does, but usable without the
+// CoProcessor doing the work and spelled out so that you can see it.  source is a RAM_G address, or
+// FLASH_BITMAP_ADDR(flash address) for ASTC data which is drawn straight out of flash.
+// The _H commands carry the high bits of the stride, lines and size, needed once a stride passes 1023 bytes
+// (a 480 pixel wide ASTC 4x4 image has a 1920 byte stride) or a size passes 511 pixels.  They are always sent
+// so that high bits left over from the last user of the handle are cleared.
+void Bitmap_Setup(uint8_t handle, uint32_t source, uint16_t fmt, uint16_t width, uint16_t height)
+{
+  uint32_t Stride = Bitmap_Stride(fmt, width);
+  uint32_t Lines = Bitmap_Lines(fmt, height);
+
+  Send_CMD(BITMAP_HANDLE(handle));
+  Send_CMD(BITMAP_SOURCE(source));
+  if (IS_ASTC(fmt))
+  {
+    Send_CMD(BITMAP_LAYOUT(GLFORMAT, Stride, Lines));               // ASTC formats do not fit in 5 bits
+    Send_CMD(BITMAP_EXT_FORMAT(fmt));
+  }
+  else
+  {
+    Send_CMD(BITMAP_LAYOUT(fmt, Stride, Lines));
+  }
+  Send_CMD(BITMAP_LAYOUT_H(Stride, Lines));
+  Send_CMD(BITMAP_SIZE(NEAREST, BORDER, BORDER, width, height));
+  Send_CMD(BITMAP_SIZE_H(width, height));
+}
+
+// Draw a paletted bitmap (set up with Bitmap_Setup()) at x, y with its palette at RAM_G address palette.
+// PALETTED565 and PALETTED4444 take one pass.  PALETTED8 entries are 4 bytes, and Eve looks up one byte of
+// them per pass, so it takes four: alpha first into the screen's alpha, then red, green and blue each blended
+// with it (FT81x Series Programmers Guide Section 4.7).  The graphics state is put back afterwards.
+void Bitmap_DrawPaletted(uint8_t handle, uint32_t palette, uint16_t fmt, uint16_t x, uint16_t y)
+{
+  Send_CMD(BEGIN(BITMAPS));
+  if (fmt != PALETTED8)
+  {
+    Send_CMD(PALETTE_SOURCE(palette));
+    Send_CMD(VERTEX2II(x, y, handle, 0));
+  }
+  else
+  {
+    Send_CMD(SAVE_CONTEXT());
+    Send_CMD(BLEND_FUNC(ONE, ZERO));
+    Send_CMD(COLOR_MASK(0, 0, 0, 1));
+    Send_CMD(PALETTE_SOURCE(palette + 3));
+    Send_CMD(VERTEX2II(x, y, handle, 0));
+    Send_CMD(BLEND_FUNC(DST_ALPHA, ONE_MINUS_DST_ALPHA));
+    Send_CMD(COLOR_MASK(1, 0, 0, 0));
+    Send_CMD(PALETTE_SOURCE(palette + 2));
+    Send_CMD(VERTEX2II(x, y, handle, 0));
+    Send_CMD(COLOR_MASK(0, 1, 0, 0));
+    Send_CMD(PALETTE_SOURCE(palette + 1));
+    Send_CMD(VERTEX2II(x, y, handle, 0));
+    Send_CMD(COLOR_MASK(0, 0, 1, 0));
+    Send_CMD(PALETTE_SOURCE(palette));
+    Send_CMD(VERTEX2II(x, y, handle, 0));
+    Send_CMD(RESTORE_CONTEXT());
+  }
+  Send_CMD(END());
+}
+
 // *** Cmd_Memcpy - background copy a block of data - FT81x Series Programmers Guide Section 5.27 ****************
 void Cmd_Memcpy(uint32_t dest, uint32_t src, uint32_t num)
 {
@@ -765,6 +978,15 @@ void Cmd_Memcpy(uint32_t dest, uint32_t src, uint32_t num)
   Send_CMD(num);
 }
 
+// *** Cmd_Memset - fill a block of RAM_G with a byte value - FT81x Series Programmers Guide Section 5.25 ********
+void Cmd_Memset(uint32_t ptr, uint32_t value, uint32_t num)
+{
+  Send_CMD(CMD_MEMSET);
+  Send_CMD(ptr);
+  Send_CMD(value);
+  Send_CMD(num);
+}
+
 // *** Cmd_GetPtr - Get the last used address from CoPro operation - FT81x Series Programmers Guide Section 5.47 *
 void Cmd_GetPtr(void)
 {
@@ -772,6 +994,34 @@ void Cmd_GetPtr(void)
   Send_CMD(0);
 }
 
+// *** Cmd_MemCrc - CRC-32 of a block of RAM_G - FT81x Series Programmers Guide Section 5.21 **********************
+// The result replaces the last parameter word - use CoProResult() to get it.
+void Cmd_MemCrc(uint32_t ptr, uint32_t num)
+{
+  Send_CMD(CMD_MEMCRC);
+  Send_CMD(ptr);
+  Send_CMD(num);
+  Send_CMD(0);
+}
+
+// Run everything pending in the FIFO and return the last word in it.  CoProcessor commands which return a value
+// (CMD_GETPTR, CMD_MEMCRC, CMD_REGREAD...) write it over their last parameter word, so when such a command is
+// the last one sent this is its result.
+uint32_t CoProResult(void)
+{
+  UpdateFIFO();                                                       // Trigger the CoProcessor to start processing commands out of the FIFO
+  Wait4CoProFIFOEmpty();                                              // wait here until the coprocessor has read and executed every pending command.
+  return (rd32(((FifoWriteLocation + FT_CMD_FIFO_SIZE - 4) % FT_CMD_FIFO_SIZE) + RAM_CMD));
+}
+
+// Run everything pending in the FIFO followed by CMD_GETPTR and return the result, which is the end address of
+// the data written by the last CMD_INFLATE / CMD_INFLATE2 / CMD_LOADIMAGE.
+uint32_t CoProGetPtr(void)
+{
+  Cmd_GetPtr();
+  return (CoProResult());
+}
+
 // *** Set Highlight Gradient Color - FT81x Series Programmers Guide Section 5.32 ********************************
 void Cmd_GradientColor(uint32_t c)
 {
@@ -829,6 +1079,77 @@ void Cmd_Flash_Fast(void)
   Send_CMD(0);
 }
 
+// *** Flash CoProcessor Commands - BT81x Series Programming Guide **********************************************
+// Flash addresses are byte offsets from the start of the flash chip.  Eve is fussy about alignment and each
+// command lists what it wants.  Flash needs to be attached (FlashAttach) and for OPT_FLASH and CMD_FLASHSOURCE
+// users it needs to be in full speed mode (FlashFast), which requires the BT81x blob in the first 4K of flash.
+
+// Write num bytes of data following this command into erased flash.  dest is 256 byte aligned, num is a
+// multiple of 256.  The data itself is sent afterwards with CoProWrCmdBuf().
+void Cmd_FlashWrite(uint32_t dest, uint32_t num)
+{
+  Send_CMD(CMD_FLASHWRITE);
+  Send_CMD(dest);
+  Send_CMD(num);
+}
+
+// Copy num bytes from flash address src into RAM_G at dest.  dest is 4 byte aligned, src is 64 byte aligned
+// and num is a multiple of 4.
+void Cmd_FlashRead(uint32_t dest, uint32_t src, uint32_t num)
+{
+  Send_CMD(CMD_FLASHREAD);
+  Send_CMD(dest);
+  Send_CMD(src);
+  Send_CMD(num);
+}
+
+// Write num bytes from RAM_G at src into flash at dest, erasing as required.  Sectors which already hold the
+// same data are skipped, so updating with unchanged data is cheap.  dest is 4096 byte aligned, src is 4 byte
+// aligned and num is a multiple of 4096.
+void Cmd_FlashUpdate(uint32_t dest, uint32_t src, uint32_t num)
+{
+  Send_CMD(CMD_FLASHUPDATE);
+  Send_CMD(dest);
+  Send_CMD(src);
+  Send_CMD(num);
+}
+
+// Set the flash address that following OPT_FLASH commands (CMD_INFLATE2, CMD_LOADIMAGE, CMD_PLAYVIDEO) read
+// from.  ptr is 64 byte aligned.
+void Cmd_FlashSource(uint32_t ptr)
+{
+  Send_CMD(CMD_FLASHSOURCE);
+  Send_CMD(ptr);
+}
+
+// Append num bytes of display list commands stored in flash at ptr to the current display list.
+// ptr is 64 byte aligned and num is a multiple of 4.
+void Cmd_FlashAppendF(uint32_t ptr, uint32_t num)
+{
+  Send_CMD(CMD_FLASHAPPENDF);
+  Send_CMD(ptr);
+  Send_CMD(num);
+}
+
+// *** Cmd_Inflate2 - decompress into RAM_G - BT81x Series Programming Guide *************************************
+// With OPT_FLASH the compressed data is read from the flash address set by CMD_FLASHSOURCE, with OPT_MEDIAFIFO
+// from the media FIFO, and otherwise it follows in the command FIFO (like CMD_INFLATE).
+void Cmd_Inflate2(uint32_t ptr, uint32_t options)
+{
+  Send_CMD(CMD_INFLATE2);
+  Send_CMD(ptr);
+  Send_CMD(options);
+}
+
+// *** Cmd_LoadImage - decode a JPEG or PNG into RAM_G - FT81x Series Programmers Guide Section 5.15 *************
+// The image data source follows the same option rules as Cmd_Inflate2
+void Cmd_LoadImage(uint32_t ptr, uint32_t options)
+{
+  Send_CMD(CMD_LOADIMAGE);
+  Send_CMD(ptr);
+  Send_CMD(options);
+}
+
 // *** Calibrate Touch Digitizer - FT81x Series Programmers Guide Section 5.52 ***********************************
 // * This business about "result" in the manual really seems to be simply leftover cruft of no purpose - send zero
 void Cmd_Calibrate(uint32_t result)
@@ -973,6 +1294,147 @@ void Cmd_AnimDrawFrame(int16_t x, int16_t y, uint32_t aoptr, uint32_t frame)
 	Send_CMD(frame);
 }
 
+// The RAM versions take an animation object in RAM_G instead of flash.  BT817/8 only.
+void Cmd_AnimStartRam(int32_t ch, uint32_t aoptr, uint32_t loop)
+{
+	Send_CMD(CMD_ANIMSTARTRAM);
+	Send_CMD(ch);
+	Send_CMD(aoptr);
+	Send_CMD(loop);
+}
+
+void Cmd_AnimDrawFrameRam(int16_t x, int16_t y, uint32_t aoptr, uint32_t frame)
+{
+	Send_CMD(CMD_ANIMFRAMERAM);
+	Send_CMD(((uint32_t)y << 16) | x);
+	Send_CMD(aoptr);
+	Send_CMD(frame);
+}
+
+// ***************************************************************************************************************
+// *** Video and media FIFO functions ****************************************************************************
+// ***************************************************************************************************************
+// The media FIFO is a ring buffer in RAM_G which the CoProcessor reads video (and JPEG) data from.  It works just
+// like the command FIFO except that the pointers are offsets from the start of the ring and the ring lives in
+// RAM_G where you put it.  You write data at the write offset and then tell Eve by updating REG_MEDIAFIFO_WRITE.
+
+// The ring belongs to the current context (EveContext.MediaFifoBase and friends)
+#define MediaFifoBase           (EveCurrent->MediaFifoBase)
+#define MediaFifoSize           (EveCurrent->MediaFifoSize)
+#define MediaFifoWriteLocation  (EveCurrent->MediaFifoWrite)
+
+// *** Cmd_MediaFifo - set up a media FIFO in RAM_G - FT81x Series Programmers Guide Section 5.17 ***************
+void Cmd_MediaFifo(uint32_t ptr, uint32_t size)
+{
+  Send_CMD(CMD_MEDIAFIFO);
+  Send_CMD(ptr);
+  Send_CMD(size);
+}
+
+// *** Cmd_PlayVideo - play an AVI (MJPEG) video - FT81x Series Programmers Guide Section 5.18 *******************
+// With OPT_MEDIAFIFO the data comes from the media FIFO, otherwise it follows the command in the FIFO itself.
+void Cmd_PlayVideo(uint32_t options)
+{
+  Send_CMD(CMD_PLAYVIDEO);
+  Send_CMD(options);
+}
+
+// *** Cmd_VideoStart - prepare to decode frames from the media FIFO - FT81x Series Programmers Guide Section 5.19
+void Cmd_VideoStart(void)
+{
+  Send_CMD(CMD_VIDEOSTART);
+}
+
+// *** Cmd_VideoStartF - prepare to decode frames from flash - BT81x Series Programming Guide *******************
+// The video data source is set beforehand with CMD_FLASHSOURCE.
+void Cmd_VideoStartF(void)
+{
+  Send_CMD(CMD_VIDEOSTARTF);
+}
+
+// *** Cmd_VideoFrame - decode one frame into RAM_G - FT81x Series Programmers Guide Section 5.20 ****************
+// dst is where the RGB565 frame goes.  ptr is the RAM_G address of a 32 bit completion word which the
+// CoProcessor sets to 0 when the frame just decoded is the last one in the video.
+void Cmd_VideoFrame(uint32_t dst, uint32_t ptr)
+{
+  Send_CMD(CMD_VIDEOFRAME);
+  Send_CMD(dst);
+  Send_CMD(ptr);
+}
+
+// Set up the media FIFO and wait for the CoProcessor to take it (this resets REG_MEDIAFIFO_READ/WRITE to 0)
+void MediaFifo_Init(uint32_t base, uint32_t size)
+{
+  MediaFifoBase = base;
+  MediaFifoSize = size;
+  MediaFifoWriteLocation = 0;
+
+  Cmd_MediaFifo(base, size);
+  UpdateFIFO();                                                       // Trigger the CoProcessor to start processing commands out of the FIFO
+  Wait4CoProFIFOEmpty();                                              // wait here until the coprocessor has read and executed every pending command.
+}
+
+// Find the space available in the media FIFO.  We keep 4 bytes back so that full and empty are not the same thing.
+uint32_t MediaFifo_FreeSpace(void)
+{
+  uint32_t Used;
+
+  Used = (MediaFifoWriteLocation + MediaFifoSize - rd32(REG_MEDIAFIFO_READ + RAM_REG)) % MediaFifoSize;
+  return (MediaFifoSize - 4 - Used);
+}
+
+// Write as much of a buffer as fits into the media FIFO without waiting and return the number of bytes taken.
+// The data is burst into RAM_G in at most two SPI transactions (the second one only when the ring wraps).  A
+// tail that is not a whole word goes in one more, padded with zeros rather than left holding whatever RAM_G had
+// before.  HAL_SPI_WriteBuffer() ends the transaction, so nothing can be sent after it under the same address.
+uint32_t MediaFifo_Write(const uint8_t *buff, uint32_t count)
+{
+  uint32_t Room, TransferSize, Body;
+  uint32_t Written = 0;
+  uint8_t Tail[4];
+
+  Room = MediaFifo_FreeSpace() & ~3UL;                               // Keep the write offset 4 byte aligned
+  if (count > Room)
+    count = Room;
+
+  while (Written < count)
+  {
+    TransferSize = count - Written;
+    if (TransferSize > MediaFifoSize - MediaFifoWriteLocation)       // Do not write past the end of the ring
+      TransferSize = MediaFifoSize - MediaFifoWriteLocation;
+
+    Body = TransferSize & ~3UL;
+    if (Body)
+    {
+      StartCoProTransfer(MediaFifoBase + MediaFifoWriteLocation, false);
+      HAL_SPI_WriteBuffer((uint8_t*)buff + Written, Body);
+      HAL_SPI_Disable();
+    }
+    if (TransferSize > Body)                                         // Only ever the end of the data
+    {
+      memset(Tail, 0, sizeof(Tail));
+      memcpy(Tail, buff + Written + Body, TransferSize - Body);
+      StartCoProTransfer(MediaFifoBase + MediaFifoWriteLocation + Body, false);
+      HAL_SPI_WriteBuffer(Tail, sizeof(Tail));
+      HAL_SPI_Disable();
+      Body += sizeof(Tail);
+    }
+
+    Written += TransferSize;
+    MediaFifoWriteLocation = (MediaFifoWriteLocation + Body) % MediaFifoSize;
+  }
+
+  if (Written)
+    wr32(REG_MEDIAFIFO_WRITE + RAM_REG, MediaFifoWriteLocation);      // Tell Eve there is more data to chew on
+  return (Written);
+}
+
+// Return true while the media FIFO still holds data the CoProcessor has not read
+bool MediaFifo_Pending(void)
+{
+  return (rd32(REG_MEDIAFIFO_READ + RAM_REG) != MediaFifoWriteLocation);
+}
+
 // ***************************************************************************************************************
 // *** Utility and helper functions ******************************************************************************
 // ***************************************************************************************************************
@@ -1005,39 +1467,38 @@ void Wait4CoProFIFO(uint32_t room)
 void Wait4CoProFIFOEmpty(void)
 {
   uint16_t ReadReg;
-  uint8_t ErrChar;
-  uint8_t buffy[2];
+  char Report[129];
   do
   {
     ReadReg = rd16(REG_CMD_READ + RAM_REG);
     if(ReadReg == 0xFFF)
     {
       // this is a error which would require sophistication to fix and continue but we fake it somewhat unsuccessfully
-      Log("\n");
-      uint8_t Offset = 0;
-      do
-      {
-        // Get the error character and display it
-        ErrChar = rd8(RAM_ERR_REPORT + Offset);
-        Offset++;
-        sprintf(buffy, "%c", ErrChar);
-        Log(buffy);
-      }while ( (ErrChar != 0) && (Offset < 128) ); // when the last stuffed character was null, we are done
-      Log("\n");
-
-      // Eve is unhappy - needs a paddling.
-      uint32_t Patch_Add = rd32(REG_COPRO_PATCH_PTR + RAM_REG);
-      wr8(REG_CPU_RESET + RAM_REG, 1);
-      wr8(REG_CMD_READ + RAM_REG, 0);
-      wr8(REG_CMD_WRITE + RAM_REG, 0);
-      wr8(REG_CMD_DL + RAM_REG, 0);
-      wr8(REG_CPU_RESET + RAM_REG, 0);
-      wr32(REG_COPRO_PATCH_PTR + RAM_REG, Patch_Add);
+      ReadBlockRAM(RAM_ERR_REPORT, (uint8_t *)Report, 128);         // The whole report in one read rather than a byte at a time
+      Report[128] = 0;
+      Log("\n%s\n", Report);
+      DLOG0(COPRO_FAULT);
+
+      CoProReset();    // Eve is unhappy - needs a paddling.
       HAL_Delay(250);  // we already saw one error message and we don't need to see then 1000 times a second
     }
   }while( ReadReg != rd16(REG_CMD_WRITE + RAM_REG) );
 }
 
+// Reset the CoProcessor after a fault (REG_CMD_READ reads 0xFFF) and start the FIFO over from the beginning.
+// The patch pointer does not survive the reset, so it is saved and restored around it.
+void CoProReset(void)
+{
+  uint32_t Patch_Add = rd32(REG_COPRO_PATCH_PTR + RAM_REG);
+  wr8(REG_CPU_RESET + RAM_REG, 1);
+  wr16(REG_CMD_READ + RAM_REG, 0);
+  wr16(REG_CMD_WRITE + RAM_REG, 0);
+  wr16(REG_CMD_DL + RAM_REG, 0);
+  wr8(REG_CPU_RESET + RAM_REG, 0);
+  wr32(REG_COPRO_PATCH_PTR + RAM_REG, Patch_Add);
+  FifoWriteLocation = 0;                                 // Our write pointer has to follow REG_CMD_WRITE back to 0
+}
+
 // Every CoPro transaction starts with enabling the SPI and sending an address
 void StartCoProTransfer(uint32_t address, uint8_t reading)
 {
@@ -1060,10 +1521,21 @@ void CoProWrCmdBuf(const uint8_t *buff, uint32_t count)
   uint32_t TransferSize = 0;
   int32_t Remaining = count; // signed
 
+  if (RecordBuf)                                           // Recording - store it as words, padded like the FIFO would be
+  {
+    for (TransferSize = 0; TransferSize < count; TransferSize += 4)
+      Send_CMD(buff[TransferSize] | ((uint32_t)(TransferSize + 1 < count ? buff[TransferSize + 1] : 0) << 8) |
+               ((uint32_t)(TransferSize + 2 < count ? buff[TransferSize + 2] : 0) << 16) |
+               ((uint32_t)(TransferSize + 3 < count ? buff[TransferSize + 3] : 0) << 24));
+    return;
+  }
+  if (CmdFilterFlush)                                      // What the filter holds goes first, and it can not see what follows
+    CmdFilterFlush(true);
+
   do {                
     // Here is the situation:  You have up to about a megabyte of data to transfer into the FIFO
-    // Your buffer is LogBuf - limited to 64 bytes (or some other value, but always limited).
-    // You need to go around in loops taking 64 bytes at a time until all the data is gone.
+    // The FIFO has limited room (and so does the caller, if it is refilling buff from somewhere).
+    // You need to go around in loops taking CoProChunkSz bytes at a time until all the data is gone.
     //
     // Most interactions with the FIFO are started and finished in one operation in an obvious fashion, but 
     // here it is important to understand the difference between Eve RAM registers and Eve FIFO.  Even though 
@@ -1074,10 +1546,10 @@ void CoProWrCmdBuf(const uint8_t *buff, uint32_t count)
     // the possible RAM_G data through the FIFO in one step.  Also, since the Eve is not capable of updating
     // it's own FIFO pointer as data is written, you will need to intermittently tell Eve to go process some
     // FIFO in order to make room in the FIFO for more RAM_G data.    
-    Wait4CoProFIFO(WorkBuffSz);                            // It is reasonable to wait for a small space instead of firing data piecemeal
+    Wait4CoProFIFO(CoProChunkSz);                          // It is reasonable to wait for a small space instead of firing data piecemeal
 
-    if (Remaining > WorkBuffSz)                            // Remaining data exceeds the size of our buffer
-      TransferSize = WorkBuffSz;                           // So set the transfer size to that of our buffer
+    if (Remaining > CoProChunkSz)                          // Remaining data exceeds the size of our buffer
+      TransferSize = CoProChunkSz;                         // So set the transfer size to that of our buffer
     else
     {
       TransferSize = Remaining;                            // Set size to this last dribble of data
@@ -1098,18 +1570,29 @@ void CoProWrCmdBuf(const uint8_t *buff, uint32_t count)
   }while (Remaining > 0);                                  // keep going as long as we still want more
 }
 
-// Write a block of data into Eve RAM space a byte at a time.
+// Write a block of data into Eve RAM space in a single SPI transaction - Eve increments the address herself.
+// Some HAL_SPI_WriteBuffer() implementations (Arduino) overwrite the buffer with what was read back.
 // Return the last written address + 1 (The next available RAM address)
 uint32_t WriteBlockRAM(uint32_t Add, const uint8_t *buff, uint32_t count)
 {
-  uint32_t index;
-  uint32_t WriteAddress = Add;  // I want to return the value instead of modifying the variable in place
+  StartCoProTransfer(Add, false);
+  HAL_SPI_WriteBuffer((uint8_t*)buff, count);
+  HAL_SPI_Disable();
+  return (Add + count);
+}
+
+// Read a block of Eve memory in a single SPI transaction
+void ReadBlockRAM(uint32_t Add, uint8_t *buff, uint32_t count)
+{
+  HAL_SPI_Enable();
   
-  for (index = 0; index < count; index++)
-  {
-    wr8(WriteAddress++, buff[index]);
-  }
-  return (WriteAddress);
+  HAL_SPI_Write((Add >> 16) & 0x3F);
+  HAL_SPI_Write((Add >> 8) & 0xff);
+  HAL_SPI_Write(Add & 0xff);
+  
+  HAL_SPI_ReadBuffer(buff, count);                 // This takes care of the dummy byte
+  
+  HAL_SPI_Disable();
 }
 
 // CalcCoef - Support function for manual screen calibration function
@@ -84,6 +84,7 @@ extern "C" {
 #define CMD_SKETCH           0xFFFFFF30
 #define CMD_SLIDER           0xFFFFFF10
 #define CMD_SNAPSHOT         0xFFFFFF1F
+#define CMD_SNAPSHOT2        0xFFFFFF37       // BT81x only
 #define CMD_SPINNER          0xFFFFFF16
 #define CMD_STOP             0xFFFFFF17
 #define CMD_SWAP             0xFFFFFF01
@@ -112,6 +113,8 @@ extern "C" {
 #define CMD_ANIMSTART        4294967123UL
 #define CMD_ANIMSTOP         4294967124UL
 #define CMD_ANIMXY           4294967125UL 
+#define CMD_ANIMSTARTRAM     0xFFFFFF6E       // BT817/8 only - animation object in RAM_G
+#define CMD_ANIMFRAMERAM     0xFFFFFF6D       // BT817/8 only
 
 #define CMD_FLASHAPPENDF     0xFFFFFF59
 #define CMD_VIDEOSTARTF      0xFFFFFF5F
@@ -155,6 +158,7 @@ extern "C" {
 #define RAM_REG                  0x302000
 #define RAM_CMD                  0x308000
 #define RAM_ERR_REPORT           0x309800 // max 128 bytes null terminated string
+#define ROMFONT_TABLEADDRESS     0x2FFFFC // Holds the address of the metric block of ROM font 16 (each after is 148 bytes on)
 #define RAM_FLASH                0x800000
 #define RAM_FLASH_POSTBLOB       0x801000
 
@@ -182,6 +186,11 @@ extern "C" {
 #define REG_PLAYBACK_PLAY         0xCC
 #define REG_PLAYBACK_READPTR      0xBC
 #define REG_PLAYBACK_START        0xB4
+
+// REG_PLAYBACK_FORMAT values
+#define LINEAR_SAMPLES            0           // 8 bit signed
+#define ULAW_SAMPLES              1           // 8 bit u-law
+#define ADPCM_SAMPLES             2           // 4 bit IMA ADPCM, first sample in the low nibble
 #define REG_PWM_DUTY              0xD4
 #define REG_ROTATE                0x58
 #define REG_SOUND                 0x88
@@ -264,6 +273,7 @@ extern "C" {
 #define REG_MEDIAFIFO_READ        0x7014
 #define REG_MEDIAFIFO_WRITE       0x7018
 #define REG_PLAY_CONTROL          0x714E
+#define REG_ANIM_ACTIVE           0x702C      // One bit per animation channel, set while it is playing
 
 // Flash related registers
 #define REG_FLASH_STATUS          0x5F0
@@ -277,6 +287,17 @@ extern "C" {
 #define REG_INT_MASK              0xB0
 #define REG_INT_EN                0xAC
 #define REG_INT_FLAGS             0xA8
+
+// Interrupt flags - REG_INT_FLAGS, REG_INT_MASK.  FT81x Series Programmers Guide Section 4.2
+#define INT_SWAP                  0x01
+#define INT_TOUCH                 0x02
+#define INT_TAG                   0x04
+#define INT_SOUND                 0x08
+#define INT_PLAYBACK              0x10
+#define INT_CMDEMPTY              0x20
+#define INT_CMDFLAG               0x40
+#define INT_CONVCOMPLETE          0x80
+
 #define REG_GPIO                  0x94
 #define REG_GPIO_DIR              0x90
 #define REG_GPIOX                 0x9C
@@ -316,6 +337,7 @@ extern "C" {
 #define PALETTED4444                      15
 #define PALETTED8                         16
 #define L2                                17
+#define GLFORMAT                          31  // BT81x - the real format is given by BITMAP_EXT_FORMAT
 
 // Bitmap Layout Format Definitions - BT81X Series Programming Guide Section 4.6
 #define COMPRESSED_RGBA_ASTC_4x4_KHR   37808  // 8.00
@@ -333,6 +355,14 @@ extern "C" {
 #define COMPRESSED_RGBA_ASTC_12x10_KHR 37820  // 1.07
 #define COMPRESSED_RGBA_ASTC_12x12_KHR 37821  // 0.89
 
+// Blend Function Definitions - FT81x Series Programmers Guide Section 4.13 - Table 8
+#define ZERO                       0
+#define ONE                        1
+#define SRC_ALPHA                  2
+#define DST_ALPHA                  3
+#define ONE_MINUS_SRC_ALPHA        4
+#define ONE_MINUS_DST_ALPHA        5
+
 // Bitmap Parameters
 #define REPEAT                     1
 #define BORDER                     0
@@ -356,9 +386,12 @@ extern "C" {
 #define VERTEXFORMAT(frac) ((39UL<<24)|(frac))                                                                                                                           // VERTEXFORMAT - FT-PG Section 4.51
 #define CELL(cell) ((6UL<<24)|(((cell)&127UL)<<0))                                                                                                                       // CELL - FT-PG Section 4.20
 #define BITMAP_HANDLE(handle) ((5UL<<24) | (((handle) & 31UL) << 0))                                                                                                     // BITMAP_HANDLE - FT-PG Section 4.06
-#define BITMAP_SOURCE(addr) ((1UL<<24)|(((addr)&1048575UL)<<0))                                                                                                          // BITMAP_SOURCE - FT-PG Section 4.11
+#define BITMAP_SOURCE(addr) ((1UL<<24)|(((addr)&16777215UL)<<0))                                                                                                         // BITMAP_SOURCE - FT-PG Section 4.11 (24 bits on BT81x, see FLASH_BITMAP_ADDR)
 #define BITMAP_LAYOUT(format,linestride,height) ((7UL<<24)|(((format)&31UL)<<19)|(((linestride)&1023UL)<<9)|(((height)&511UL)<<0))                                       // BITMAP_LAYOUT - FT-PG Section 4.07
-#define BITMAP_LAYOUT2(linestride,height) ((28UL<<24)|(((linestride >> 10)&3) << 2) | ((height >>9) & 3))
+#define BITMAP_LAYOUT_H(linestride,height) ((40UL<<24)|((((linestride)>>10)&3UL)<<2)|((((height)>>9)&3UL)<<0))                                                         // BITMAP_LAYOUT_H - FT-PG Section 4.08
+#define BITMAP_LAYOUT2(linestride,height) BITMAP_LAYOUT_H(linestride,height)                                                                                             // Older name for BITMAP_LAYOUT_H
+#define BITMAP_SIZE_H(width,height) ((41UL<<24)|((((width)>>9)&3UL)<<2)|((((height)>>9)&3UL)<<0))                                                                        // BITMAP_SIZE_H - FT-PG Section 4.10
+#define BITMAP_EXT_FORMAT(format) ((46UL<<24)|(((format)&65535UL)<<0))                                                                                                   // BITMAP_EXT_FORMAT - BT81x PG Section 4.8
 #define BITMAP_SIZE(filter,wrapx,wrapy,width,height) ((8UL<<24)|(((filter)&1UL)<<20)|(((wrapx)&1UL)<<19)|(((wrapy)&1UL)<<18)|(((width)&511UL)<<9)|(((height)&511UL)<<0)) // BITMAP_SIZE - FT-PG Section 4.09
 #define TAG(s) ((3UL<<24)|(((s)&255UL)<<0))                                                                                                                              // TAG - FT-PG Section 4.43
 #define POINT_SIZE(sighs) ((13UL<<24)|(((sighs)&8191UL)<<0))                                                                                                             // POINT_SIZE - FT-PG Section 4.36
@@ -366,14 +399,60 @@ extern "C" {
 #define BEGIN(PrimitiveTypeRef) ((31UL<<24)|(((PrimitiveTypeRef)&15UL)<<0))                                                                                              // BEGIN - FT-PG Section 4.05
 #define END() ((33UL<<24))                                                                                                                                               // END - FT-PG Section 4.30
 #define DISPLAY() ((0UL<<24))                                                                                                                                            // DISPLAY - FT-PG Section 4.29
+#define PALETTE_SOURCE(addr) ((42UL<<24)|(((addr)&4194303UL)<<0))                                                                                                        // PALETTE_SOURCE - FT-PG Section 4.38
+#define BLEND_FUNC(src,dst) ((11UL<<24)|(((src)&7UL)<<3)|(((dst)&7UL)<<0))                                                                                               // BLEND_FUNC - FT-PG Section 4.13
+#define COLOR_MASK(r,g,b,a) ((32UL<<24)|(((r)&1UL)<<3)|(((g)&1UL)<<2)|(((b)&1UL)<<1)|(((a)&1UL)<<0))                                                                     // COLOR_MASK - FT-PG Section 4.27
+#define SAVE_CONTEXT() ((34UL<<24))                                                                                                                                      // SAVE_CONTEXT - FT-PG Section 4.41
+#define RESTORE_CONTEXT() ((35UL<<24))                                                                                                                                   // RESTORE_CONTEXT - FT-PG Section 4.39
 
 // Non FTDI Helper Macros
 #define MAKE_COLOR(r,g,b) (( r << 16) | ( g << 8) | (b))
+#define IS_BT81X(chip) ((chip) >= 0x15)                        // EveContext Chip of a BT815 or later
+#define IS_ASTC(fmt) (((fmt) >= COMPRESSED_RGBA_ASTC_4x4_KHR) && ((fmt) <= COMPRESSED_RGBA_ASTC_12x12_KHR))
+#define FLASH_BITMAP_ADDR(flashadd) (0x800000UL | ((flashadd) >> 5))  // Bitmap source address for data in flash (32 byte units)
+
+// Thread local storage for the current device context, when there are threads to have it
+#if defined(EVE_THREADS) && defined(__cplusplus)
+#  define EVE_TLS thread_local
+#elif defined(EVE_THREADS)
+#  define EVE_TLS _Thread_local
+#else
+#  define EVE_TLS
+#endif
+
+// Everything the library keeps about one Eve.  One context is built in and current from the start, so a host
+// with one panel never has to know about this.  A host with several panels makes a context per panel and binds
+// it with Eve_Bind() before talking to that panel - the library functions all work on the bound context.
+// Built with EVE_THREADS the binding is per thread, so each panel can have a thread of its own.  The panels
+// share the display settings in MatrixEve2Conf.h.
+typedef struct
+{
+  uint16_t FifoWrite;            // Our write offset into the CoPro FIFO (FifoWriteLocation)
+  uint32_t Width;
+  uint32_t Height;
+  uint32_t HOffset;
+  uint32_t VOffset;
+  uint8_t Touch;
+  uint8_t Chip;                  // 0x10 for FT810 ... 0x18 for BT818, from REG_CHIP_ID at power up
+  uint32_t MediaFifoBase;        // RAM_G address of the media FIFO ring
+  uint32_t MediaFifoSize;        // Size of the ring in bytes
+  uint32_t MediaFifoWrite;       // Our write offset into the ring
+  void *Hal;                     // The HAL's own: which bus and chip select the panel is on.  0 for the HAL default.
+} EveContext;
 
 // Global Variables
-extern uint16_t FifoWriteLocation;
+extern EVE_TLS EveContext *EveCurrent;
+#define FifoWriteLocation (EveCurrent->FifoWrite)                   // Was a global before there were contexts
+extern void (*CmdWordHook)(uint32_t Word);  // Sees every word Send_CMD() writes, just before it is written (coprof.c)
+extern void (*CmdFilter)(uint32_t Word);    // Takes every word from Send_CMD() and writes what it likes with Send_CMD_Direct() (peep.c)
+extern void (*CmdFilterFlush)(bool Unseen); // Filter to write what it is holding.  Unseen: words are going around it
 
 // Function Prototypes
+void EVE_EXPORT Eve_ContextInit(EveContext *Ctx, void *Hal);
+void EVE_EXPORT Eve_Bind(EveContext *Ctx);
+void EVE_EXPORT Eve_RecordStart(uint32_t *Buf, uint32_t MaxWords);
+uint32_t EVE_EXPORT Eve_RecordStop(void);
+bool EVE_EXPORT Eve_Recording(void);
 int EVE_EXPORT FT81x_Init(int display, int board, int touch);
 void EVE_EXPORT Eve_Reset(void);
 void EVE_EXPORT Cap_Touch_Upload(void);
@@ -386,6 +465,7 @@ uint8_t EVE_EXPORT rd8(uint32_t RegAddr);
 uint16_t EVE_EXPORT rd16(uint32_t RegAddr);
 uint32_t EVE_EXPORT rd32(uint32_t RegAddr);
 void EVE_EXPORT Send_CMD(uint32_t data);
+void EVE_EXPORT Send_CMD_Direct(uint32_t data);
 void EVE_EXPORT UpdateFIFO(void);
 uint8_t EVE_EXPORT Cmd_READ_REG_ID(void);
 
@@ -401,8 +481,23 @@ void EVE_EXPORT Cmd_Button(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint1
 void EVE_EXPORT Cmd_Text(uint16_t x, uint16_t y, uint16_t font, uint16_t options, const char* str);
 
 void EVE_EXPORT Cmd_SetBitmap(uint32_t addr, uint16_t fmt, uint16_t width, uint16_t height);
+void EVE_EXPORT Cmd_Snapshot(uint32_t ptr);
+void EVE_EXPORT Cmd_Snapshot2(uint32_t fmt, uint32_t ptr, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+void EVE_EXPORT Cmd_SetFont(uint32_t font, uint32_t ptr);
+void EVE_EXPORT Cmd_RomFont(uint32_t font, uint32_t romslot);
+void EVE_EXPORT Bitmap_Setup(uint8_t handle, uint32_t source, uint16_t fmt, uint16_t width, uint16_t height);
+void EVE_EXPORT Bitmap_DrawPaletted(uint8_t handle, uint32_t palette, uint16_t fmt, uint16_t x, uint16_t y);
+uint32_t EVE_EXPORT Bitmap_Stride(uint16_t fmt, uint16_t width);
+uint32_t EVE_EXPORT Bitmap_Lines(uint16_t fmt, uint16_t height);
+bool EVE_EXPORT Astc_BlockSize(uint16_t fmt, uint8_t *bw, uint8_t *bh);
 void EVE_EXPORT Cmd_Memcpy(uint32_t dest, uint32_t src, uint32_t num);
+void EVE_EXPORT Cmd_Memset(uint32_t ptr, uint32_t value, uint32_t num);
 void EVE_EXPORT Cmd_GetPtr(void);
+uint32_t EVE_EXPORT CoProGetPtr(void);
+void EVE_EXPORT Cmd_MemCrc(uint32_t ptr, uint32_t num);
+uint32_t EVE_EXPORT CoProResult(void);
+void EVE_EXPORT Cmd_Inflate2(uint32_t ptr, uint32_t options);
+void EVE_EXPORT Cmd_LoadImage(uint32_t ptr, uint32_t options);
 void EVE_EXPORT Cmd_GradientColor(uint32_t c);
 void EVE_EXPORT Cmd_FGcolor(uint32_t c);
 void EVE_EXPORT Cmd_BGcolor(uint32_t c);
@@ -412,21 +507,40 @@ void EVE_EXPORT Cmd_SetRotate(uint32_t rotation);
 void EVE_EXPORT Cmd_Scale(uint32_t sx, uint32_t sy);
 void EVE_EXPORT Cmd_Calibrate(uint32_t result);
 void EVE_EXPORT Cmd_Flash_Fast(void);
+void EVE_EXPORT Cmd_FlashWrite(uint32_t dest, uint32_t num);
+void EVE_EXPORT Cmd_FlashRead(uint32_t dest, uint32_t src, uint32_t num);
+void EVE_EXPORT Cmd_FlashUpdate(uint32_t dest, uint32_t src, uint32_t num);
+void EVE_EXPORT Cmd_FlashSource(uint32_t ptr);
+void EVE_EXPORT Cmd_FlashAppendF(uint32_t ptr, uint32_t num);
 
 void EVE_EXPORT Cmd_AnimStart(int32_t ch, uint32_t aoptr, uint32_t loop);
 void EVE_EXPORT Cmd_AnimStop(int32_t ch);
 void EVE_EXPORT Cmd_AnimXY(int32_t ch, int16_t x, int16_t y);
 void EVE_EXPORT Cmd_AnimDraw(int32_t ch);
 void EVE_EXPORT Cmd_AnimDrawFrame(int16_t x, int16_t y, uint32_t aoptr, uint32_t frame);
+void EVE_EXPORT Cmd_AnimStartRam(int32_t ch, uint32_t aoptr, uint32_t loop);
+void EVE_EXPORT Cmd_AnimDrawFrameRam(int16_t x, int16_t y, uint32_t aoptr, uint32_t frame);
+
+void EVE_EXPORT Cmd_MediaFifo(uint32_t ptr, uint32_t size);
+void EVE_EXPORT Cmd_PlayVideo(uint32_t options);
+void EVE_EXPORT Cmd_VideoStart(void);
+void EVE_EXPORT Cmd_VideoStartF(void);
+void EVE_EXPORT Cmd_VideoFrame(uint32_t dst, uint32_t ptr);
+void EVE_EXPORT MediaFifo_Init(uint32_t base, uint32_t size);
+uint32_t EVE_EXPORT MediaFifo_FreeSpace(void);
+uint32_t EVE_EXPORT MediaFifo_Write(const uint8_t *buff, uint32_t count);
+bool EVE_EXPORT MediaFifo_Pending(void);
 
 void EVE_EXPORT Calibrate_Manual(uint16_t Width, uint16_t Height, uint16_t V_Offset, uint16_t H_Offset);
 
 uint16_t EVE_EXPORT CoProFIFO_FreeSpace(void);
 void EVE_EXPORT Wait4CoProFIFO(uint32_t room);
 void EVE_EXPORT Wait4CoProFIFOEmpty(void);
+void EVE_EXPORT CoProReset(void);
 void EVE_EXPORT StartCoProTransfer(uint32_t address, uint8_t reading);
 void EVE_EXPORT CoProWrCmdBuf(const uint8_t *buffer, uint32_t count);
 uint32_t EVE_EXPORT WriteBlockRAM(uint32_t Add, const uint8_t *buff, uint32_t count);
+void EVE_EXPORT ReadBlockRAM(uint32_t Add, uint8_t *buff, uint32_t count);
 int32_t EVE_EXPORT CalcCoef(int32_t Q, int32_t K);
 uint32_t EVE_EXPORT Display_Width();
 uint32_t EVE_EXPORT Display_Height();
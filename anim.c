@@ -0,0 +1,194 @@
+// Animation scheduler.  Looks after the BT81x animation channels so that the application only says which
+// animations it wants and where.  All function calls are hardware ambivalent.
+//
+// A channel keeps playing inside Eve once started, so each display list only needs:
+// - CMD_ANIMSTART (or CMD_ANIMSTARTRAM) for a channel the first time it is drawn,
+// - CMD_ANIMXY for a channel that has moved,
+// - CMD_ANIMSTOP for a channel that has been released,
+// - one CMD_ANIMDRAW(-1), which draws every active channel.
+// Anim_Update() sends just that, gathered up and written to the FIFO in bursts rather than a word at a time.
+// Nothing is sent for an animation which is simply playing where it was.
+//
+// Anim_Poll() reads REG_ANIM_ACTIVE once for all channels and hands back channels whose ANIM_ONCE animation
+// has finished.  ANIM_LOOP and ANIM_HOLD channels are kept until released.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "dlog.h"                // Deferred logging
+#include "anim.h"                // Every c file has it's header and this is the one for this file
+
+#define ANIM_BAD(ch)          (((ch) < 0) || ((ch) >= ANIM_CHANNELS))  // Such as the -1 from a failed Anim_Start()
+
+typedef struct
+{
+  uint32_t Object;               // Animation object address in flash or RAM_G
+  uint32_t Loop;                 // ANIM_ONCE, ANIM_LOOP or ANIM_HOLD
+  int16_t X, Y;
+  uint8_t Where;                 // ANIM_IN_FLASH or ANIM_IN_RAM
+} AnimChannel;
+
+static AnimChannel Channels[ANIM_CHANNELS];
+
+// Channel state, one bit per channel so that Anim_Update() can skip idle channels in one test
+static uint32_t Allocated;                                           // In use by the application
+static uint32_t NeedStart;                                           // CMD_ANIMSTART not yet sent
+static uint32_t NeedXY;                                              // Moved since the last update
+static uint32_t NeedStop;                                            // Released, CMD_ANIMSTOP not yet sent
+static uint32_t Running;                                             // Started and not stopped
+
+static uint32_t Batch[ANIM_BATCH_WORDS];
+static uint8_t BatchCount;
+
+static void Anim_Flush(void)
+{
+  if (BatchCount)
+    CoProWrCmdBuf((uint8_t *)Batch, BatchCount * 4);                 // Eve is little endian, as are all our hosts
+  BatchCount = 0;
+}
+
+static void Anim_Put(uint32_t Word)
+{
+  Batch[BatchCount++] = Word;
+  if (BatchCount == ANIM_BATCH_WORDS)
+    Anim_Flush();
+}
+
+// Claim a channel and start an animation on it at (x, y).  Nothing is sent until the next Anim_Update().
+// Returns the channel, or -1 when all channels are busy.
+int8_t Anim_Start(uint32_t Object, uint8_t Where, uint32_t Loop, int16_t x, int16_t y)
+{
+  int8_t ch;
+
+  for (ch = 0; ch < ANIM_CHANNELS; ch++)
+  {
+    // A released channel is not free until its CMD_ANIMSTOP has gone out
+    if (!((Allocated | NeedStop) & (1UL << ch)))
+      break;
+  }
+  if (ch == ANIM_CHANNELS)
+  {
+    DLOG0(ANIM_FULL);
+    return -1;
+  }
+
+  Channels[ch].Object = Object;
+  Channels[ch].Where = Where;
+  Channels[ch].Loop = Loop;
+  Channels[ch].X = x;
+  Channels[ch].Y = y;
+  Allocated |= 1UL << ch;
+  NeedStart |= 1UL << ch;
+  NeedXY |= 1UL << ch;
+  return ch;
+}
+
+// Move an animation.  Only a real change costs a command.
+void Anim_Move(int8_t ch, int16_t x, int16_t y)
+{
+  if (ANIM_BAD(ch))
+    return;
+  if ((Channels[ch].X != x) || (Channels[ch].Y != y))
+  {
+    Channels[ch].X = x;
+    Channels[ch].Y = y;
+    NeedXY |= 1UL << ch;
+  }
+}
+
+// Stop an animation and give its channel back
+void Anim_Release(int8_t ch)
+{
+  uint32_t Bit;
+
+  if (ANIM_BAD(ch))
+    return;
+  Bit = 1UL << ch;
+  if (!(Allocated & Bit))
+    return;
+  Allocated &= ~Bit;
+  NeedXY &= ~Bit;
+  if (NeedStart & Bit)                                               // Never started, so there is nothing to stop
+    NeedStart &= ~Bit;
+  else
+    NeedStop |= Bit;
+}
+
+// Stop everything, e.g. when changing screens
+void Anim_ReleaseAll(void)
+{
+  NeedStop |= Running;
+  Allocated = NeedStart = NeedXY = 0;
+}
+
+// Is the animation on this channel still playing, as of the last Anim_Poll()
+bool Anim_Active(int8_t ch)
+{
+  if (ANIM_BAD(ch))
+    return false;
+  return ((Running & (1UL << ch)) != 0);
+}
+
+// Find out which animations Eve has finished with.  Channels whose ANIM_ONCE animation has ended are freed.
+// Returns the number of channels freed.  Call it once the last Anim_Update() has been executed by the
+// CoProcessor, otherwise a channel whose CMD_ANIMSTART is still in the FIFO looks finished.
+uint8_t Anim_Poll(void)
+{
+  uint32_t Active = rd32(REG_ANIM_ACTIVE + RAM_REG);
+  uint32_t Done = Running & ~Active;
+  uint8_t Freed = 0;
+  uint8_t ch;
+
+  Running &= Active;
+  for (ch = 0; Done; ch++, Done >>= 1)
+  {
+    if ((Done & 1) && (Channels[ch].Loop == ANIM_ONCE) && (Allocated & (1UL << ch)))
+    {
+      Allocated &= ~(1UL << ch);
+      NeedXY &= ~(1UL << ch);
+      Freed++;
+    }
+  }
+  return (Freed);
+}
+
+// Send what the animations need for this display list.  Call it between CMD_DLSTART and DISPLAY() where the
+// animations should be drawn.
+void Anim_Update(void)
+{
+  uint32_t Work = NeedStart | NeedXY | NeedStop;
+  uint8_t ch;
+
+  for (ch = 0; Work; ch++, Work >>= 1)
+  {
+    if (!(Work & 1))
+      continue;
+
+    if (NeedStop & (1UL << ch))
+    {
+      Anim_Put(CMD_ANIMSTOP);
+      Anim_Put(ch);
+      continue;
+    }
+    if (NeedStart & (1UL << ch))
+    {
+      Anim_Put((Channels[ch].Where == ANIM_IN_RAM) ? CMD_ANIMSTARTRAM : CMD_ANIMSTART);
+      Anim_Put(ch);
+      Anim_Put(Channels[ch].Object);
+      Anim_Put(Channels[ch].Loop);
+    }
+    Anim_Put(CMD_ANIMXY);                                            // Always after a start - it defaults to (0,0)
+    Anim_Put(ch);
+    Anim_Put(((uint32_t)(uint16_t)Channels[ch].Y << 16) | (uint16_t)Channels[ch].X);
+  }
+
+  Running = (Running | NeedStart) & ~NeedStop;
+  NeedStart = NeedXY = NeedStop = 0;
+
+  if (Running)
+  {
+    Anim_Put(CMD_ANIMDRAW);
+    Anim_Put((uint32_t)-1);                                          // All channels in one go
+  }
+  Anim_Flush();
+}
@@ -0,0 +1,30 @@
+#ifndef ANIM_H
+#define ANIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+#define ANIM_CHANNELS         32                                     // BT81x has 32 animation channels
+#define ANIM_BATCH_WORDS      16                                     // Command words gathered before one burst into the FIFO
+
+// Where an animation object lives
+#define ANIM_IN_FLASH         0                                      // Flash address, as given by EVE Asset Builder
+#define ANIM_IN_RAM           1                                      // RAM_G address - BT817/8 only
+
+int8_t Anim_Start(uint32_t Object, uint8_t Where, uint32_t Loop, int16_t x, int16_t y);
+void Anim_Move(int8_t ch, int16_t x, int16_t y);
+void Anim_Release(int8_t ch);
+void Anim_ReleaseAll(void);
+bool Anim_Active(int8_t ch);
+uint8_t Anim_Poll(void);
+void Anim_Update(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
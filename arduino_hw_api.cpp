@@ -2,16 +2,24 @@
 #include <SPI.h>          // Arduino SPI library
 #include "arduino_al.h"
 #include "hw_api.h"
+#include "Eve2_81x.h"     // For the current device context
+
+// The chip select of the panel being talked to.  A context made with Eve_ContextInit() has its Hal pointing at
+// a uint8_t holding its pin - the built in context has none and uses the one on the board.
+static uint8_t ChipSelect(void)
+{
+  return (EveCurrent->Hal ? *(uint8_t *)EveCurrent->Hal : EveChipSelect_PIN);
+}
 
 // Send a series of bytes (contents of a buffer) through SPI
 void HAL_SPI_WriteBuffer(uint8_t *Buffer, uint32_t Length)
 {
   SPI.beginTransaction(SPISettings(100000, MSBFIRST, SPI_MODE0));
-  digitalWrite(EveChipSelect_PIN, LOW);
+  digitalWrite(ChipSelect(), LOW);
 
   SPI.transfer(Buffer, Length);
       
-  digitalWrite(EveChipSelect_PIN, HIGH);
+  digitalWrite(ChipSelect(), HIGH);
   SPI.endTransaction();
 }
 
@@ -37,21 +45,34 @@ void HAL_SPI_ReadBuffer(uint8_t *Buffer, uint32_t Length)
 void HAL_SPI_Enable(void)
 {
   SPI.beginTransaction(SPISettings(100000, MSBFIRST, SPI_MODE0));
-  digitalWrite(EveChipSelect_PIN, LOW);
+  digitalWrite(ChipSelect(), LOW);
 }
 
 // Disable SPI by deasserting the chip select line
 void HAL_SPI_Disable(void)
 {
-  digitalWrite(EveChipSelect_PIN, HIGH);
+  digitalWrite(ChipSelect(), HIGH);
   SPI.endTransaction();
 }
 
 // A millisecond delay wrapper for the Arduino function
+// Counts elapsed time rather than comparing against an end time, which would fail when millis() wraps
 void HAL_Delay(uint32_t DLY)
 {
-  uint32_t wait;
-  wait = millis() + DLY; while(millis() < wait);
+  uint32_t start = millis();
+  while((millis() - start) < DLY);
+}
+
+// A millisecond counter wrapper for the Arduino function
+uint32_t HAL_Millis(void)
+{
+  return(millis());
+}
+
+// A microsecond counter wrapper for the Arduino function (4us resolution on a 16MHz Uno)
+uint32_t HAL_Micros(void)
+{
+  return(micros());
 }
 
 void HAL_Eve_Reset_HW(void)
@@ -0,0 +1,252 @@
+// CoProcessor profiler.  All function calls are hardware ambivalent.
+//
+// Send_CMD() hands every word to CoProf_Word() (through CmdWordHook) before writing it, and the command table
+// in eve_disasm.c says where each command starts, so the profiler knows which FIFO offsets belong to which
+// Cmd_* call.  Runs of display list words are lumped together as one "DL" entry.
+//
+// The code being profiled calls CoProf_Capture() where it would call UpdateFIFO().  Then:
+//   COPROF_SAMPLE     Eve is let go and REG_CMD_READ is read back to back until she is idle.  The time between
+//                     two changes is charged to the command the read pointer was in.  REG_CMD_READ moves as Eve
+//                     reads words rather than as she finishes with them, so some time can land on the next
+//                     command - the picture is right, the detail is approximate.
+//   COPROF_SERIALIZE  Every command is run on its own as the next one starts, and timed from REG_CMD_WRITE
+//                     to REG_CMD_READ catching up.  Exact, but the screen takes far longer to build.
+// Data streamed with CoProWrCmdBuf() (CMD_INFLATE and friends) is charged to the command it belongs to.
+//
+// Each command's time goes into a cost table by command and size (string length, area, byte count - see
+// eve_disasm.h), which is what shows how a CMD_TEXT scales with its length.  CoProf_DumpTrace() prints the last
+// capture for tools/coprof to analyse on the host.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "eve_disasm.h"          // Where the commands start
+#include "coprof.h"              // Every c file has it's header and this is the one for this file
+
+#define FIFO_REL(x)           (((x) - CaptureStart) & (FT_CMD_FIFO_SIZE - 1))  // Offset from the start of the capture
+
+static uint8_t Mode;
+static EveCmdParser Parser;
+static CoProfCmd Cur;            // The command being written
+static bool CurOpen;
+static bool InDl;                // Cur is a run of display list words
+static bool Captured;            // The trace holds a finished capture - start over with the next word
+
+static CoProfCmd Cmds[COPROF_MAX_CMDS];
+static uint8_t CmdCount;
+static uint16_t CmdsLost;
+static CoProfSample Samples[COPROF_MAX_SAMPLES];
+static uint8_t SampleCount;
+static uint32_t CaptureUs;
+static uint16_t CaptureStart;
+
+static CoProfCost Costs[COPROF_COSTS];
+static uint8_t CostCount;
+static uint16_t CostsLost;
+
+static void CoProf_Cost(uint8_t Op, uint32_t Size, uint32_t Us)
+{
+  uint8_t Log2 = 0, n;
+
+  while ((Size >> Log2) > 1)
+    Log2++;
+  for (n = 0; n < CostCount; n++)
+  {
+    if ((Costs[n].Op == Op) && (Costs[n].SizeLog2 == Log2))
+      break;
+  }
+  if (n == CostCount)
+  {
+    if (CostCount == COPROF_COSTS)
+    {
+      CostsLost++;
+      return;
+    }
+    memset(&Costs[n], 0, sizeof(CoProfCost));
+    Costs[n].Op = Op;
+    Costs[n].SizeLog2 = Log2;
+    CostCount++;
+  }
+  Costs[n].Count++;
+  Costs[n].TotalUs += Us;
+  if (Us > Costs[n].MaxUs)
+    Costs[n].MaxUs = Us;
+}
+
+// Let Eve run everything written so far and time her.  Returns 0 if she faulted.
+static uint32_t CoProf_RunOne(void)
+{
+  uint32_t Start;
+  uint16_t ReadReg;
+
+  UpdateFIFO();
+  Start = HAL_Micros();
+  do
+  {
+    ReadReg = rd16(REG_CMD_READ + RAM_REG);
+  } while ((ReadReg != FifoWriteLocation) && (ReadReg != 0xFFF));
+  return ((ReadReg == 0xFFF) ? 0 : HAL_Micros() - Start);
+}
+
+// The command being written is complete
+static void CoProf_Close(void)
+{
+  if (!CurOpen)
+    return;
+  CurOpen = false;
+  Cur.Size = InDl ? Cur.Size : Eve_CmdSize(&Parser);                 // A DL run counted its own words
+  if (Mode == COPROF_SERIALIZE)
+  {
+    Cur.Us = CoProf_RunOne();
+    CoProf_Cost(Cur.Op, Cur.Size, Cur.Us);
+  }
+  if (CmdCount < COPROF_MAX_CMDS)
+    Cmds[CmdCount++] = Cur;
+  else
+    CmdsLost++;
+}
+
+static void CoProf_Word(uint32_t Word)
+{
+  bool Dl;
+
+  if (Captured)                                                      // First word after a capture
+  {
+    Captured = false;
+    CmdCount = 0;
+    CmdsLost = 0;
+    SampleCount = 0;
+  }
+
+  if (Eve_CmdComplete(&Parser))                                      // This word starts something
+  {
+    Dl = ((Word >> 8) != 0xFFFFFFUL);
+    if (!(Dl && InDl && CurOpen))
+    {
+      CoProf_Close();
+      memset(&Cur, 0, sizeof(Cur));
+      Cur.Offset = FifoWriteLocation;
+      Cur.Op = Dl ? EVE_OP_DL : (Word & 0xFF);
+      CurOpen = true;
+    }
+    InDl = Dl;
+  }
+  Eve_CmdParse(&Parser, Word);
+  if (InDl)
+    Cur.Size++;
+}
+
+void CoProf_Start(uint8_t NewMode)
+{
+  Mode = NewMode;
+  Eve_CmdParseReset(&Parser);
+  CurOpen = false;
+  InDl = false;
+  Captured = true;                                                   // Nothing traced yet
+  CostCount = 0;
+  CostsLost = 0;
+  CmdWordHook = (Mode == COPROF_OFF) ? 0 : CoProf_Word;
+}
+
+void CoProf_Stop(void)
+{
+  CmdWordHook = 0;
+  Mode = COPROF_OFF;
+}
+
+// Which traced command was Eve in with her read pointer at ReadPtr?  -1 for none of ours.
+static int8_t CoProf_Find(uint16_t ReadPtr, uint16_t End)
+{
+  int8_t n;
+
+  if (FIFO_REL(ReadPtr) >= FIFO_REL(End))
+    return -1;
+  for (n = CmdCount - 1; n >= 0; n--)
+  {
+    if (FIFO_REL(Cmds[n].Offset) <= FIFO_REL(ReadPtr))
+      return n;
+  }
+  return -1;
+}
+
+// Use in place of UpdateFIFO() in the code being profiled.  Returns once Eve has finished.
+void CoProf_Capture(void)
+{
+  uint32_t Start, Now;
+  uint16_t ReadReg, Last = 0xFFFF, End;
+  int8_t c;
+  uint8_t n;
+
+  if (Mode == COPROF_OFF)
+  {
+    UpdateFIFO();
+    return;
+  }
+  CoProf_Close();                                                    // In SERIALIZE mode that runs the last one
+  Captured = true;
+  CaptureUs = 0;
+  if ((Mode != COPROF_SAMPLE) || !CmdCount)
+  {
+    UpdateFIFO();
+    return;
+  }
+
+  CaptureStart = Cmds[0].Offset;
+  End = FifoWriteLocation;
+  UpdateFIFO();
+  Start = HAL_Micros();
+  do
+  {
+    ReadReg = rd16(REG_CMD_READ + RAM_REG);
+    Now = HAL_Micros() - Start;
+    if ((ReadReg != Last) && (SampleCount < COPROF_MAX_SAMPLES))     // Only changes are kept - nothing is lost
+    {
+      Samples[SampleCount].Us = Now;
+      Samples[SampleCount++].ReadPtr = ReadReg;
+    }
+    Last = ReadReg;
+  } while ((ReadReg != End) && (ReadReg != 0xFFF));
+  CaptureUs = Now;
+
+  // Charge each interval to the command Eve was in.  Past the last sample kept, the rest goes to that command.
+  for (n = 0; n < SampleCount; n++)
+  {
+    c = CoProf_Find(Samples[n].ReadPtr, End);
+    if (c >= 0)
+      Cmds[c].Us += ((n + 1 < SampleCount) ? Samples[n + 1].Us : CaptureUs) - Samples[n].Us;
+  }
+  for (n = 0; n < CmdCount; n++)
+    CoProf_Cost(Cmds[n].Op, Cmds[n].Size, Cmds[n].Us);
+}
+
+const CoProfCost *CoProf_Costs(uint8_t *Count)
+{
+  *Count = CostCount;
+  return (Costs);
+}
+
+void CoProf_LogCosts(void)
+{
+  uint8_t n;
+
+  for (n = 0; n < CostCount; n++)
+  {
+    Log("%-12s <2^%-2u %4u x %lu/%lu us\n", Eve_CmdName(Costs[n].Op), Costs[n].SizeLog2 + 1, Costs[n].Count,
+        Costs[n].TotalUs / Costs[n].Count, Costs[n].MaxUs);
+  }
+  if (CostsLost)
+    Log("%u not in the cost table\n", CostsLost);
+}
+
+// The last capture, in the form tools/coprof reads
+void CoProf_DumpTrace(void)
+{
+  uint8_t n;
+
+  Log("coprof %u %u %u %lu\n", Mode, CmdCount, CmdsLost, CaptureUs);
+  for (n = 0; n < CmdCount; n++)
+    Log("C %03x %02x %lu %lu\n", Cmds[n].Offset, Cmds[n].Op, Cmds[n].Size, Cmds[n].Us);
+  for (n = 0; n < SampleCount; n++)
+    Log("S %lu %03x\n", Samples[n].Us, Samples[n].ReadPtr);
+  Log("coprof end\n");
+}
@@ -0,0 +1,60 @@
+#ifndef COPROF_H
+#define COPROF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// CoProcessor profiler modes
+#define COPROF_OFF            0
+#define COPROF_SAMPLE         1          // Run normally, watching REG_CMD_READ as fast as the bus allows
+#define COPROF_SERIALIZE      2          // Run each command on its own and time it - exact but slow
+
+#ifndef COPROF_MAX_CMDS
+#define COPROF_MAX_CMDS       32                                     // Commands traced per capture
+#endif
+#ifndef COPROF_MAX_SAMPLES
+#define COPROF_MAX_SAMPLES    64                                     // REG_CMD_READ changes kept per capture
+#endif
+#ifndef COPROF_COSTS
+#define COPROF_COSTS          24                                     // Command type and size pairs in the cost table
+#endif
+
+typedef struct
+{
+  uint16_t Offset;               // Where it starts in the FIFO
+  uint8_t Op;                    // Low byte of the command, EVE_OP_DL for a run of display list words
+  uint32_t Size;                 // See EVE_SIZE_... in eve_disasm.h
+  uint32_t Us;                   // Time Eve spent on it
+} CoProfCmd;
+
+typedef struct
+{
+  uint32_t Us;                   // Since the capture started
+  uint16_t ReadPtr;              // REG_CMD_READ
+} CoProfSample;
+
+typedef struct
+{
+  uint8_t Op;
+  uint8_t SizeLog2;              // Sizes are lumped in powers of 2
+  uint16_t Count;
+  uint32_t TotalUs;
+  uint32_t MaxUs;
+} CoProfCost;
+
+void CoProf_Start(uint8_t Mode);
+void CoProf_Stop(void);
+void CoProf_Capture(void);
+const CoProfCost *CoProf_Costs(uint8_t *Count);
+void CoProf_LogCosts(void);
+void CoProf_DumpTrace(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
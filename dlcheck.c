@@ -0,0 +1,176 @@
+// Display list budget checks.  All function calls are hardware ambivalent.
+//
+// Running out of RAM_DL gives no error, just a broken screen, so each list is measured on its way to the
+// glass.  The CoProcessor's list is measured by REG_CMD_DL, which holds its size until the next CMD_DLSTART.
+// At DLCHECK_SIZE the host does not wait for it: the swap goes out as normal and REG_CMD_DL is read once the
+// CoProcessor is idle again, by DlCheck_Screen() for the next screen or by DlCheck_Poll().  A list still
+// being worked on then is not counted.  A list the host wrote into RAM_DL itself is measured by finding its
+// DISPLAY.
+//
+// At DLCHECK_ANALYZE the list is also read back, a chunk at a time, through the checks in eve_disasm.c, which
+// means waiting for the CoProcessor before every swap.  Those levels are debug only and are only built with
+// EVE_DISASM defined (eve_disasm.h), so on an Uno eve_disasm.c stays out of a normal build.
+//
+// The screens call DlCheck_Swap() where they would send CMD_SWAP, and DlCheck_DlSwap() where they would write
+// REG_DLSWAP.  With checking off those are exactly what they replace.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "eve_disasm.h"          // Display list decoding
+#include "dlcheck.h"             // Every c file has it's header and this is the one for this file
+
+static uint8_t Level;
+static uint8_t Screen = 0xFF;
+static uint8_t Pending = 0xFF;   // Screen whose list size is still to be read, 0xFF for none
+static DlCheckScreen Screens[DLCHECK_SCREENS];
+
+static void DlCheck_Record(uint8_t ID, uint16_t Bytes)
+{
+  DlCheckScreen *s;
+
+  if (ID >= DLCHECK_SCREENS)
+    return;
+  s = &Screens[ID];
+  s->Swaps++;
+  s->LastBytes = Bytes;
+  if (Bytes > s->HighBytes)
+  {
+    s->HighBytes = Bytes;
+    if (Bytes >= DLCHECK_WARN_BYTES)                                 // Only when it gets worse, so it does not nag
+      Log("Screen %u DL %u of %u bytes\n", ID, Bytes, FT_DL_SIZE);
+  }
+}
+
+void DlCheck_Enable(uint8_t NewLevel)
+{
+#ifndef EVE_DISASM
+  if (NewLevel > DLCHECK_SIZE)
+    NewLevel = DLCHECK_SIZE;
+#endif
+  Level = NewLevel;
+  Pending = 0xFF;
+}
+
+// Book the size of the last CoProcessor list if she has finished with it.  Never waits.
+void DlCheck_Poll(void)
+{
+  uint16_t ReadReg;
+
+  if (Pending == 0xFF)
+    return;
+  ReadReg = rd16(REG_CMD_READ + RAM_REG);
+  if (ReadReg == 0xFFF)                                              // Faulted - nothing to measure
+    Pending = 0xFF;
+  else if (ReadReg == rd16(REG_CMD_WRITE + RAM_REG))
+  {
+    DlCheck_Record(Pending, rd16(REG_CMD_DL + RAM_REG));
+    Pending = 0xFF;
+  }
+}
+
+// The screen being built, so that its list is booked to it
+void DlCheck_Screen(uint8_t ID)
+{
+  DlCheck_Poll();
+  Pending = 0xFF;                                                    // Not done yet - it is about to be overwritten
+  Screen = ID;
+}
+
+#ifdef EVE_DISASM
+// Read the list back and check it.  Words is how much of it there is, or 0 to go until DISPLAY.  Returns the
+// number of words in the list.
+static uint16_t DlCheck_Read(uint16_t Words)
+{
+  EveDlAnalyzer a;
+  uint32_t Chunk[DLCHECK_CHUNK];
+  uint16_t Add = 0, n, Count;
+  uint16_t Limit = Words ? Words : FT_DL_SIZE / 4;
+  uint8_t Finding;
+  char Text[40];
+
+  Eve_DlAnalyzeReset(&a);
+  while ((a.Words < Limit) && !a.Done)
+  {
+    Count = ((Limit - a.Words) > DLCHECK_CHUNK) ? DLCHECK_CHUNK : (Limit - a.Words);
+    ReadBlockRAM(RAM_DL + Add, (uint8_t *)Chunk, Count * 4);        // Eve and the AVR and ARM are all little endian
+    Add += Count * 4;
+    for (n = 0; (n < Count) && !a.Done; n++)
+    {
+      Finding = Eve_DlAnalyze(&a, Chunk[n]);
+      if (Level >= DLCHECK_DISASM)
+      {
+        Eve_DlDisasm(Chunk[n], Text, sizeof(Text));
+        Log("%04x %s %s\n", (a.Words - 1) * 4, Text, Eve_DlFinding(Finding));
+      }
+    }
+  }
+
+  if ((Screen < DLCHECK_SCREENS) && (Level >= DLCHECK_ANALYZE))
+  {
+    Screens[Screen].Redundant = a.Findings[EVE_DL_REDUNDANT];
+    Screens[Screen].Empty = a.Findings[EVE_DL_EMPTY];
+    Screens[Screen].Rebegin = a.Findings[EVE_DL_REBEGIN];
+  }
+  return (a.Words);
+}
+#endif
+
+// Use in place of Send_CMD(CMD_SWAP); UpdateFIFO();
+void DlCheck_Swap(void)
+{
+#ifdef EVE_DISASM
+  uint16_t Bytes;
+
+  if (Level >= DLCHECK_ANALYZE)
+  {
+    UpdateFIFO();
+    Wait4CoProFIFOEmpty();                                           // The list is complete once the CoProcessor is idle
+    Bytes = rd16(REG_CMD_DL + RAM_REG);
+    DlCheck_Read(Bytes / 4);
+    DlCheck_Record(Screen, Bytes);
+  }
+#endif
+  Send_CMD(CMD_SWAP);
+  UpdateFIFO();
+  if (Level == DLCHECK_SIZE)
+    Pending = Screen;                                                // Drops one not read yet - its size has gone
+}
+
+// Use in place of wr8(REG_DLSWAP + RAM_REG, DLSWAP_FRAME) for a list written straight into RAM_DL
+void DlCheck_DlSwap(void)
+{
+  uint16_t Words = 0;
+
+  if (Level != DLCHECK_OFF)
+  {
+#ifdef EVE_DISASM
+    Words = DlCheck_Read(0);
+#else
+    while ((Words < FT_DL_SIZE / 4) && rd32(RAM_DL + Words++ * 4))   // Without the analyzer just find DISPLAY
+      ;
+#endif
+    DlCheck_Record(Screen, Words * 4);
+  }
+  wr8(REG_DLSWAP + RAM_REG, DLSWAP_FRAME);
+}
+
+// Returns 0 for a screen that is not tracked
+const DlCheckScreen *DlCheck_Get(uint8_t ID)
+{
+  return ((ID < DLCHECK_SCREENS) ? &Screens[ID] : 0);
+}
+
+void DlCheck_LogStats(void)
+{
+  uint8_t ID;
+
+  DlCheck_Poll();
+  for (ID = 0; ID < DLCHECK_SCREENS; ID++)
+  {
+    if (!Screens[ID].Swaps)
+      continue;
+    Log("Screen %u DL %u B, max %u B\n", ID, Screens[ID].LastBytes, Screens[ID].HighBytes);
+    Log("  %u redundant %u empty %u re-BEGIN\n", Screens[ID].Redundant, Screens[ID].Empty, Screens[ID].Rebegin);
+  }
+}
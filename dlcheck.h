@@ -0,0 +1,48 @@
+#ifndef DLCHECK_H
+#define DLCHECK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// Display list budget checks
+#define DLCHECK_OFF           0          // DlCheck_Swap() is just a swap
+#define DLCHECK_SIZE          1          // Record how big each list is
+#define DLCHECK_ANALYZE       2          // Also read the list back and count what is wasted in it
+#define DLCHECK_DISASM        3          // Also Log every word of it (slow - the whole list goes out of the serial port)
+
+// The two levels that read the list back use the eve_disasm.c names, so they are only built with EVE_DISASM
+// defined (see eve_disasm.h - it is on everywhere but on an AVR).
+
+#ifndef DLCHECK_SCREENS
+#define DLCHECK_SCREENS       8
+#endif
+#define DLCHECK_WARN_BYTES    (FT_DL_SIZE * 7 / 8)                   // Warn when a screen gets this big
+#define DLCHECK_CHUNK         16                                     // Words read back at a time
+
+typedef struct
+{
+  uint16_t Swaps;
+  uint16_t LastBytes;
+  uint16_t HighBytes;            // High water mark
+  uint16_t Redundant;            // From the last list analyzed
+  uint16_t Empty;
+  uint16_t Rebegin;
+} DlCheckScreen;
+
+void DlCheck_Enable(uint8_t Level);
+void DlCheck_Screen(uint8_t ID);
+void DlCheck_Poll(void);
+void DlCheck_Swap(void);
+void DlCheck_DlSwap(void);
+const DlCheckScreen *DlCheck_Get(uint8_t ID);
+void DlCheck_LogStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
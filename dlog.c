@@ -0,0 +1,94 @@
+// Deferred binary logging.  All function calls are hardware ambivalent.
+//
+// Dlog_Put() is the producer and Dlog_Flush() the consumer of a single ring of words.  Each owns one index
+// (Head and Tail), and an index is only moved once the words it covers are written or read, so neither needs
+// to lock the other out.  A record which does not fit is dropped and counted rather than waiting for the
+// serial port, and the count goes out as a record of its own once there is room.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "dlog.h"                // Every c file has it's header and this is the one for this file
+
+#define DLOG_MASK             (DLOG_RING_WORDS - 1)
+
+static uint32_t Ring[DLOG_RING_WORDS];
+static volatile uint8_t Head;    // Next word to write - only Dlog_Put() moves it
+static volatile uint8_t Tail;    // Next word to read - only Dlog_Flush() moves it
+static uint32_t Dropped;         // Since the last LOG_DROPPED record
+static uint32_t DroppedTotal;
+
+#ifdef DLOG_TEXT
+#define DLOG_MSG(Id, Level, Format) Format,
+static const char *const Formats[] = {
+#include "dlog_msgs.h"
+};
+#undef DLOG_MSG
+#endif
+
+void Dlog_Put(uint8_t Id, uint8_t Args, uint32_t a, uint32_t b, uint32_t c)
+{
+  uint8_t h = Head;
+
+  if ((uint8_t)(h - Tail) + 1 + Args >= DLOG_RING_WORDS)             // One word kept free so full != empty
+  {
+    Dropped++;
+    DroppedTotal++;
+    return;
+  }
+  Ring[h & DLOG_MASK] = Id | ((uint32_t)Args << 8) | (HAL_Millis() << 10);
+  if (Args > 0) Ring[(h + 1) & DLOG_MASK] = a;
+  if (Args > 1) Ring[(h + 2) & DLOG_MASK] = b;
+  if (Args > 2) Ring[(h + 3) & DLOG_MASK] = c;
+  Head = h + 1 + Args;                                               // Publish
+}
+
+// Send whatever has been recorded.  Run it as a low priority scheduler task.
+void Dlog_Flush(void)
+{
+  uint32_t Words[4];
+  uint8_t Args, n;
+#ifndef DLOG_TEXT
+  uint8_t Frame[1 + sizeof(Words)];
+#endif
+
+  if (Dropped && ((uint8_t)(Head - Tail) + 2 < DLOG_RING_WORDS))     // Once there is room to say so
+  {
+    Dlog_Put(DLOG_LOG_DROPPED, 1, Dropped, 0, 0);
+    Dropped = 0;
+  }
+
+  while (Tail != Head)
+  {
+    Words[0] = Ring[Tail & DLOG_MASK];
+    Args = (Words[0] >> 8) & 3;
+    for (n = 1; n <= Args; n++)
+      Words[n] = Ring[(uint8_t)(Tail + n) & DLOG_MASK];
+    Tail = Tail + 1 + Args;                                          // Hand the space back before the slow part
+
+#ifdef DLOG_TEXT
+    if ((Words[0] & 0xFF) < DLOG_MSG_COUNT)
+    {
+      n = sprintf(LogBuf, "%lu ", Words[0] >> 10);
+      snprintf(LogBuf + n, LogBufSize - n - 1, Formats[Words[0] & 0xFF], Words[1], Words[2], Words[3]);
+      strcat(LogBuf, "\n");
+      DebugPrint(LogBuf);
+    }
+#else
+    Frame[0] = DLOG_SYNC;
+    for (n = 0; n <= Args; n++)                                      // Little endian whatever the host is
+    {
+      Frame[1 + n * 4] = Words[n];
+      Frame[2 + n * 4] = Words[n] >> 8;
+      Frame[3 + n * 4] = Words[n] >> 16;
+      Frame[4 + n * 4] = Words[n] >> 24;
+    }
+    DebugWrite(Frame, 1 + (Args + 1) * 4);
+#endif
+  }
+}
+
+uint32_t Dlog_Dropped(void)
+{
+  return (DroppedTotal);
+}
@@ -0,0 +1,63 @@
+#ifndef DLOG_H
+#define DLOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// Deferred logging.  A call records the message number and its arguments in a ring and returns - a handful of
+// stores instead of a sprintf and milliseconds of serial output.  Dlog_Flush(), run as a scheduler task, sends
+// the records out later: as binary frames for tools/dlogdec to turn into text on the host, or, with DLOG_TEXT
+// defined, formatted here (which puts every format string in RAM on an AVR).
+//
+// Messages live in dlog_msgs.h.  Any message below DLOG_LEVEL compiles to nothing, arguments and all.
+// Only call these from the main loop, never from an interrupt - the ring has one producer.
+//
+// Binary frame, little endian: 0xA5, then a header word, then one word per argument.
+//   Header bits 0-7 message number, bits 8-9 argument count, bits 10-31 HAL_Millis() (wraps every 70 minutes).
+
+#define DLOG_ERR              0
+#define DLOG_WARN             1
+#define DLOG_INFO             2
+#define DLOG_DEBUG            3
+
+#ifndef DLOG_LEVEL
+#define DLOG_LEVEL            DLOG_INFO                              // Keep messages at this level and more severe
+#endif
+#ifndef DLOG_RING_WORDS
+#define DLOG_RING_WORDS       32                                     // Power of 2, at most 256.  128 bytes on the Uno.
+#endif
+
+#define DLOG_SYNC             0xA5                                   // Not ASCII, so frames can share the port with Log()
+
+// Message numbers, and each message's level as a constant the compiler can fold away
+#define DLOG_MSG(Id, Level, Format) DLOG_##Id,
+enum { 
+#include "dlog_msgs.h"
+DLOG_MSG_COUNT };
+#undef DLOG_MSG
+#define DLOG_MSG(Id, Level, Format) DLOG_LEVEL_##Id = Level,
+enum {
+#include "dlog_msgs.h"
+};
+#undef DLOG_MSG
+
+#define DLOG_ON(Id)           (DLOG_LEVEL_##Id <= DLOG_LEVEL)
+
+#define DLOG0(Id)             do { if (DLOG_ON(Id)) Dlog_Put(DLOG_##Id, 0, 0, 0, 0); } while (0)
+#define DLOG1(Id, a)          do { if (DLOG_ON(Id)) Dlog_Put(DLOG_##Id, 1, (uint32_t)(a), 0, 0); } while (0)
+#define DLOG2(Id, a, b)       do { if (DLOG_ON(Id)) Dlog_Put(DLOG_##Id, 2, (uint32_t)(a), (uint32_t)(b), 0); } while (0)
+#define DLOG3(Id, a, b, c)    do { if (DLOG_ON(Id)) Dlog_Put(DLOG_##Id, 3, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c)); } while (0)
+
+void Dlog_Put(uint8_t Id, uint8_t Args, uint32_t a, uint32_t b, uint32_t c);
+void Dlog_Flush(void);
+uint32_t Dlog_Dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
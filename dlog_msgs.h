@@ -0,0 +1,32 @@
+// The deferred log message table.  No include guard - it is expanded wherever DLOG_MSG is defined, once on the
+// device (dlog.h) and once in the host decoder (tools/dlogdec).
+//
+// DLOG_MSG(Id, Level, Format)
+//   Id      Name used at the call site: DLOG2(MEDIA_STALL, a, b)
+//   Level   DLOG_ERR, DLOG_WARN, DLOG_INFO or DLOG_DEBUG
+//   Format  printf format for up to 3 arguments.  Every argument is recorded as a uint32_t, so use %lu, %ld
+//           or %lx (and %08lx etc).  No strings - a pointer means nothing once it has left the device.
+//
+// The record carries the position in this table, so add new messages at the end and rebuild the decoder
+// along with the firmware.
+
+DLOG_MSG(LOG_DROPPED,     DLOG_WARN,  "%lu log records dropped")
+DLOG_MSG(COPRO_FAULT,     DLOG_ERR,   "CoPro fault, see the report above")
+DLOG_MSG(MEDIA_STALL,     DLOG_WARN,  "Media FIFO stalled, %lu B left")
+DLOG_MSG(LOAD_DONE,       DLOG_INFO,  "Loaded %lu B in %lu ms, %lu B/s")
+DLOG_MSG(ZLIB_USED,       DLOG_DEBUG, "ZLIB used 0x%08lx")
+DLOG_MSG(JPG_USED,        DLOG_DEBUG, "JPG used 0x%08lx")
+DLOG_MSG(RAW_LOADED,      DLOG_DEBUG, "RAW loaded at 0x%06lx")
+DLOG_MSG(SCREEN_BITMAP,   DLOG_DEBUG, "Bitmap screen up")
+DLOG_MSG(SCREEN_DL,       DLOG_DEBUG, "Bitmap DL screen up")
+DLOG_MSG(SCREEN_JPEG,     DLOG_DEBUG, "JPEG screen up")
+DLOG_MSG(CALIBRATE_START, DLOG_INFO,  "Calibrating")
+DLOG_MSG(CALIBRATE_DONE,  DLOG_INFO,  "Calibrated")
+DLOG_MSG(VIDEO_STALL,     DLOG_WARN,  "Video stalled at frame %lu")
+DLOG_MSG(SCHED_FULL,      DLOG_ERR,   "Sched full")
+DLOG_MSG(ANIM_FULL,       DLOG_WARN,  "No free anim channel")
+DLOG_MSG(PCM_UNDERRUN,    DLOG_WARN,  "PCM underrun, %lu B behind")
+DLOG_MSG(PAL_USED,        DLOG_DEBUG, "Paletted 0x%06lx to 0x%06lx")
+DLOG_MSG(SCREEN_PAL,      DLOG_DEBUG, "Paletted screen up")
+DLOG_MSG(SHOT_DONE,       DLOG_INFO,  "Shot %lu B in %lu ms, %lu strips")
+DLOG_MSG(SHOT_TIME,       DLOG_DEBUG, "Shot snap %lu us read %lu us write %lu us")
@@ -0,0 +1,519 @@
+// Decoding of CoProcessor FIFO words.  No hardware calls at all - this builds on the host as well.
+//
+// The command table gives each command's fixed argument count and what follows it, which is enough to find
+// where every command starts in a stream of FIFO words.  Argument counts are in words as they sit in the FIFO,
+// so pairs of 16 bit arguments count once (FT81x Programmers Guide chapter 5, BT81x chapter 5).
+//
+// On an AVR the tables are kept in flash (PROGMEM) and read a byte or an entry at a time.  The names, and
+// everything that prints them, are only built with EVE_DISASM (eve_disasm.h).
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "eve_disasm.h"          // Every c file has it's header and this is the one for this file
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>        // Tables in flash, not RAM
+#define DISASM_ROM            PROGMEM
+#define ROM_READ(Dst, Src, Len) memcpy_P(Dst, Src, Len)
+#define ROM_BYTE(p)           pgm_read_byte(p)
+#define ROM_WORD(p)           pgm_read_dword(p)
+#else
+#define DISASM_ROM
+#define ROM_READ(Dst, Src, Len) memcpy(Dst, Src, Len)
+#define ROM_BYTE(p)           (*(p))
+#define ROM_WORD(p)           (*(p))
+#endif
+
+#define PHASE_IDLE            0
+#define PHASE_ARGS            1
+#define PHASE_STR             2
+#define PHASE_DATA            3
+
+// Sorted by Op for the binary search
+static const EveCmdInfo CmdTable[] DISASM_ROM =
+{
+  { 0x00, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x01, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x02, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x09, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x0A, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x0B, 4, EVE_TRAILER_NONE,   EVE_SIZE_BOX,    0 },
+  { 0x0C, 2, EVE_TRAILER_STR,    EVE_SIZE_STRLEN, 0 },
+  { 0x0D, 3, EVE_TRAILER_STR,    EVE_SIZE_AREA,   0 },
+  { 0x0E, 3, EVE_TRAILER_STR,    EVE_SIZE_AREA,   0 },
+  { 0x0F, 4, EVE_TRAILER_NONE,   EVE_SIZE_AREA,   0 },
+  { 0x10, 4, EVE_TRAILER_NONE,   EVE_SIZE_AREA,   0 },
+  { 0x11, 4, EVE_TRAILER_NONE,   EVE_SIZE_AREA,   0 },
+  { 0x12, 3, EVE_TRAILER_STR,    EVE_SIZE_STRLEN, 0 },
+  { 0x13, 4, EVE_TRAILER_NONE,   EVE_SIZE_RADIUS, 0 },
+  { 0x14, 4, EVE_TRAILER_NONE,   EVE_SIZE_RADIUS, 0 },
+  { 0x15, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x16, 2, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x17, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x18, 3, EVE_TRAILER_NONE,   EVE_SIZE_BYTES,  1 },
+  { 0x19, 2, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x1A, 2, EVE_TRAILER_DATA,   EVE_SIZE_BYTES,  1 },
+  { 0x1B, 3, EVE_TRAILER_NONE,   EVE_SIZE_BYTES,  2 },
+  { 0x1C, 2, EVE_TRAILER_NONE,   EVE_SIZE_BYTES,  1 },
+  { 0x1D, 3, EVE_TRAILER_NONE,   EVE_SIZE_BYTES,  2 },
+  { 0x1E, 2, EVE_TRAILER_NONE,   EVE_SIZE_BYTES,  1 },
+  { 0x1F, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x22, 1, EVE_TRAILER_STREAM, EVE_SIZE_WORDS,  0 },
+  { 0x23, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x24, 2, EVE_TRAILER_STREAM, EVE_SIZE_WORDS,  0 },
+  { 0x25, 3, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x26, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x27, 2, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x28, 2, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x29, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x2A, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x2B, 2, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x2C, 3, EVE_TRAILER_NONE,   EVE_SIZE_AREA,   0 },
+  { 0x2D, 3, EVE_TRAILER_NONE,   EVE_SIZE_RADIUS, 0 },
+  { 0x2E, 3, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x2F, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x30, 4, EVE_TRAILER_NONE,   EVE_SIZE_AREA,   0 },
+  { 0x31, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x32, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x33, 6, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x34, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x36, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x37, 4, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x39, 2, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x3A, 1, EVE_TRAILER_STREAM, EVE_SIZE_WORDS,  0 },
+  { 0x3F, 2, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x40, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x41, 2, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x43, 3, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x44, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x45, 2, EVE_TRAILER_STREAM, EVE_SIZE_WORDS,  0 },
+  { 0x46, 3, EVE_TRAILER_NONE,   EVE_SIZE_BYTES,  2 },
+  { 0x47, 3, EVE_TRAILER_NONE,   EVE_SIZE_BYTES,  2 },
+  { 0x48, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x49, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x4A, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x4B, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x4C, 1, EVE_TRAILER_DATA,   EVE_SIZE_BYTES,  0 },
+  { 0x4D, 2, EVE_TRAILER_NONE,   EVE_SIZE_BYTES,  1 },
+  { 0x4E, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x4F, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x50, 2, EVE_TRAILER_STREAM, EVE_SIZE_WORDS,  0 },
+  { 0x53, 3, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x54, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x55, 2, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x56, 1, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x59, 2, EVE_TRAILER_NONE,   EVE_SIZE_BYTES,  1 },
+  { 0x5A, 3, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x5F, 0, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x6D, 3, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+  { 0x6E, 3, EVE_TRAILER_NONE,   EVE_SIZE_WORDS,  0 },
+};
+#define CMD_TABLE_SIZE        (sizeof(CmdTable) / sizeof(CmdTable[0]))
+
+#ifdef EVE_DISASM
+// By the same index as CmdTable
+static const char *const CmdNames[] =
+{
+  "DLSTART", "SWAP", "INTERRUPT", "BGCOLOR", "FGCOLOR", "GRADIENT", "TEXT", "BUTTON", "KEYS", "PROGRESS", "SLIDER",
+  "SCROLLBAR", "TOGGLE", "GAUGE", "CLOCK", "CALIBRATE", "SPINNER", "STOP", "MEMCRC", "REGREAD", "MEMWRITE",
+  "MEMSET", "MEMZERO", "MEMCPY", "APPEND", "SNAPSHOT", "INFLATE", "GETPTR", "LOADIMAGE", "GETPROPS",
+  "LOADIDENTITY", "TRANSLATE", "SCALE", "ROTATE", "SETMATRIX", "SETFONT", "TRACK", "DIAL", "NUMBER", "SCREENSAVER",
+  "SKETCH", "LOGO", "COLDSTART", "GETMATRIX", "GRADCOLOR", "SETROTATE", "SNAPSHOT2", "MEDIAFIFO", "PLAYVIDEO",
+  "ROMFONT", "VIDEOSTART", "VIDEOFRAME", "SETBITMAP", "FLASHERASE", "FLASHWRITE", "FLASHREAD", "FLASHUPDATE",
+  "FLASHDETACH", "FLASHATTACH", "FLASHFAST", "FLASHSPIDESEL", "FLASHSPITX", "FLASHSPIRX", "FLASHSOURCE",
+  "CLEARCACHE", "INFLATE2", "ANIMSTART", "ANIMSTOP", "ANIMXY", "ANIMDRAW", "FLASHAPPENDF", "ANIMFRAME",
+  "VIDEOSTARTF", "ANIMFRAMERAM", "ANIMSTARTRAM"
+};
+#endif
+
+// Where a command is in the table, CMD_TABLE_SIZE if it is not
+static uint8_t Eve_CmdFind(uint8_t Op)
+{
+  uint8_t Lo = 0, Hi = CMD_TABLE_SIZE, Mid, Found;
+
+  while (Lo < Hi)
+  {
+    Mid = (Lo + Hi) / 2;
+    Found = ROM_BYTE(&CmdTable[Mid].Op);
+    if (Found == Op)
+      return (Mid);
+    if (Found < Op)
+      Lo = Mid + 1;
+    else
+      Hi = Mid;
+  }
+  return (CMD_TABLE_SIZE);
+}
+
+// Look up a command word.  Returns false for anything that is not a command this table knows.
+bool Eve_CmdInfo(uint32_t Word, EveCmdInfo *Info)
+{
+  uint8_t n;
+
+  if ((Word >> 8) != 0xFFFFFFUL)
+    return false;
+  n = Eve_CmdFind(Word & 0xFF);
+  if (n == CMD_TABLE_SIZE)
+    return false;
+  ROM_READ(Info, &CmdTable[n], sizeof(EveCmdInfo));
+  return true;
+}
+
+#ifdef EVE_DISASM
+const char *Eve_CmdName(uint8_t Op)
+{
+  uint8_t n = Eve_CmdFind(Op);
+
+  if (Op == EVE_OP_DL)
+    return "DL";
+  return ((n < CMD_TABLE_SIZE) ? CmdNames[n] : "?");
+}
+#else
+// Without the names a command is its opcode
+const char *Eve_CmdName(uint8_t Op)
+{
+  static char Hex[5];
+
+  if (Op == EVE_OP_DL)
+    return "DL";
+  snprintf(Hex, sizeof(Hex), "0x%02X", Op);
+  return (Hex);
+}
+#endif
+
+void Eve_CmdParseReset(EveCmdParser *p)
+{
+  memset(p, 0, sizeof(EveCmdParser));
+  p->Op = EVE_OP_DL;
+}
+
+// Set up for whatever follows the fixed arguments
+static void Eve_CmdTrailer(EveCmdParser *p)
+{
+  p->Phase = PHASE_IDLE;
+  if (!p->Info)
+    return;
+  if (p->Info->Trailer == EVE_TRAILER_STR)
+    p->Phase = PHASE_STR;
+  else if ((p->Info->Trailer == EVE_TRAILER_DATA) && (p->Left = (p->Args[p->Info->SizeArg] + 3) / 4))
+    p->Phase = PHASE_DATA;
+}
+
+// Feed FIFO words in the order they were written.  Data streamed with CoProWrCmdBuf() must not be fed in.
+uint8_t Eve_CmdParse(EveCmdParser *p, uint32_t Word)
+{
+  uint8_t n;
+
+  switch (p->Phase)
+  {
+  case PHASE_ARGS:
+    if (p->Arg < 4)
+      p->Args[p->Arg] = Word;
+    p->Words++;
+    if (++p->Arg == p->Info->Args)
+      Eve_CmdTrailer(p);
+    return EVE_PARSE_MORE;
+
+  case PHASE_STR:
+    p->Words++;
+    for (n = 0; n < 4; n++, Word >>= 8)
+    {
+      if (!(Word & 0xFF))
+      {
+        p->Phase = PHASE_IDLE;
+        break;
+      }
+      p->StrLen++;
+    }
+    return EVE_PARSE_MORE;
+
+  case PHASE_DATA:
+    p->Words++;
+    if (!--p->Left)
+      p->Phase = PHASE_IDLE;
+    return EVE_PARSE_MORE;
+  }
+
+  // A new command, or a display list word
+  Eve_CmdParseReset(p);
+  p->Words = 1;
+  if ((Word >> 8) != 0xFFFFFFUL)
+    return EVE_PARSE_DL;
+  p->Op = Word & 0xFF;
+  if (Eve_CmdInfo(Word, &p->Entry))
+    p->Info = &p->Entry;
+  if (p->Info && p->Info->Args)
+    p->Phase = PHASE_ARGS;
+  else
+    Eve_CmdTrailer(p);
+  return EVE_PARSE_START;
+}
+
+// True when the next word starts something new
+bool Eve_CmdComplete(const EveCmdParser *p)
+{
+  return (p->Phase == PHASE_IDLE);
+}
+
+// How big the command just parsed is, in the terms of its table entry
+uint32_t Eve_CmdSize(const EveCmdParser *p)
+{
+  int32_t w, h;
+
+  if (!p->Info)
+    return (p->Words);
+  switch (p->Info->Size)
+  {
+  case EVE_SIZE_STRLEN:
+    return (p->StrLen);
+  case EVE_SIZE_AREA:
+    return ((p->Args[1] & 0xFFFF) * (p->Args[1] >> 16));
+  case EVE_SIZE_RADIUS:
+    return ((p->Args[1] & 0xFFFF) * (p->Args[1] & 0xFFFF));
+  case EVE_SIZE_BYTES:
+    return (p->Args[p->Info->SizeArg]);
+  case EVE_SIZE_BOX:
+    w = (int16_t)(p->Args[2] & 0xFFFF) - (int16_t)(p->Args[0] & 0xFFFF);
+    h = (int16_t)(p->Args[2] >> 16) - (int16_t)(p->Args[0] >> 16);
+    return ((uint32_t)((w < 0) ? -w : w) * (uint32_t)((h < 0) ? -h : h));
+  }
+  return (p->Words);
+}
+
+// *** Display lists ***********************************************************************************************
+
+#define DL_SIGNED             0x80       // Field flag: sign extend
+#define DL_PERHANDLE          0x01       // Flag: state kept per bitmap handle
+#define DL_STATE              0x02       // Flag: sets graphics state
+
+typedef struct
+{
+  uint8_t Flags;
+  uint8_t Fields[5];             // Widths from the top field down to bit 0, 0 for no more
+} EveDlInfo;
+
+static const EveDlInfo DlTable[EVE_DL_OPS] DISASM_ROM =
+{
+  { 0,                         { 0 } },
+  { DL_STATE | DL_PERHANDLE,   { 24 } },
+  { DL_STATE,                  { 8, 8, 8 } },
+  { DL_STATE,                  { 24 } },
+  { DL_STATE,                  { 8, 8, 8 } },
+  { DL_STATE,                  { 5 } },
+  { DL_STATE,                  { 7 } },
+  { DL_STATE | DL_PERHANDLE,   { 5, 10, 9 } },
+  { DL_STATE | DL_PERHANDLE,   { 1, 1, 1, 9, 9 } },
+  { DL_STATE,                  { 3, 8 } },
+  { DL_STATE,                  { 4, 8, 8 } },
+  { DL_STATE,                  { 3, 3 } },
+  { DL_STATE,                  { 3, 3 } },
+  { DL_STATE,                  { 13 } },
+  { DL_STATE,                  { 12 } },
+  { DL_STATE,                  { 8 } },
+  { DL_STATE,                  { 8 } },
+  { DL_STATE,                  { 8 } },
+  { DL_STATE,                  { 24 } },
+  { DL_STATE,                  { 8 } },
+  { DL_STATE,                  { 1 } },
+  { DL_STATE | DL_PERHANDLE,   { 17 | DL_SIGNED } },
+  { DL_STATE | DL_PERHANDLE,   { 17 | DL_SIGNED } },
+  { DL_STATE | DL_PERHANDLE,   { 24 | DL_SIGNED } },
+  { DL_STATE | DL_PERHANDLE,   { 17 | DL_SIGNED } },
+  { DL_STATE | DL_PERHANDLE,   { 17 | DL_SIGNED } },
+  { DL_STATE | DL_PERHANDLE,   { 24 | DL_SIGNED } },
+  { DL_STATE,                  { 11, 11 } },
+  { DL_STATE,                  { 12, 12 } },
+  { 0,                         { 16 } },
+  { 0,                         { 16 } },
+  { 0,                         { 4 } },
+  { DL_STATE,                  { 1, 1, 1, 1 } },
+  { 0,                         { 0 } },
+  { 0,                         { 0 } },
+  { 0,                         { 0 } },
+  { 0,                         { 0 } },
+  { 0,                         { 1 } },
+  { 0,                         { 1, 1, 1 } },
+  { DL_STATE,                  { 3 } },
+  { DL_STATE | DL_PERHANDLE,   { 2, 2 } },
+  { DL_STATE | DL_PERHANDLE,   { 2, 2 } },
+  { DL_STATE,                  { 22 } },
+  { DL_STATE,                  { 17 | DL_SIGNED } },
+  { DL_STATE,                  { 17 | DL_SIGNED } },
+  { 0,                         { 0 } },
+  { DL_STATE | DL_PERHANDLE,   { 16 } },
+  { DL_STATE | DL_PERHANDLE,   { 3, 3, 3, 3 } },
+};
+
+#ifdef EVE_DISASM
+// As in Eve2_81x.h where there is a macro, otherwise as in the programmers guide
+static const char *const DlNames[EVE_DL_OPS] =
+{
+  "DISPLAY", "BITMAP_SOURCE", "CLEAR_COLOR_RGB", "TAG", "COLOR_RGB", "BITMAP_HANDLE", "CELL", "BITMAP_LAYOUT",
+  "BITMAP_SIZE", "ALPHA_FUNC", "STENCIL_FUNC", "BLEND_FUNC", "STENCIL_OP", "POINT_SIZE", "LINE_WIDTH",
+  "CLEAR_COLOR_A", "COLOR_A", "CLEAR_STENCIL", "CLEAR_TAG", "STENCIL_MASK", "TAG_MASK", "BITMAP_TRANSFORM_A",
+  "BITMAP_TRANSFORM_B", "BITMAP_TRANSFORM_C", "BITMAP_TRANSFORM_D", "BITMAP_TRANSFORM_E", "BITMAP_TRANSFORM_F",
+  "SCISSOR_XY", "SCISSOR_SIZE", "CALL", "JUMP", "BEGIN", "COLOR_MASK", "END", "SAVE_CONTEXT", "RESTORE_CONTEXT",
+  "RETURN", "MACRO", "CLEAR", "VERTEXFORMAT", "BITMAP_LAYOUT_H", "BITMAP_SIZE_H", "PALETTE_SOURCE",
+  "VERTEX_TRANSLATE_X", "VERTEX_TRANSLATE_Y", "NOP", "BITMAP_EXT_FORMAT", "BITMAP_SWIZZLE"
+};
+
+static const char *const PrimNames[] = { "0", "BITMAPS", "POINTS", "LINES", "LINE_STRIP", "EDGE_STRIP_R",
+                                         "EDGE_STRIP_L", "EDGE_STRIP_A", "EDGE_STRIP_B", "RECTS" };
+#endif
+
+// The state every display list starts with (FT81x Programmers Guide 4.2)
+static const uint32_t DlDefaults[] DISASM_ROM =
+{
+  0x02000000UL,                  // CLEAR_COLOR_RGB(0, 0, 0)
+  0x04FFFFFFUL,                  // COLOR_RGB(255, 255, 255)
+  0x030000FFUL,                  // TAG(255)
+  0x05000000UL,                  // BITMAP_HANDLE(0)
+  0x06000000UL,                  // CELL(0)
+  0x09000700UL,                  // ALPHA_FUNC(ALWAYS, 0)
+  0x0A0700FFUL,                  // STENCIL_FUNC(ALWAYS, 0, 255)
+  0x0B000014UL,                  // BLEND_FUNC(SRC_ALPHA, ONE_MINUS_SRC_ALPHA)
+  0x0C000009UL,                  // STENCIL_OP(KEEP, KEEP)
+  0x0D000010UL,                  // POINT_SIZE(16)
+  0x0E000010UL,                  // LINE_WIDTH(16)
+  0x0F000000UL,                  // CLEAR_COLOR_A(0)
+  0x100000FFUL,                  // COLOR_A(255)
+  0x14000001UL,                  // TAG_MASK(1)
+  0x1B000000UL,                  // SCISSOR_XY(0, 0)
+  0x2000000FUL,                  // COLOR_MASK(1, 1, 1, 1)
+  0x27000004UL,                  // VERTEXFORMAT(4)
+};
+
+#define KNOWN(a, op)          ((a)->Known[(op) >> 5] & (1UL << ((op) & 31)))
+
+void Eve_DlAnalyzeReset(EveDlAnalyzer *a)
+{
+  uint32_t Word;
+  uint8_t n, op;
+
+  memset(a, 0, sizeof(EveDlAnalyzer));
+  for (n = 0; n < sizeof(DlDefaults) / sizeof(DlDefaults[0]); n++)
+  {
+    Word = ROM_WORD(&DlDefaults[n]);
+    op = Word >> 24;
+    a->State[op] = Word;
+    a->Known[op >> 5] |= 1UL << (op & 31);
+  }
+}
+
+static void Eve_DlForget(EveDlAnalyzer *a, uint8_t Flags)
+{
+  uint8_t op;
+
+  for (op = 0; op < EVE_DL_OPS; op++)
+    if (ROM_BYTE(&DlTable[op].Flags) & Flags)
+      a->Known[op >> 5] &= ~(1UL << (op & 31));
+}
+
+uint8_t Eve_DlAnalyze(EveDlAnalyzer *a, uint32_t Word)
+{
+  uint8_t op = Word >> 24, Result = EVE_DL_OK;
+
+  if (a->Done)
+    Result = EVE_DL_DEAD;
+  else if (Word >> 30)                                               // VERTEX2F or VERTEX2II
+  {
+    a->Vertices++;
+    a->Drawn = true;
+    a->EndedPrim = 0;
+  }
+  else if (op >= EVE_DL_OPS)
+    ;                                                                // Newer than this table
+  else if (ROM_BYTE(&DlTable[op].Flags) & DL_STATE)
+  {
+    if (KNOWN(a, op) && (a->State[op] == Word))
+      Result = EVE_DL_REDUNDANT;
+    else if (op == 5)                                                // A different BITMAP_HANDLE - its state is unknown
+      Eve_DlForget(a, DL_PERHANDLE);
+    a->State[op] = Word;
+    a->Known[op >> 5] |= 1UL << (op & 31);
+  }
+  else switch (op)
+  {
+  case 0:                                                            // DISPLAY
+    a->Done = true;
+    break;
+  case 31:                                                           // BEGIN
+    if (a->Prim == (Word & 15))
+      Result = EVE_DL_REDUNDANT;
+    else if (a->EndedPrim == (Word & 15))
+      Result = EVE_DL_REBEGIN;
+    a->Prim = Word & 15;
+    a->Drawn = false;
+    a->EndedPrim = 0;
+    break;
+  case 33:                                                           // END
+    if (!a->Prim)
+      Result = EVE_DL_REDUNDANT;
+    else if (!a->Drawn)
+      Result = EVE_DL_EMPTY;
+    a->EndedPrim = a->Prim;
+    a->Prim = 0;
+    break;
+  case 29: case 30: case 35: case 36: case 37:                       // CALL, JUMP, RESTORE_CONTEXT, RETURN, MACRO
+    Eve_DlForget(a, DL_STATE);
+    break;
+  }
+
+  a->Words++;
+  a->Findings[Result]++;
+  return (Result);
+}
+
+// Words went into the list that were not fed in (a CoProcessor widget, an APPEND), so nothing is known any more
+void Eve_DlUnknown(EveDlAnalyzer *a)
+{
+  Eve_DlForget(a, DL_STATE);
+  a->Prim = EVE_DL_ANYPRIM;
+  a->EndedPrim = 0;
+}
+
+#ifdef EVE_DISASM
+const char *Eve_DlFinding(uint8_t Finding)
+{
+  static const char *Names[] = { "", "redundant", "empty BEGIN/END", "END then BEGIN again", "after DISPLAY" };
+
+  return ((Finding < 5) ? Names[Finding] : "?");
+}
+
+// Write one display list word as the macro that makes it, e.g. "VERTEX2II(10, 20, 31, 65)".  Returns the length.
+uint8_t Eve_DlDisasm(uint32_t Word, char *Buf, uint8_t Size)
+{
+  EveDlInfo Entry;
+  const EveDlInfo *Info = &Entry;
+  uint8_t op = Word >> 24, n, Width, Shift = 0, Len;
+  int32_t Field;
+
+  if ((Word >> 30) == 2)
+    return snprintf(Buf, Size, "VERTEX2II(%u, %u, %u, %u)", (unsigned)(Word >> 21) & 511, (unsigned)(Word >> 12) & 511,
+                    (unsigned)(Word >> 7) & 31, (unsigned)Word & 127);
+  if ((Word >> 30) == 1)
+    return snprintf(Buf, Size, "VERTEX2F(%ld, %ld)", (long)((int32_t)(Word << 2) >> 17), (long)((int32_t)(Word << 17) >> 17));
+  if (op >= EVE_DL_OPS)
+    return snprintf(Buf, Size, "0x%08lx", (unsigned long)Word);
+
+  ROM_READ(&Entry, &DlTable[op], sizeof(EveDlInfo));
+  if (op == 31)
+    return snprintf(Buf, Size, "BEGIN(%s)", ((Word & 15) <= RECTS) ? PrimNames[Word & 15] : "?");
+
+  for (n = 0; (n < 5) && Info->Fields[n]; n++)                       // Total width, to find the top field
+    Shift += Info->Fields[n] & ~DL_SIGNED;
+  Len = snprintf(Buf, Size, "%s(", DlNames[op]);
+  for (n = 0; (n < 5) && Info->Fields[n] && (Len < Size); n++)
+  {
+    Width = Info->Fields[n] & ~DL_SIGNED;
+    Shift -= Width;
+    Field = (Word >> Shift) & ((1UL << Width) - 1);
+    if ((Info->Fields[n] & DL_SIGNED) && (Field & (1UL << (Width - 1))))
+      Field -= 1L << Width;
+    Len += snprintf(Buf + Len, Size - Len, n ? ", %ld" : "%ld", (long)Field);
+  }
+  if (Len < Size)
+    Len += snprintf(Buf + Len, Size - Len, ")");
+  return ((Len < Size) ? Len : Size - 1);
+}
+#endif
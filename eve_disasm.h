@@ -0,0 +1,106 @@
+#ifndef EVE_DISASM_H
+#define EVE_DISASM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// What the words going into the CoProcessor FIFO mean.  No hardware here at all, so the host tools build
+// it too.  On an AVR the tables live in flash.  The command and display list names (about 1.5K, which an Uno
+// would have to keep in RAM) and the text output that uses them are only built with EVE_DISASM defined, which
+// it is everywhere but on an AVR - uncomment it here for a debug build there.
+//#define EVE_DISASM
+#if !defined(__AVR__) && !defined(EVE_DISASM)
+#define EVE_DISASM
+#endif
+
+// What follows a command's fixed arguments
+#define EVE_TRAILER_NONE      0
+#define EVE_TRAILER_STR       1          // Zero terminated string padded to a whole word
+#define EVE_TRAILER_DATA      2          // SizeArg holds a byte count, padded to a whole word
+#define EVE_TRAILER_STREAM    3          // Data streamed in after it (CoProWrCmdBuf) - never seen by Send_CMD
+
+// What makes one of a command bigger than another, for cost tables
+#define EVE_SIZE_WORDS        0          // Words in the FIFO
+#define EVE_SIZE_STRLEN       1          // Characters
+#define EVE_SIZE_AREA         2          // w * h, from the second argument (h << 16 | w)
+#define EVE_SIZE_RADIUS       3          // r * r, from the low half of the second argument
+#define EVE_SIZE_BYTES        4          // The byte count in SizeArg
+#define EVE_SIZE_BOX          5          // Area of the box between two points in arguments 0 and 2 (CMD_GRADIENT)
+
+#define EVE_OP_DL             0xFF       // Not a command - display list words sent through the FIFO
+
+typedef struct
+{
+  uint8_t Op;                    // Low byte of the 0xFFFFFFxx command word
+  uint8_t Args;                  // Fixed argument words
+  uint8_t Trailer;               // EVE_TRAILER_...
+  uint8_t Size;                  // EVE_SIZE_...
+  uint8_t SizeArg;               // Argument holding the byte count for EVE_TRAILER_DATA and EVE_SIZE_BYTES
+} EveCmdInfo;
+
+// Follows a stream of FIFO words, one at a time, and says where each command starts
+#define EVE_PARSE_MORE        0          // Part of the command already started
+#define EVE_PARSE_START       1          // First word of a command
+#define EVE_PARSE_DL          2          // A display list word on its own
+
+typedef struct
+{
+  uint8_t Op;                    // Current command, EVE_OP_DL for a display list word
+  const EveCmdInfo *Info;        // &Entry, or 0 for display list words and commands not in the table
+  EveCmdInfo Entry;              // The table entry, out of flash
+  uint8_t Phase;
+  uint8_t Arg;                   // Arguments seen so far
+  uint32_t Args[4];              // The first few
+  uint32_t Left;                 // Trailer words still to come
+  uint16_t StrLen;
+  uint32_t Words;                // In the FIFO, opcode included
+} EveCmdParser;
+
+// Display list checks.  Feed the words of one list in order; each call says what, if anything, is wrong with
+// that word.  State is tracked from the power on defaults, so a change back to the default is caught too.
+#define EVE_DL_OK             0
+#define EVE_DL_REDUNDANT      1          // Sets state to what it already is (or an END with no BEGIN)
+#define EVE_DL_EMPTY          2          // END with no vertex since the BEGIN
+#define EVE_DL_REBEGIN        3          // BEGIN of the primitive just ENDed - the END was not needed
+#define EVE_DL_DEAD           4          // After DISPLAY, never executed
+
+#define EVE_DL_OPS            48         // Opcodes below VERTEX2F/VERTEX2II
+#define EVE_DL_ANYPRIM        0xFF       // Prim when it is not known which, if any, BEGIN is in force
+
+typedef struct
+{
+  uint32_t State[EVE_DL_OPS];    // Last word seen for each state setting opcode
+  uint32_t Known[2];             // Bit per opcode: State holds the value in force
+  uint8_t Prim;                  // BEGIN in force, 0 for none, EVE_DL_ANYPRIM if not known
+  uint8_t EndedPrim;             // Primitive of the last END, until the next vertex
+  bool Drawn;                    // A vertex since the BEGIN
+  bool Done;                     // DISPLAY seen
+  uint16_t Words;
+  uint16_t Vertices;
+  uint16_t Findings[5];          // Count of each EVE_DL_...
+} EveDlAnalyzer;
+
+void Eve_DlAnalyzeReset(EveDlAnalyzer *a);
+uint8_t Eve_DlAnalyze(EveDlAnalyzer *a, uint32_t Word);
+void Eve_DlUnknown(EveDlAnalyzer *a);
+#ifdef EVE_DISASM
+const char *Eve_DlFinding(uint8_t Finding);
+uint8_t Eve_DlDisasm(uint32_t Word, char *Buf, uint8_t Size);
+#endif
+
+bool Eve_CmdInfo(uint32_t Word, EveCmdInfo *Info);
+const char *Eve_CmdName(uint8_t Op);
+void Eve_CmdParseReset(EveCmdParser *p);
+uint8_t Eve_CmdParse(EveCmdParser *p, uint32_t Word);
+bool Eve_CmdComplete(const EveCmdParser *p);
+uint32_t Eve_CmdSize(const EveCmdParser *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+// Runtime side of indexed flash images built by tools/evepack.  All function calls are hardware ambivalent.
+//
+// FlashIndex_Open() fetches the whole index into RAM_G with one CMD_FLASHREAD (two for more than 85 entries)
+// and checks it with CMD_MEMCRC, so the index never crosses the host SPI bus in bulk.  A lookup is then a binary
+// search on the name hashes held in RAM_G - a handful of 4 byte reads - followed by one burst read of the entry.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "flash_store.h"         // Flash data access
+#include "flash_index.h"         // Every c file has it's header and this is the one for this file
+
+#define INDEX_ENTRY_ADD(n)    (IndexAdd + sizeof(FlashIndexHeader) + (uint32_t)(n) * sizeof(FlashIndexEntry))
+
+static uint32_t IndexAdd;                                            // RAM_G copy of the index
+static uint16_t IndexCount;                                          // 0 when there is no usable index
+
+// FNV-1a hash of a name.  tools/evepack has the same function - keep them matching.
+uint32_t FlashIndex_Hash(const char *name)
+{
+  uint32_t Hash = 2166136261UL;
+
+  while (*name)
+  {
+    Hash ^= (uint8_t)*name++;
+    Hash *= 16777619UL;
+  }
+  return (Hash);
+}
+
+// Copy the index from flash to RAM_G at RamAdd (which needs room for FLASHINDEX_READSIZE bytes, or the whole
+// index if it is bigger) and check it.  The flash must be attached.
+bool FlashIndex_Open(uint32_t RamAdd)
+{
+  FlashIndexHeader Hdr;
+
+  IndexCount = 0;
+  Cmd_FlashRead(RamAdd, FLASHINDEX_ADD, FLASHINDEX_READSIZE);
+  UpdateFIFO();                                                      // Trigger the CoProcessor to start processing the FIFO
+  Wait4CoProFIFOEmpty();                                             // wait here until the coprocessor has read and executed every pending command.
+
+  ReadBlockRAM(RamAdd, (uint8_t *)&Hdr, sizeof(Hdr));                // Eve and host are both little endian
+  if ((Hdr.Magic != FLASHINDEX_MAGIC) || (Hdr.Version != FLASHINDEX_VERSION))
+  {
+    Log("No flash index\n");
+    return false;
+  }
+
+  if (Hdr.Size > FLASHINDEX_READSIZE)                                // A big index - go back for the rest
+    Cmd_FlashRead(RamAdd + FLASHINDEX_READSIZE, FLASHINDEX_ADD + FLASHINDEX_READSIZE, Hdr.Size - FLASHINDEX_READSIZE);
+
+  Cmd_MemCrc(RamAdd + sizeof(Hdr), (uint32_t)Hdr.Count * sizeof(FlashIndexEntry));
+  if (CoProResult() != Hdr.Crc)
+  {
+    Log("Flash index CRC bad\n");
+    return false;
+  }
+
+  IndexAdd = RamAdd;
+  IndexCount = Hdr.Count;
+  Log("Flash index %u entries\n", IndexCount);
+  return true;
+}
+
+// Look up an asset by name.  Returns false if it is not there (or there is no index).
+bool FlashIndex_Find(const char *name, FlashIndexEntry *Entry)
+{
+  uint32_t Hash = FlashIndex_Hash(name);
+  uint16_t Lo = 0, Hi = IndexCount, Mid;
+
+  while (Lo < Hi)                                                    // Find the first entry with this hash
+  {
+    Mid = (Lo + Hi) / 2;
+    if (rd32(INDEX_ENTRY_ADD(Mid)) < Hash)
+      Lo = Mid + 1;
+    else
+      Hi = Mid;
+  }
+
+  for ( ; Lo < IndexCount; Lo++)                                    // Names can share a hash, so check the name
+  {
+    ReadBlockRAM(INDEX_ENTRY_ADD(Lo), (uint8_t *)Entry, sizeof(FlashIndexEntry));
+    if (Entry->NameHash != Hash)
+      break;
+    if (!strncmp(Entry->Name, name, FLASHINDEX_NAMELEN))
+      return true;
+  }
+  return false;
+}
+
+// Set up a bitmap handle for a bitmap in the index - straight from flash for ASTC, otherwise staged in RAM_G
+// at StageAdd.  RamUsed gets the number of RAM_G bytes used.
+bool FlashIndex_Bitmap(uint8_t Handle, const char *name, uint32_t StageAdd, uint32_t *RamUsed)
+{
+  FlashIndexEntry Entry;
+
+  if (!FlashIndex_Find(name, &Entry) || (Entry.Type != FLASHINDEX_BITMAP))
+  {
+    Log("%s not in flash\n", name);
+    return false;
+  }
+  *RamUsed = FlashStore_Bitmap(Handle, Entry.FlashAdd, Entry.Format, Entry.Width, Entry.Height, StageAdd);
+  return true;
+}
@@ -0,0 +1,66 @@
+#ifndef FLASH_INDEX_H
+#define FLASH_INDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// Indexed flash images, as built on the host by tools/evepack.
+//
+// Flash layout (addresses are offsets into the flash chip):
+//   0x0000 - 0x0FFF  BT81x blob
+//   0x1000 -         Index: a header followed by entries sorted by name hash (RAM_FLASH_POSTBLOB in Eve terms)
+//   after the index  Asset data, each entry aligned for the way Eve reads it (64 bytes at least)
+//
+// All values are little endian, like Eve.  Both structures are laid out so that no compiler pads them.
+// A flash holding one of these images is not managed by FlashStore_ProgramOnce() - it is one or the other.
+
+#define FLASHINDEX_ADD           (RAM_FLASH_POSTBLOB - RAM_FLASH)    // 0x1000
+#define FLASHINDEX_MAGIC         0x58444946UL                        // "FIDX"
+#define FLASHINDEX_VERSION       1
+#define FLASHINDEX_NAMELEN       24                                  // Including the terminating 0
+#define FLASHINDEX_READSIZE      4096UL                              // Index bytes fetched by the first read (85 entries)
+
+// Entry types
+#define FLASHINDEX_RAW           0       // Anything - copy it with CMD_FLASHREAD
+#define FLASHINDEX_BITMAP        1       // Uncompressed bitmap in Format (ASTC can be drawn straight from flash)
+#define FLASHINDEX_ZLIB          2       // zlib stream for CMD_INFLATE2 + OPT_FLASH
+#define FLASHINDEX_IMAGE         3       // JPEG or PNG for CMD_LOADIMAGE + OPT_FLASH
+#define FLASHINDEX_FONT          4       // Font metric block followed by glyphs
+#define FLASHINDEX_ANIM          5       // Animation object for CMD_ANIMSTART / CMD_ANIMFRAME
+
+typedef struct                   // 16 bytes
+{
+  uint32_t Magic;                // FLASHINDEX_MAGIC
+  uint16_t Version;              // FLASHINDEX_VERSION
+  uint16_t Count;                // Number of entries
+  uint32_t Size;                 // Bytes of header plus entries, rounded up to 64
+  uint32_t Crc;                  // CRC-32 of the entries (what CMD_MEMCRC gives)
+} FlashIndexHeader;
+
+typedef struct                   // 48 bytes
+{
+  uint32_t NameHash;             // FNV-1a hash of Name - the entries are sorted on this
+  uint32_t FlashAdd;             // Where the data starts in flash
+  uint32_t Size;                 // Bytes of data
+  uint32_t Crc;                  // CRC-32 of the data
+  uint16_t Type;                 // FLASHINDEX_RAW...
+  uint16_t Format;               // Bitmap format for FLASHINDEX_BITMAP (RGB565, COMPRESSED_RGBA_ASTC_4x4_KHR...)
+  uint16_t Width;                // Pixels, for bitmaps and images
+  uint16_t Height;
+  char Name[FLASHINDEX_NAMELEN];
+} FlashIndexEntry;
+
+uint32_t FlashIndex_Hash(const char *name);
+bool FlashIndex_Open(uint32_t RamAdd);
+bool FlashIndex_Find(const char *name, FlashIndexEntry *Entry);
+bool FlashIndex_Bitmap(uint8_t Handle, const char *name, uint32_t StageAdd, uint32_t *RamUsed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,213 @@
+// Flash asset store for BT81x (EVE3 and EVE4).  All function calls are hardware ambivalent.
+//
+// The idea is to copy the images from the SD card into the flash on the display module once, and from then
+// on have Eve fetch them herself.  CMD_FLASHREAD copies raw data into RAM_G and CMD_FLASHSOURCE + OPT_FLASH
+// lets CMD_INFLATE2 and CMD_LOADIMAGE decompress straight out of flash, so none of the image data crosses the
+// SD card or the host SPI bus at boot.
+//
+// Programming streams a file through a 4K staging block in RAM_G and CMD_FLASHUPDATE.  When programming is
+// complete a record is written to flash holding a stamp chosen by the application along with where each asset
+// went.  On the next boot the stamp matches and nothing is programmed - change the stamp when the assets change.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "flash_store.h"         // Every c file has it's header and this is the one for this file
+#include "flash_index.h"         // To recognise a packed flash image
+
+static FlashAsset *StoreAssets;                                      // The asset table in use once ready
+static uint8_t StoreCount;
+
+// Run whatever is in the FIFO and wait for it to finish
+static void FlashStore_Run(void)
+{
+  UpdateFIFO();                                                      // Trigger the CoProcessor to start processing the FIFO
+  Wait4CoProFIFOEmpty();                                             // wait here until the coprocessor has read and executed every pending command.
+}
+
+// Get the flash into full speed mode.  Returns false if there is no flash (FT81x based EVE2 modules read back
+// FLASH_STATUS_INIT here, as does a BT81x which found no flash chip).
+bool FlashStore_Init(void)
+{
+  uint8_t FlashStatus = rd8(REG_FLASH_STATUS + RAM_REG);
+
+  if (FlashStatus == FLASH_STATUS_INIT)
+  {
+    Log("No flash\n");
+    return false;
+  }
+  if (FlashStatus == FLASH_STATUS_DETACHED)
+    FlashAttach();
+  if (!FlashFast())
+  {
+    Log("Flash not in full mode\n");                               // Usually a missing blob
+    return false;
+  }
+  return true;
+}
+
+// Program one file into flash starting at FlashAdd (sector aligned).  The last sector is padded with 0xFF.
+bool FlashStore_Program(char *filename, uint32_t FlashAdd, uint32_t *Size)
+{
+  uint8_t Buf[WorkBuffSz];
+  uint32_t Remaining;
+  uint32_t Staged = 0;                                               // Bytes in the staging block
+  uint16_t ReadBlockSize;
+
+  FileOpen(filename, FILEREAD);
+  if(!myFileIsOpen())
+  {
+    Log("%s not open\n", filename);
+    FileClose();
+    return false;
+  }
+
+  Remaining = FileSize();
+  *Size = Remaining;
+  while (Remaining)
+  {
+    ReadBlockSize = (Remaining > WorkBuffSz) ? WorkBuffSz : Remaining;
+    FileReadBuf(Buf, ReadBlockSize);
+    WriteBlockRAM(FLASHSTORE_STAGING + Staged, Buf, ReadBlockSize);
+    Staged += ReadBlockSize;
+    Remaining -= ReadBlockSize;
+
+    if ((Staged == FLASHSTORE_SECTOR) || !Remaining)
+    {
+      if (Staged < FLASHSTORE_SECTOR)                                // Pad a short last sector
+        Cmd_Memset(FLASHSTORE_STAGING + Staged, 0xFF, FLASHSTORE_SECTOR - Staged);
+      Cmd_FlashUpdate(FlashAdd, FLASHSTORE_STAGING, FLASHSTORE_SECTOR);
+      FlashStore_Run();
+      FlashAdd += FLASHSTORE_SECTOR;
+      Staged = 0;
+    }
+  }
+  FileClose();
+  return true;
+}
+
+// Make sure the assets are in flash, programming them only if the record in flash does not carry Stamp.
+// Assets are placed one after another from FLASHSTORE_DATA_ADD.  On success the table is remembered so that
+// FlashStore_Find() can hand out the flash addresses.
+bool FlashStore_ProgramOnce(FlashAsset *Assets, uint8_t Count, uint32_t Stamp)
+{
+  uint32_t FlashAdd = FLASHSTORE_DATA_ADD;
+  uint32_t FlashEnd = (uint32_t)rd32(REG_FLASH_SIZE + RAM_REG) * 1024UL * 1024UL;  // REG_FLASH_SIZE is in MB
+  uint32_t Size;
+  uint8_t n;
+
+  StoreAssets = 0;
+
+  // Is the record already there?
+  Cmd_FlashRead(FLASHSTORE_STAGING, FLASHSTORE_RECORD_ADD, 8 + (uint32_t)Count * 8);
+  FlashStore_Run();
+  if (rd32(FLASHSTORE_STAGING) == FLASHINDEX_MAGIC)                  // Do not trample an image built by evepack
+  {
+    Log("Flash holds a packed image\n");
+    return false;
+  }
+  if ((rd32(FLASHSTORE_STAGING) == Stamp) && (rd32(FLASHSTORE_STAGING + 4) == Count))
+  {
+    for (n = 0; n < Count; n++)
+    {
+      Assets[n].FlashAdd = rd32(FLASHSTORE_STAGING + 8 + n * 8);
+      Assets[n].Size = rd32(FLASHSTORE_STAGING + 12 + n * 8);
+    }
+    Log("Flash assets present\n");
+  }
+  else
+  {
+    Log("Programming flash\n");
+    for (n = 0; n < Count; n++)
+    {
+      FileOpen(Assets[n].Filename, FILEREAD);                        // Check it fits before writing any of it
+      Size = myFileIsOpen() ? FileSize() : 0;
+      FileClose();
+      if (FlashAdd + Size > FlashEnd)
+      {
+        Log("Flash full\n");
+        return false;
+      }
+
+      Assets[n].FlashAdd = FlashAdd;
+      if (!FlashStore_Program(Assets[n].Filename, FlashAdd, &Assets[n].Size))
+        return false;
+      FlashAdd += (Assets[n].Size + FLASHSTORE_SECTOR - 1) & ~(FLASHSTORE_SECTOR - 1);
+    }
+
+    // Everything made it, so write the record last.  A power failure part way through leaves no record.
+    Cmd_Memset(FLASHSTORE_STAGING, 0xFF, FLASHSTORE_SECTOR);
+    FlashStore_Run();
+    wr32(FLASHSTORE_STAGING, Stamp);
+    wr32(FLASHSTORE_STAGING + 4, Count);
+    for (n = 0; n < Count; n++)
+    {
+      wr32(FLASHSTORE_STAGING + 8 + n * 8, Assets[n].FlashAdd);
+      wr32(FLASHSTORE_STAGING + 12 + n * 8, Assets[n].Size);
+    }
+    Cmd_FlashUpdate(FLASHSTORE_RECORD_ADD, FLASHSTORE_STAGING, FLASHSTORE_SECTOR);
+    FlashStore_Run();
+    Log("Flash programmed\n");
+  }
+
+  StoreAssets = Assets;
+  StoreCount = Count;
+  return true;
+}
+
+// Look up an asset by file name.  Returns 0 when the flash store is not in use or does not hold the file.
+FlashAsset *FlashStore_Find(char *filename)
+{
+  uint8_t n;
+
+  for (n = 0; (n < StoreCount) && StoreAssets; n++)
+  {
+    if (!strcmp(StoreAssets[n].Filename, filename))
+      return (&StoreAssets[n]);
+  }
+  return 0;
+}
+
+// Copy raw data from flash into RAM_G.  Returns the next available RAM_G address like Load_RAW().
+// The copy is rounded up to a multiple of 4 bytes, so up to 3 bytes past the end are overwritten.
+uint32_t FlashStore_Read(uint32_t RamAdd, uint32_t FlashAdd, uint32_t Size)
+{
+  Cmd_FlashRead(RamAdd, FlashAdd, (Size + 3) & ~3UL);
+  FlashStore_Run();
+  return (RamAdd + Size);
+}
+
+// Inflate zlib data stored in flash into RAM_G.  Returns the end address like Load_ZLIB().
+uint32_t FlashStore_Inflate(uint32_t RamAdd, uint32_t FlashAdd)
+{
+  Cmd_FlashSource(FlashAdd);
+  Cmd_Inflate2(RamAdd, OPT_FLASH);
+  return (CoProGetPtr());
+}
+
+// Decode a JPEG or PNG stored in flash into RAM_G.  Returns the end address like Load_JPG().
+uint32_t FlashStore_LoadImage(uint32_t RamAdd, uint32_t FlashAdd, uint32_t Options)
+{
+  Cmd_FlashSource(FlashAdd);
+  Cmd_LoadImage(RamAdd, Options | OPT_FLASH);
+  return (CoProGetPtr());
+}
+
+// Set up a bitmap handle for an image stored (uncompressed) in flash.  BT81x can only draw ASTC formats
+// straight from flash, and only when the flash is in full speed mode with the data on a 32 byte boundary.
+// Those cost no RAM_G and no upload time at all.  Anything else is copied into RAM_G at StageAdd first.
+// Returns the number of bytes of RAM_G used, which is 0 for an image drawn from flash.
+uint32_t FlashStore_Bitmap(uint8_t Handle, uint32_t FlashAdd, uint16_t fmt, uint16_t width, uint16_t height, uint32_t StageAdd)
+{
+  uint32_t Size = Bitmap_Stride(fmt, width) * Bitmap_Lines(fmt, height);
+
+  if (IS_ASTC(fmt) && !(FlashAdd & 31) && (rd8(REG_FLASH_STATUS + RAM_REG) == FLASH_STATUS_FULL))
+  {
+    Bitmap_Setup(Handle, FLASH_BITMAP_ADDR(FlashAdd), fmt, width, height);
+    return 0;
+  }
+
+  FlashStore_Read(StageAdd, FlashAdd, Size);                         // Staged in RAM_G
+  Bitmap_Setup(Handle, StageAdd, fmt, width, height);
+  return (Size);
+}
@@ -0,0 +1,43 @@
+#ifndef FLASH_STORE_H
+#define FLASH_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// Flash layout (addresses are offsets into the flash chip, not the RAM_FLASH view):
+//   0x0000 - 0x0FFF  BT81x blob, needed for full speed mode.  Put there by EVE Asset Builder or the factory.
+//   0x1000 - 0x1FFF  Record of what has been programmed (stamp, asset count, address and size of each asset)
+//   0x2000 -         Assets, each starting on a 4K sector boundary
+// A flash image built with tools/evepack has its index where the record goes (see flash_index.h), so a flash
+// is managed either by this or by an image, not both.
+#define FLASHSTORE_RECORD_ADD     0x1000UL
+#define FLASHSTORE_DATA_ADD       0x2000UL
+#define FLASHSTORE_SECTOR         4096UL                             // CMD_FLASHUPDATE works in whole sectors
+#define FLASHSTORE_STAGING        RAM_G_WORKING                      // 4K of RAM_G borrowed while programming
+
+// One asset.  The application fills in Filename, FlashStore_ProgramOnce() fills in the rest.
+typedef struct
+{
+  char *Filename;                // Source file on the SD card, and the name the loaders look for
+  uint32_t FlashAdd;             // Where it lives in flash
+  uint32_t Size;                 // Size in bytes
+} FlashAsset;
+
+bool FlashStore_Init(void);
+bool FlashStore_ProgramOnce(FlashAsset *Assets, uint8_t Count, uint32_t Stamp);
+bool FlashStore_Program(char *filename, uint32_t FlashAdd, uint32_t *Size);
+FlashAsset *FlashStore_Find(char *filename);
+uint32_t FlashStore_Read(uint32_t RamAdd, uint32_t FlashAdd, uint32_t Size);
+uint32_t FlashStore_Inflate(uint32_t RamAdd, uint32_t FlashAdd);
+uint32_t FlashStore_LoadImage(uint32_t RamAdd, uint32_t FlashAdd, uint32_t Options);
+uint32_t FlashStore_Bitmap(uint8_t Handle, uint32_t FlashAdd, uint16_t fmt, uint16_t width, uint16_t height, uint32_t StageAdd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,366 @@
+// Custom fonts, with only the glyphs in use kept in RAM_G.  All function calls are hardware ambivalent.
+//
+// A legacy Eve font is a metric block (the width of each of 128 characters, then format, stride, size and a
+// pointer) and a glyph bitmap per character, which for a large L4 font adds up to hundreds of KB of RAM_G.
+// Most screens use a few dozen characters of it.  So instead of the real font, Eve is given one of up to
+// FONT_MAX_SLOTS glyphs, and strings are translated on the way out: each character gets a slot (its glyph is
+// loaded into the slot the first time) and Cmd_Text() is sent the slot numbers in place of the characters.
+// Our metric block carries the width of the character in each slot.
+//
+// When the slots are all taken a glyph which has not been drawn on this screen or the one before is evicted,
+// the least recently used first.  The screen before is spared because its display list is still being shown
+// while the new one is built.  Font_Screen() marks the start of each screen (SelectScreen() calls it).
+//
+// The font file is what EVE Asset Builder calls a legacy font: the 148 byte metric block followed by the glyph
+// of each character from the first with a width, L1, L2, L4 or L8.  It is read from the module flash when it is
+// there (the flash index or the flash store) and from the SD card when it is not.  Glyph load time and the RAM_G
+// holding the glyphs are recorded per screen.  Glyphs from flash are copied by Eve, so for those the time here is
+// only the queueing and the copy itself shows up in the Perf copro phase.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "font.h"                // Every c file has it's header and this is the one for this file
+#include "flash_index.h"         // Fonts packed into a flash image
+#include "flash_store.h"         // Fonts copied into flash from the SD card
+#include "perf.h"                // Screen transition timing
+
+static EveFont *Fonts[FONT_MAX_FONTS];
+static FontScreen Screens[FONT_SCREENS];
+static uint8_t CurID = FONT_SCREENS;                                 // Not counted until Font_Screen()
+static uint16_t Generation = 2;                                      // Free slots look two screens old
+static uint16_t VisitLoaded;
+static uint32_t VisitUs;
+
+static uint32_t Le32(const uint8_t *p)
+{
+  return (p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+// Empty the cache, leaving our metric block with no widths and the pointer set so that slot 1 is GlyphAdd
+void Font_Flush(EveFont *Font)
+{
+  memset(Font->SlotOf, 0, sizeof(Font->SlotOf));
+  memset(Font->CharOf, 0, sizeof(Font->CharOf));
+  memset(Font->LastUsed, 0, sizeof(Font->LastUsed));
+  Cmd_Memset(Font->MetricAdd, 0, 128);
+  UpdateFIFO();
+  Wait4CoProFIFOEmpty();
+  wr32(Font->MetricAdd + 128, Font->Format);
+  wr32(Font->MetricAdd + 132, Font->Stride);
+  wr32(Font->MetricAdd + 136, Font->Width);
+  wr32(Font->MetricAdd + 140, Font->Height);
+  wr32(Font->MetricAdd + 144, Font->GlyphAdd - Font->GlyphSize);    // Character (slot) 0 would be just below slot 1
+}
+
+// Get a font ready, taking 148 + Slots * glyph size bytes of RAM_G at RamAdd (a multiple of 4).  Nothing but
+// the metric block is read now.  Returns false if the font can not be read or is not a legacy font.
+bool Font_Load(EveFont *Font, char *filename, uint8_t Handle, uint32_t RamAdd, uint8_t Slots)
+{
+  FlashIndexEntry Entry;
+  FlashAsset *Asset;
+  uint8_t Tail[FONT_METRIC_SIZE - 128];
+  uint8_t n;
+
+  memset(Font, 0, sizeof(EveFont));
+  Font->Filename = filename;
+  Font->Handle = Handle;
+  if (FlashIndex_Find(filename, &Entry))
+  {
+    Font->Source = FONT_SRC_FLASH;
+    Font->FlashAdd = Entry.FlashAdd;
+  }
+  else if ((Asset = FlashStore_Find(filename)) != 0)
+  {
+    Font->Source = FONT_SRC_FLASH;
+    Font->FlashAdd = Asset->FlashAdd;
+  }
+
+  if (Font->Source == FONT_SRC_FLASH)
+  {
+    Cmd_FlashRead(FONT_STAGING, Font->FlashAdd, FONT_METRIC_SIZE);
+    UpdateFIFO();
+    Wait4CoProFIFOEmpty();
+    ReadBlockRAM(FONT_STAGING, Font->Widths, 128);
+    ReadBlockRAM(FONT_STAGING + 128, Tail, sizeof(Tail));
+  }
+  else
+  {
+    FileOpen(filename, FILEREAD);
+    if (!myFileIsOpen())
+    {
+      Log("%s not open\n", filename);
+      FileClose();
+      return false;
+    }
+    FileReadBuf(Font->Widths, 128);
+    FileReadBuf(Tail, sizeof(Tail));
+    FileClose();
+  }
+
+  Font->Format = Le32(&Tail[0]);
+  Font->Stride = Le32(&Tail[4]);
+  Font->Width = Le32(&Tail[8]);
+  Font->Height = Le32(&Tail[12]);
+  Font->GlyphSize = (uint32_t)Font->Stride * Font->Height;
+  for (n = 0; (n < 128) && !Font->Widths[n]; n++)
+    ;
+  Font->FirstChar = n;
+  if (((Font->Format != L1) && (Font->Format != L2) && (Font->Format != L4) && (Font->Format != L8)) ||
+      !Font->GlyphSize || (n == 128) || (Font->GlyphSize > 4096 - 64 - 4))
+  {
+    Log("%s is not a font\n", filename);
+    return false;
+  }
+
+  if (Slots > FONT_MAX_SLOTS)
+    Slots = FONT_MAX_SLOTS;
+  Font->Slots = Slots;
+  Font->MetricAdd = RamAdd;
+  Font->GlyphAdd = RamAdd + FONT_METRIC_SIZE;
+  Font->RamSize = FONT_METRIC_SIZE + (uint32_t)Slots * Font->GlyphSize;
+  Font_Flush(Font);
+  Cmd_SetFont(Handle, RamAdd);
+
+  for (n = 0; n < FONT_MAX_FONTS; n++)                               // Remember it for the statistics
+  {
+    if (!Fonts[n] || (Fonts[n] == Font))
+    {
+      Fonts[n] = Font;
+      break;
+    }
+  }
+  return true;
+}
+
+// Count what the screen now ending holds
+static void Font_Tally(void)
+{
+  FontScreen *s = &Screens[CurID];
+  uint8_t n, Slot;
+
+  if (CurID >= FONT_SCREENS)
+    return;
+  s->Resident = 0;
+  s->GlyphBytes = 0;
+  for (n = 0; (n < FONT_MAX_FONTS) && Fonts[n]; n++)
+  {
+    for (Slot = 1; Slot <= Fonts[n]->Slots; Slot++)
+    {
+      if (Fonts[n]->CharOf[Slot] && (Fonts[n]->LastUsed[Slot] == Generation))
+      {
+        s->Resident++;
+        s->GlyphBytes += Fonts[n]->GlyphSize;
+      }
+    }
+  }
+  s->Loaded = VisitLoaded;
+}
+
+// A new screen is starting
+void Font_Screen(uint8_t ID)
+{
+  Font_Tally();
+  Generation++;
+  CurID = ID;
+  VisitLoaded = 0;
+  VisitUs = 0;
+  if (CurID < FONT_SCREENS)
+    Screens[CurID].Visits++;
+}
+
+// Set up the bitmap handle for the font.  Once in each display list that uses it, before Font_Text().
+void Font_Use(EveFont *Font)
+{
+  Send_CMD(BITMAP_HANDLE(Font->Handle));
+  Send_CMD(BITMAP_SOURCE(Font->GlyphAdd - Font->GlyphSize));
+  Send_CMD(BITMAP_LAYOUT(Font->Format, Font->Stride, Font->Height));
+  Send_CMD(BITMAP_LAYOUT_H(Font->Stride, Font->Height));
+  Send_CMD(BITMAP_SIZE(NEAREST, BORDER, BORDER, Font->Width, Font->Height));
+  Send_CMD(BITMAP_SIZE_H(Font->Width, Font->Height));
+}
+
+// A slot for a new glyph: a free one, or else the least recently used not drawn on this screen or the last.
+// 0 if there is none.
+static uint8_t Font_Slot(EveFont *Font)
+{
+  uint8_t Slot, Best = 0;
+
+  for (Slot = 1; Slot <= Font->Slots; Slot++)
+  {
+    if (!Font->CharOf[Slot])
+      return (Slot);
+    if (((uint16_t)(Generation - Font->LastUsed[Slot]) > 1) &&
+        (!Best || ((uint16_t)(Generation - Font->LastUsed[Slot]) > (uint16_t)(Generation - Font->LastUsed[Best]))))
+      Best = Slot;
+  }
+  if (Best)
+  {
+    Font->SlotOf[Font->CharOf[Best]] = 0;
+    if (CurID < FONT_SCREENS)
+      Screens[CurID].Evicted++;
+  }
+  return (Best);
+}
+
+// Put the glyphs for the characters now in Slots into them.  If they can not be read the slots are given up
+// again and false is returned.
+static bool Font_Fetch(EveFont *Font, const uint8_t *Slots, uint8_t Count)
+{
+  uint8_t Buf[WorkBuffSz];
+  uint32_t Start = HAL_Micros(), Src, Dest, Done, Size, Us;
+  uint8_t n, c;
+
+  if (Font->Source == FONT_SRC_FILE)
+  {
+    FileOpen(Font->Filename, FILEREAD);
+    if (!myFileIsOpen())
+    {
+      Log("%s not open\n", Font->Filename);
+      FileClose();
+      for (n = 0; n < Count; n++)
+      {
+        Font->SlotOf[Font->CharOf[Slots[n]]] = 0;
+        Font->CharOf[Slots[n]] = 0;
+      }
+      return false;
+    }
+  }
+
+  for (n = 0; n < Count; n++)
+  {
+    c = Font->CharOf[Slots[n]];
+    Src = FONT_METRIC_SIZE + (uint32_t)(c - Font->FirstChar) * Font->GlyphSize;
+    Dest = Font->GlyphAdd + (uint32_t)(Slots[n] - 1) * Font->GlyphSize;
+    if (Font->Source == FONT_SRC_FLASH)                              // CMD_FLASHREAD wants a 64 byte aligned source
+    {
+      Src += Font->FlashAdd;
+      Cmd_FlashRead(FONT_STAGING, Src & ~63UL, ((Src & 63) + Font->GlyphSize + 3) & ~3UL);
+      Cmd_Memcpy(Dest, FONT_STAGING + (Src & 63), Font->GlyphSize);
+    }
+    else
+    {
+      FileSeek(Src);
+      for (Done = 0; Done < Font->GlyphSize; Done += Size)
+      {
+        Size = Font->GlyphSize - Done;
+        if (Size > WorkBuffSz)
+          Size = WorkBuffSz;
+        FileReadBuf(Buf, Size);
+        WriteBlockRAM(Dest + Done, Buf, Size);
+      }
+    }
+    wr8(Font->MetricAdd + Slots[n], Font->Widths[c]);
+  }
+
+  if (Font->Source == FONT_SRC_FILE)
+    FileClose();
+  Us = HAL_Micros() - Start;
+  VisitLoaded += Count;
+  VisitUs += Us;
+  Perf_AddUpload(Us);
+  if (CurID < FONT_SCREENS)
+  {
+    Screens[CurID].LoadUsTotal += Us;
+    if (VisitUs > Screens[CurID].LoadUsMax)
+      Screens[CurID].LoadUsMax = VisitUs;
+  }
+  return true;
+}
+
+// Translate up to Len characters of str into slots, loading any glyphs which are not resident.  Characters
+// which are not in the font are left out.  Returns the number of slots in Mapped (which is not terminated), or
+// 0 if the glyphs could not be loaded.
+uint8_t Font_Map(EveFont *Font, const char *str, uint8_t Len, char *Mapped)
+{
+  uint8_t Load[FONT_TEXT_MAX];
+  uint8_t n = 0, Loads = 0, c, Slot;
+
+  if (Len > FONT_TEXT_MAX)
+    Len = FONT_TEXT_MAX;
+  for ( ; Len && *str; str++, Len--)                                 // str need not be terminated after Len
+  {
+    c = (uint8_t)*str;
+    if ((c >= 128) || !Font->Widths[c])
+      continue;
+    Slot = Font->SlotOf[c];
+    if (!Slot)
+    {
+      Slot = Font_Slot(Font);
+      if (!Slot)
+      {
+        Log("%s: too many glyphs\n", Font->Filename);                // Raise Slots
+        break;
+      }
+      Font->SlotOf[c] = Slot;
+      Font->CharOf[Slot] = c;
+      Load[Loads++] = Slot;
+    }
+    Font->LastUsed[Slot] = Generation;
+    Mapped[n++] = Slot;
+  }
+
+  if (Loads && !Font_Fetch(Font, Load, Loads))
+    return 0;
+  return (n);
+}
+
+// Cmd_Text() in a custom font
+void Font_Text(EveFont *Font, int16_t x, int16_t y, uint16_t options, const char *str)
+{
+  char Mapped[FONT_TEXT_MAX + 1];
+
+  Mapped[Font_Map(Font, str, FONT_TEXT_MAX, Mapped)] = 0;
+  Cmd_Text(x, y, Font->Handle, options, Mapped);
+}
+
+// Eve has been reset (power down) and lost every font.  Give them back their metric blocks and handles, with
+// every slot empty - the glyphs load again as they are drawn.
+void Font_Restore(void)
+{
+  uint8_t n;
+
+  for (n = 0; (n < FONT_MAX_FONTS) && Fonts[n]; n++)
+  {
+    Font_Flush(Fonts[n]);
+    Cmd_SetFont(Fonts[n]->Handle, Fonts[n]->MetricAdd);
+  }
+}
+
+// The loaded font with this handle, or 0
+EveFont *Font_Find(uint8_t Handle)
+{
+  uint8_t n;
+
+  for (n = 0; (n < FONT_MAX_FONTS) && Fonts[n]; n++)
+  {
+    if (Fonts[n]->Handle == Handle)
+      return (Fonts[n]);
+  }
+  return 0;
+}
+
+const FontScreen *Font_Get(uint8_t ID)
+{
+  Font_Tally();                                                      // Bring the current screen up to date
+  return ((ID < FONT_SCREENS) ? &Screens[ID] : 0);
+}
+
+void Font_LogStats(void)
+{
+  FontScreen *s;
+  uint8_t n;
+
+  Font_Tally();
+  for (n = 0; (n < FONT_MAX_FONTS) && Fonts[n]; n++)
+    Log("%s: %lu bytes, %lu whole\n", Fonts[n]->Filename, Fonts[n]->RamSize,
+        FONT_METRIC_SIZE + (128UL - Fonts[n]->FirstChar) * Fonts[n]->GlyphSize);
+  for (n = 0; n < FONT_SCREENS; n++)
+  {
+    s = &Screens[n];
+    if (!s->Visits)
+      continue;
+    Log("Screen %u: %u glyphs %lu bytes\n", n, s->Resident, s->GlyphBytes);
+    Log(" load %lu/%lu us, %u evicted\n", s->LoadUsTotal / s->Visits, s->LoadUsMax, s->Evicted);
+  }
+}
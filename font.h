@@ -0,0 +1,75 @@
+#ifndef FONT_H
+#define FONT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// Custom fonts with only the glyphs in use resident in RAM_G.  See font.c.
+#ifndef FONT_MAX_SLOTS
+#define FONT_MAX_SLOTS        96                                     // Glyphs resident per font at most (127 is the limit)
+#endif
+#define FONT_MAX_FONTS        4
+#ifndef FONT_SCREENS
+#define FONT_SCREENS          8                                      // Screens with statistics (IDs at or above are not counted)
+#endif
+#define FONT_TEXT_MAX         63                                     // Longest string for Font_Text()
+#define FONT_METRIC_SIZE      148                                    // Widths, format, stride, width, height, pointer
+#define FONT_STAGING          RAM_G_WORKING                          // For glyphs copied out of flash
+
+// Where the glyphs come from
+#define FONT_SRC_FILE         0
+#define FONT_SRC_FLASH        1
+
+typedef struct
+{
+  char *Filename;                // Metric block followed by the glyphs from the first character with a width
+  uint8_t Handle;                // Font and bitmap handle number, 0 - 14
+  uint8_t Source;                // FONT_SRC_...
+  uint32_t FlashAdd;             // Of the file, when it is in flash
+  uint32_t MetricAdd;            // RAM_G: our metric block, then the glyph slots
+  uint32_t GlyphAdd;             // RAM_G address of slot 1
+  uint32_t RamSize;              // RAM_G taken altogether
+  uint16_t Format;               // L1, L2, L4 or L8
+  uint16_t Stride;
+  uint16_t Width;
+  uint16_t Height;
+  uint32_t GlyphSize;            // Stride * Height
+  uint8_t FirstChar;
+  uint8_t Slots;                 // Glyphs resident at most
+  uint8_t Widths[128];           // From the file, by character
+  uint8_t SlotOf[128];           // By character, 0 when not resident
+  uint8_t CharOf[FONT_MAX_SLOTS + 1];  // By slot, 0 when free
+  uint16_t LastUsed[FONT_MAX_SLOTS + 1];  // Screen generation each slot was last drawn in
+} EveFont;
+
+typedef struct
+{
+  uint16_t Visits;
+  uint16_t Loaded;               // Glyphs loaded on the last visit
+  uint16_t Evicted;
+  uint16_t Resident;             // Glyphs drawn on the last visit
+  uint32_t GlyphBytes;           // RAM_G holding them
+  uint32_t LoadUsTotal;          // Divide by Visits for the average
+  uint32_t LoadUsMax;
+} FontScreen;
+
+bool Font_Load(EveFont *Font, char *filename, uint8_t Handle, uint32_t RamAdd, uint8_t Slots);
+void Font_Screen(uint8_t ID);
+void Font_Use(EveFont *Font);
+uint8_t Font_Map(EveFont *Font, const char *str, uint8_t Len, char *Mapped);
+void Font_Text(EveFont *Font, int16_t x, int16_t y, uint16_t options, const char *str);
+EveFont *Font_Find(uint8_t Handle);
+void Font_Flush(EveFont *Font);
+void Font_Restore(void);
+const FontScreen *Font_Get(uint8_t ID);
+void Font_LogStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
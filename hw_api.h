@@ -25,6 +25,12 @@ void HAL_SPI_ReadBuffer(uint8_t *Buffer, uint32_t Length);
 /* Stall the cpu for X milliseconds */
 void HAL_Delay(uint32_t milliSeconds);
 
+/* Free running millisecond counter (wraps at 2^32) */
+uint32_t HAL_Millis(void);
+
+/* Free running microsecond counter (wraps at 2^32) - for measuring how long things take */
+uint32_t HAL_Micros(void);
+
 /* Gives an opertunity to reset the EVE hardware */
 void HAL_Eve_Reset_HW(void);
 
@@ -0,0 +1,225 @@
+// Input events from the touch tag and the hardware keys.  All function calls are hardware ambivalent.
+//
+// Each source puts timestamped events into its own fixed size ring, and the main loop takes them out in a
+// batch with Input_GetEvents(), oldest first.  A ring has exactly one writer and one reader and each index is
+// only written by one of them, so no locking is needed even when the writer is an interrupt - as long as the
+// index fits in a single byte write, which it does on every processor we use.  A compiler barrier keeps the
+// event and its index in order on both sides, and each ring counts its own dropped events for the same reason.
+//
+// Sources:
+// - Keys: Input_PollKeys() debounces the key pins and generates down, repeat and up.  Input_Poll() calls it from
+//   the main loop, unless Input_Init() was told it is called from a timer interrupt every millisecond or so (to
+//   catch short presses while the main loop is busy) - the ring has one writer, so it must not be both.
+// - Tag: Input_PollTag() reads REG_TOUCH_TAG and reports changes.  This needs the SPI bus, so it is always
+//   called from the main loop.  Without the interrupt it samples every INPUT_TAG_POLL_MS.  With the interrupt,
+//   call Input_TagIrq() from the Eve INT_N pin interrupt and the tag is only read when Eve says it changed,
+//   timestamped with when she said so.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "input.h"               // Every c file has it's header and this is the one for this file
+
+typedef struct
+{
+  InputEvent Events[INPUT_RING_SIZE];
+  volatile uint8_t Head;                                             // Written only by the source
+  volatile uint8_t Tail;                                             // Written only by Input_GetEvents()
+  volatile uint16_t Dropped;                                         // Written only by the source
+} InputRing;
+
+#define INPUT_BARRIER()       __asm__ volatile("" ::: "memory")      // No memory access moves across this
+
+typedef struct
+{
+  uint8_t Stable;                                                    // Debounced state, 1 = down
+  uint8_t Raw;                                                       // Last reading
+  uint32_t Changed;                                                  // HAL_Millis() when Raw last changed
+  uint32_t NextRepeat;
+} InputKey;
+
+static const uint8_t KeyPins[INPUT_KEYS] = { Button1_PIN, Button2_PIN, Button3_PIN };
+
+static InputRing KeyRing, TagRing;
+static InputKey Keys[INPUT_KEYS];
+static InputStats Stats;
+static uint8_t LastTag;
+static uint32_t NextTagPoll;
+static bool UseTagIrq;
+static bool UseKeyTimer;
+static volatile bool TagIrqSeen;
+static volatile uint32_t TagIrqTime;
+static bool TagPaused;                                               // Eve is asleep, leave her be
+
+// Source side - only ever called from one place per ring
+static void Input_Put(InputRing *Ring, uint8_t Type, uint8_t Code, uint32_t Time)
+{
+  uint8_t Head = Ring->Head;
+
+  if ((uint8_t)(Head - Ring->Tail) == INPUT_RING_SIZE)
+  {
+    Ring->Dropped++;
+    return;
+  }
+  INPUT_BARRIER();                                                   // The slot is not written before it is free
+  Ring->Events[Head % INPUT_RING_SIZE].Type = Type;
+  Ring->Events[Head % INPUT_RING_SIZE].Code = Code;
+  Ring->Events[Head % INPUT_RING_SIZE].Time = Time;
+  INPUT_BARRIER();
+  Ring->Head = Head + 1;                                             // Publish only once the event is complete
+}
+
+// Set up the sources.  TagIrq chooses whether the tag is read on Eve's interrupt or by polling, KeyTimer whether
+// the keys are polled from a timer interrupt or by Input_Poll().
+void Input_Init(bool TagIrq, bool KeyTimer)
+{
+  memset(Keys, 0, sizeof(Keys));
+  memset(&Stats, 0, sizeof(Stats));
+  KeyRing.Head = KeyRing.Tail = 0;
+  TagRing.Head = TagRing.Tail = 0;
+  KeyRing.Dropped = TagRing.Dropped = 0;
+  LastTag = 0;
+  NextTagPoll = HAL_Millis();
+  UseTagIrq = TagIrq;
+  UseKeyTimer = KeyTimer;
+  TagIrqSeen = false;
+
+  if (TagIrq)
+  {
+    wr8(REG_INT_MASK + RAM_REG, INT_TAG);                            // Only the tag changing pulls INT_N low
+    rd8(REG_INT_FLAGS + RAM_REG);                                    // Reading clears anything already pending
+    wr8(REG_INT_EN + RAM_REG, 1);
+  }
+}
+
+// Debounce the keys.  May be called from a timer interrupt.
+void Input_PollKeys(void)
+{
+  uint32_t Now = HAL_Millis();
+  uint8_t n, Raw;
+
+  for (n = 0; n < INPUT_KEYS; n++)
+  {
+    Raw = !ReadPin(KeyPins[n]);                                      // The keys pull the pin low
+    if (Raw != Keys[n].Raw)
+    {
+      Keys[n].Raw = Raw;
+      Keys[n].Changed = Now;
+    }
+    else if ((Raw != Keys[n].Stable) && ((Now - Keys[n].Changed) >= INPUT_DEBOUNCE_MS))
+    {
+      Keys[n].Stable = Raw;
+      Input_Put(&KeyRing, Raw ? INPUT_KEY_DOWN : INPUT_KEY_UP, n + 1, HAL_Micros());
+      Keys[n].NextRepeat = Now + INPUT_REPEAT_DELAY_MS;
+    }
+    else if (Keys[n].Stable && ((int32_t)(Now - Keys[n].NextRepeat) >= 0))
+    {
+      Input_Put(&KeyRing, INPUT_KEY_REPEAT, n + 1, HAL_Micros());
+      Keys[n].NextRepeat += INPUT_REPEAT_MS;
+    }
+  }
+}
+
+// Call from the interrupt on Eve's INT_N pin
+void Input_TagIrq(void)
+{
+  TagIrqTime = HAL_Micros();
+  TagIrqSeen = true;
+}
+
+// Look for tag changes.  Main loop only - it uses the SPI bus.
+void Input_PollTag(void)
+{
+  uint32_t Time;
+  uint8_t Tag;
+
+  if (TagPaused)
+    return;
+  if (UseTagIrq)
+  {
+    if (!TagIrqSeen)
+      return;
+    TagIrqSeen = false;
+    Time = TagIrqTime;
+    rd8(REG_INT_FLAGS + RAM_REG);                                    // Clear it so INT_N goes high again
+  }
+  else
+  {
+    if ((int32_t)(HAL_Millis() - NextTagPoll) < 0)
+      return;
+    NextTagPoll = HAL_Millis() + INPUT_TAG_POLL_MS;
+    Time = HAL_Micros();
+  }
+
+  Tag = rd8(REG_TOUCH_TAG + RAM_REG);
+  if (Tag == LastTag)
+    return;
+  if (LastTag)                                                       // Sliding from one tag to another is up then down
+    Input_Put(&TagRing, INPUT_TAG_UP, LastTag, Time);
+  if (Tag)
+    Input_Put(&TagRing, INPUT_TAG_DOWN, Tag, Time);
+  LastTag = Tag;
+}
+
+// Stop (and restart) reading the tag.  Any read wakes Eve from standby or sleep, so the power manager stops the
+// tag while she is down - the keys carry on as normal.
+void Input_TagPause(bool Paused)
+{
+  TagPaused = Paused;
+  LastTag = 0;
+}
+
+// Poll everything from the main loop
+void Input_Poll(void)
+{
+  if (!UseKeyTimer)
+    Input_PollKeys();
+  Input_PollTag();
+}
+
+// Take up to Max events, oldest first across both sources.  Returns how many.
+uint8_t Input_GetEvents(InputEvent *Events, uint8_t Max)
+{
+  uint32_t Now = HAL_Micros(), Latency;
+  uint8_t Count = 0;
+  InputRing *Ring;
+  bool KeysWaiting, TagsWaiting;
+
+  while (Count < Max)
+  {
+    KeysWaiting = (KeyRing.Head != KeyRing.Tail);
+    TagsWaiting = (TagRing.Head != TagRing.Tail);
+    if (!KeysWaiting && !TagsWaiting)
+      break;
+    INPUT_BARRIER();                                                 // The events are not read before their index
+    if (KeysWaiting && TagsWaiting)                                // Both waiting - take the older
+      Ring = ((int32_t)(KeyRing.Events[KeyRing.Tail % INPUT_RING_SIZE].Time - TagRing.Events[TagRing.Tail % INPUT_RING_SIZE].Time) <= 0) ? &KeyRing : &TagRing;
+    else
+      Ring = KeysWaiting ? &KeyRing : &TagRing;
+
+    Events[Count] = Ring->Events[Ring->Tail % INPUT_RING_SIZE];
+    INPUT_BARRIER();
+    Ring->Tail = Ring->Tail + 1;                                     // Slot free for the source again
+
+    Latency = Now - Events[Count].Time;
+    Stats.Events++;
+    Stats.LatencyUsTotal += Latency;
+    if (Latency > Stats.LatencyUsMax)
+      Stats.LatencyUsMax = Latency;
+    Count++;
+  }
+  return (Count);
+}
+
+InputStats *Input_GetStats(void)
+{
+  Stats.Dropped = KeyRing.Dropped + TagRing.Dropped;
+  return (&Stats);
+}
+
+void Input_LogStats(void)
+{
+  Stats.Dropped = KeyRing.Dropped + TagRing.Dropped;
+  Log("Input %lu events, %u dropped\n", Stats.Events, Stats.Dropped);
+  Log("%lu us avg, %lu us max\n", Stats.Events ? Stats.LatencyUsTotal / Stats.Events : 0, Stats.LatencyUsMax);
+}
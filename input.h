@@ -0,0 +1,55 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+#define INPUT_RING_SIZE       16                                     // Events per source ring - a power of 2
+#define INPUT_KEYS            3                                      // Hardware keys
+#define INPUT_DEBOUNCE_MS     20                                     // A key must read the same this long to count
+#define INPUT_REPEAT_DELAY_MS 500                                    // Held this long before it starts repeating
+#define INPUT_REPEAT_MS       150                                    // Then one repeat every this long
+#define INPUT_TAG_POLL_MS     10                                     // Tag sample period when not using the interrupt
+
+// Event types
+#define INPUT_TAG_DOWN        1                                      // Code is the tag
+#define INPUT_TAG_UP          2
+#define INPUT_KEY_DOWN        3                                      // Code is the key, 1 - INPUT_KEYS
+#define INPUT_KEY_UP          4
+#define INPUT_KEY_REPEAT      5
+
+typedef struct
+{
+  uint8_t Type;
+  uint8_t Code;
+  uint32_t Time;                 // HAL_Micros() when the input was seen
+} InputEvent;
+
+// Time from an input being seen to Input_GetEvents() handing it over
+typedef struct
+{
+  uint32_t Events;
+  uint32_t LatencyUsMax;
+  uint32_t LatencyUsTotal;       // Divide by Events for the average
+  uint16_t Dropped;              // Lost because a ring was full
+} InputStats;
+
+void Input_Init(bool TagIrq, bool KeyTimer);
+void Input_PollKeys(void);
+void Input_PollTag(void);
+void Input_TagIrq(void);
+void Input_TagPause(bool Paused);
+void Input_Poll(void);
+uint8_t Input_GetEvents(InputEvent *Events, uint8_t Max);
+InputStats *Input_GetStats(void);
+void Input_LogStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
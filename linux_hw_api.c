@@ -0,0 +1,152 @@
+// The hardware abstraction for Linux hosts driving Eve through spidev.
+//
+// Every call works on the panel of the context bound on the calling thread (EveCurrent->Hal), so with the
+// library built with EVE_THREADS each panel can be driven from a thread of its own and the transfers to
+// different panels go on side by side.  Nothing here is shared between panels.
+//
+// Eve wants an address and then the data inside one chip select.  spidev only holds chip select for the
+// length of one ioctl, so the address bytes from HAL_SPI_Write() are held back and go out in front of the data
+// in the same message.
+
+#if defined(__linux__)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#include "hw_api.h"
+#include "Eve2_81x.h"
+#include "linux_hw_api.h"
+
+static LinuxEveHal DefaultHal = { .Device = LINUX_SPI_DEVICE };
+
+static LinuxEveHal *Panel(void)
+{
+  LinuxEveHal *h = EveCurrent->Hal ? (LinuxEveHal *)EveCurrent->Hal : &DefaultHal;
+  uint8_t Mode = SPI_MODE_0, Bits = 8;
+  uint32_t Speed = h->SpeedHz ? h->SpeedHz : LINUX_SPI_HZ;
+
+  if (!h->Open)
+  {
+    h->Fd = open(h->Device, O_RDWR);
+    if (h->Fd < 0)
+      perror(h->Device);
+    else
+    {
+      ioctl(h->Fd, SPI_IOC_WR_MODE, &Mode);
+      ioctl(h->Fd, SPI_IOC_WR_BITS_PER_WORD, &Bits);
+      ioctl(h->Fd, SPI_IOC_WR_MAX_SPEED_HZ, &Speed);
+    }
+    h->Open = 1;
+    h->PendingLen = 0;
+  }
+  return (h);
+}
+
+// Send what is held back, then Tx (or receive into Rx after one dummy byte), all in one chip select
+static void Transfer(LinuxEveHal *h, const uint8_t *Tx, uint8_t *Rx, uint32_t Length)
+{
+  struct spi_ioc_transfer x[3];
+  uint8_t Dummy, n = 0;
+  uint32_t Speed = h->SpeedHz ? h->SpeedHz : LINUX_SPI_HZ;
+
+  memset(x, 0, sizeof(x));
+  if (h->PendingLen)
+  {
+    x[n].tx_buf = (unsigned long)h->Pending;
+    x[n++].len = h->PendingLen;
+  }
+  if (Rx)
+  {
+    x[n].rx_buf = (unsigned long)&Dummy;                             // Eve sends a dummy byte before the data
+    x[n++].len = 1;
+    x[n].rx_buf = (unsigned long)Rx;
+    x[n++].len = Length;
+  }
+  else if (Length)
+  {
+    x[n].tx_buf = (unsigned long)Tx;
+    x[n++].len = Length;
+  }
+  for (Dummy = 0; Dummy < n; Dummy++)
+    x[Dummy].speed_hz = Speed;
+  if (n && (h->Fd >= 0))
+    ioctl(h->Fd, SPI_IOC_MESSAGE(n), x);
+  h->PendingLen = 0;
+}
+
+void HAL_SPI_Enable(void)
+{
+  Panel()->PendingLen = 0;
+}
+
+void HAL_SPI_Disable(void)
+{
+  LinuxEveHal *h = Panel();
+
+  if (h->PendingLen)                                                 // A transaction of nothing but small writes
+    Transfer(h, 0, 0, 0);
+}
+
+void HAL_SPI_Write(uint8_t data)
+{
+  LinuxEveHal *h = Panel();
+
+  if (h->PendingLen == sizeof(h->Pending))
+    Transfer(h, 0, 0, 0);
+  h->Pending[h->PendingLen++] = data;
+}
+
+void HAL_SPI_WriteBuffer(uint8_t *Buffer, uint32_t Length)
+{
+  Transfer(Panel(), Buffer, 0, Length);
+}
+
+void HAL_SPI_ReadBuffer(uint8_t *Buffer, uint32_t Length)
+{
+  Transfer(Panel(), 0, Buffer, Length);
+}
+
+void HAL_Delay(uint32_t milliSeconds)
+{
+  struct timespec t = { milliSeconds / 1000, (milliSeconds % 1000) * 1000000L };
+
+  while (nanosleep(&t, &t))                                          // Carry on after a signal
+    ;
+}
+
+uint32_t HAL_Millis(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return ((uint32_t)(t.tv_sec * 1000ULL + t.tv_nsec / 1000000));
+}
+
+uint32_t HAL_Micros(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return ((uint32_t)(t.tv_sec * 1000000ULL + t.tv_nsec / 1000));
+}
+
+// PD_N is not usually wired to a Linux host.  Eve_Reset() follows this with a host command reset anyway.
+void HAL_Eve_Reset_HW(void)
+{
+}
+
+void HAL_Close(void)
+{
+  LinuxEveHal *h = EveCurrent->Hal ? (LinuxEveHal *)EveCurrent->Hal : &DefaultHal;
+
+  if (h->Open && (h->Fd >= 0))
+    close(h->Fd);
+  h->Open = 0;
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef LINUX_HW_API_H
+#define LINUX_HW_API_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+
+// One panel on a Linux spidev bus.  Point an EveContext's Hal at one of these (Eve_ContextInit) for each panel;
+// the built in context uses /dev/spidev0.0.  Each panel needs its own spidev device - its own chip select.
+typedef struct
+{
+  const char *Device;            // e.g. "/dev/spidev0.1"
+  uint32_t SpeedHz;              // 0 for LINUX_SPI_HZ
+  int Fd;                        // Filled in when first used
+  uint8_t Open;
+  uint8_t Pending[8];            // Header bytes (address) waiting for the rest of the transfer
+  uint8_t PendingLen;
+} LinuxEveHal;
+
+#define LINUX_SPI_DEVICE      "/dev/spidev0.0"
+#define LINUX_SPI_HZ          10000000UL                             // 30MHz is the Eve limit, wiring permitting
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+// Streaming file loader.  One engine for everything that copies a file into Eve.  All function calls are
+// hardware ambivalent.
+//
+// The file is read in turns into two buffers.  While one buffer is written to Eve, the next part of the file is
+// read into the other.  This only overlaps if the file layer can read in the background (FileReadStart() and
+// FileReadWait() - e.g. SDIO or SPI DMA on a bigger processor).  On the Arduino the SD card and Eve share
+// one SPI bus, so the read happens inside FileReadStart() and the two steps simply take turns.
+//
+// The data can go to three places:
+// - LOADER_SINK_CMD   the command FIFO, as inline data following Cmd (CMD_INFLATE, CMD_LOADIMAGE...)
+// - LOADER_SINK_MEDIA the media FIFO, which must already be set up with MediaFifo_Init(), for a Cmd using
+//                     OPT_MEDIAFIFO
+// - LOADER_SINK_RAMG  RAM_G starting at Add, with burst writes
+// The command words are only sent once the file is open, so a missing file leaves nothing waiting in the FIFO.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "dlog.h"                // Deferred logging
+#include "loader.h"              // Every c file has it's header and this is the one for this file
+
+// Write one buffer of file data to wherever it is going.  Returns false if the media FIFO stopped draining.
+static bool Loader_Sink(uint8_t Sink, uint32_t *Add, uint8_t *Buf, uint32_t Len)
+{
+  uint32_t Written, LastProgress;
+
+  switch (Sink)
+  {
+  case LOADER_SINK_CMD:
+    CoProWrCmdBuf(Buf, Len);                                         // Does its own FIFO triggering
+    break;
+
+  case LOADER_SINK_MEDIA:
+    LastProgress = HAL_Millis();
+    while (Len)
+    {
+      Written = MediaFifo_Write(Buf, Len);
+      if (Written)
+      {
+        Buf += Written;
+        Len -= Written;
+        LastProgress = HAL_Millis();
+      }
+      else if ((HAL_Millis() - LastProgress) > LOADER_STALL_MS)
+      {
+        DLOG1(MEDIA_STALL, Len);
+        return false;
+      }
+    }
+    break;
+
+  case LOADER_SINK_RAMG:
+    *Add = WriteBlockRAM(*Add, Buf, Len);
+    break;
+  }
+  return true;
+}
+
+// Stream a file into Eve.  Cmd (CmdWords long, may be 0) is sent first, once the file is open.  For the CMD and
+// MEDIA sinks the command has not necessarily finished on return - wait for the CoProcessor as usual.
+bool Loader_Stream(char *filename, uint8_t Sink, uint32_t Add, const uint32_t *Cmd, uint8_t CmdWords, LoaderStats *Stats)
+{
+  uint8_t Buf[2][LOADER_BUFSZ];
+  uint32_t Len[2];
+  uint32_t Remaining, Start = HAL_Millis();
+  uint8_t Cur = 0;
+  bool Result = true;
+
+  memset(Stats, 0, sizeof(LoaderStats));
+
+  FileOpen(filename, FILEREAD);
+  if(!myFileIsOpen())
+  {
+    Log("%s not open\n", filename);
+    FileClose();
+    return false;
+  }
+  Remaining = FileSize();
+
+  while (CmdWords--)
+    Send_CMD(*Cmd++);
+  UpdateFIFO();                                                      // Get the command going so it can take the data
+
+  Len[0] = (Remaining > LOADER_BUFSZ) ? LOADER_BUFSZ : Remaining;
+  Remaining -= Len[0];
+  FileReadStart(Buf[0], Len[0]);
+
+  while (Len[Cur])
+  {
+    FileReadWait();                                                  // Buf[Cur] is full
+
+    Len[Cur ^ 1] = (Remaining > LOADER_BUFSZ) ? LOADER_BUFSZ : Remaining;
+    Remaining -= Len[Cur ^ 1];
+    if (Len[Cur ^ 1])
+      FileReadStart(Buf[Cur ^ 1], Len[Cur ^ 1]);                     // Fill the other buffer while this one goes to Eve
+
+    if (!Loader_Sink(Sink, &Add, Buf[Cur], Len[Cur]))
+    {
+      if (Len[Cur ^ 1])
+        FileReadWait();
+      Result = false;
+      break;
+    }
+    Stats->Bytes += Len[Cur];
+    Cur ^= 1;
+  }
+  FileClose();
+
+  Stats->ElapsedMs = HAL_Millis() - Start;
+  if (Stats->ElapsedMs)                                              // Split so that bytes * 1000 does not overflow
+    Stats->Throughput = (Stats->Bytes / Stats->ElapsedMs) * 1000 + ((Stats->Bytes % Stats->ElapsedMs) * 1000) / Stats->ElapsedMs;
+  return (Result);
+}
+
+// Called after every load, so it goes to the deferred log, where there is no room for the file name.
+void Loader_LogStats(LoaderStats *Stats)
+{
+  DLOG3(LOAD_DONE, Stats->Bytes, Stats->ElapsedMs, Stats->Throughput);
+}
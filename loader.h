@@ -0,0 +1,38 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// Size of each of the two buffers.  Bigger is faster, and it must be a multiple of 4.  Both live on the stack
+// while a file loads, so the default suits the Uno - redefine it on anything with RAM to spare.
+#ifndef LOADER_BUFSZ
+#define LOADER_BUFSZ          64
+#endif
+
+#define LOADER_STALL_MS       1000                                   // Give up when the media FIFO stops draining this long
+
+// Where the file data goes
+#define LOADER_SINK_CMD       0                                      // Command FIFO, as the data for a command like CMD_INFLATE
+#define LOADER_SINK_MEDIA     1                                      // Media FIFO, for a command given OPT_MEDIAFIFO
+#define LOADER_SINK_RAMG      2                                      // Straight into RAM_G
+
+typedef struct
+{
+  uint32_t Bytes;                // Bytes streamed from the file
+  uint32_t ElapsedMs;            // From opening the file to the last byte reaching Eve
+  uint32_t Throughput;           // Bytes per second
+} LoaderStats;
+
+bool Loader_Stream(char *filename, uint8_t Sink, uint32_t Add, const uint32_t *Cmd, uint8_t CmdWords, LoaderStats *Stats);
+void Loader_LogStats(LoaderStats *Stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
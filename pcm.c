@@ -0,0 +1,325 @@
+// Streaming PCM audio through Eve's sample player.  All function calls are hardware ambivalent.
+//
+// Eve loops endlessly over a ring in RAM_G (REG_PLAYBACK_LOOP) and Pcm_Service(), a scheduler task, keeps the
+// ring ahead of her.  REG_PLAYBACK_READPTR says how far she has got, and once a quarter of the ring has been
+// played it is refilled from the file in one go.  Refilling in big lumps keeps the cost to one register read
+// per service most of the time, which leaves the bus to the UI.
+//
+// The file layer only has one file open at a time, and the loaders want it between refills, so each refill
+// opens the file, seeks to where it left off, reads and closes it again.
+//
+// Files are WAV (mono, 8 or 16 bit PCM or u-law) or headerless data in the Format given.  8 bit WAV is
+// unsigned and 16 bit WAV is too wide for Eve, so both are converted to 8 bit signed on the way through.
+// IMA ADPCM WAV files have block headers Eve cannot read, so ADPCM has to come as raw nibbles.  Any other WAV
+// (stereo, ADPCM...) is refused rather than played as raw data.
+//
+// If Eve catches up with the data (the service was held up for too long) that is an underrun: she has
+// replayed old samples.  It is counted and the writing restarts just ahead of her.  At the end of a file that
+// is not looped the ring is filled with silence and playback stops once the last real sample has played.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "dlog.h"                // Deferred logging
+#include "sound.h"               // For the amplifier
+#include "pcm.h"                 // Every c file has it's header and this is the one for this file
+
+// How file data becomes ring data
+#define PCM_AS_IS             0
+#define PCM_FROM_U8           1                                      // Unsigned 8 bit - flip the top bit
+#define PCM_FROM_S16          2                                      // Signed 16 bit - keep the high byte
+
+// What Pcm_ParseWav() found
+#define PCM_NOT_WAV           0                                      // Not RIFF at all - raw samples
+#define PCM_WAV               1
+#define PCM_WAV_BAD           2                                      // A WAV, but not one we can play
+
+static struct
+{
+  char *Filename;
+  uint32_t DataStart, DataEnd;   // The samples in the file
+  uint32_t FilePos;              // Next file byte to read
+  uint8_t Convert;
+  uint8_t Silence;               // Sample value of silence in this format
+  bool Loop;
+  bool Eof;                      // All the file is in the ring
+  bool Active;
+  uint32_t WriteOff;             // Next ring offset to fill
+  uint32_t ReadOff;              // READPTR offset at the last service
+  uint32_t Written;              // Ring bytes written, including silence
+  uint32_t DataWritten;          // Ring bytes written from the file
+  uint32_t Consumed;             // Ring bytes played
+} Pcm;
+
+static PcmStats Stats;
+
+static uint32_t Pcm_Get32(const uint8_t *p)
+{
+  return (p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+// Find the format and the samples in a WAV file.  Only a file that is not RIFF/WAVE at all is played as raw
+// data; a WAV we can not play is refused, since its header and samples played raw are just noise.
+static uint8_t Pcm_ParseWav(uint8_t *Format, uint16_t *Freq)
+{
+  uint8_t Hdr[24];
+  uint32_t Pos = 12, Size, Len = FileSize();
+  uint16_t Tag = 0, Channels = 0, Bits = 0;
+
+  FileReadBuf(Hdr, 12);
+  if ((Len < 12) || memcmp(Hdr, "RIFF", 4) || memcmp(Hdr + 8, "WAVE", 4))
+    return (PCM_NOT_WAV);
+
+  while (Pos + 8 <= Len)                                             // Walk the chunks for "fmt " and "data"
+  {
+    FileSeek(Pos);
+    FileReadBuf(Hdr, 8);
+    Size = Pcm_Get32(Hdr + 4);
+    if (!memcmp(Hdr, "fmt ", 4) && (Size >= 16))
+    {
+      FileReadBuf(Hdr, 16);
+      Tag = Hdr[0] | (Hdr[1] << 8);
+      Channels = Hdr[2] | (Hdr[3] << 8);
+      *Freq = Pcm_Get32(Hdr + 4);
+      Bits = Hdr[14] | (Hdr[15] << 8);
+    }
+    else if (!memcmp(Hdr, "data", 4))
+    {
+      Pcm.DataStart = Pos + 8;
+      Pcm.DataEnd = ((Pos + 8 + Size) > Len) ? Len : (Pos + 8 + Size);
+      break;
+    }
+    Pos += 8 + ((Size + 1) & ~1UL);                                  // Chunks are word aligned
+  }
+
+  if (!Pcm.DataEnd)
+  {
+    Log("WAV has no data\n");
+    return (PCM_WAV_BAD);
+  }
+  if (Channels != 1)
+  {
+    Log("WAV not mono\n");
+    return (PCM_WAV_BAD);
+  }
+  if ((Tag == 1) && (Bits == 8))
+    Pcm.Convert = PCM_FROM_U8;
+  else if ((Tag == 1) && (Bits == 16))
+    Pcm.Convert = PCM_FROM_S16;
+  else if (Tag == 7)
+  {
+    *Format = ULAW_SAMPLES;
+    return (PCM_WAV);
+  }
+  else
+  {
+    Log("WAV format %u/%u not supported\n", Tag, Bits);
+    return (PCM_WAV_BAD);
+  }
+  *Format = LINEAR_SAMPLES;
+  return (PCM_WAV);
+}
+
+// Write Count bytes at the ring write offset, wrapping at the end
+static void Pcm_RingWrite(uint8_t *Buf, uint32_t Count)
+{
+  uint32_t First = PCM_RING_SIZE - Pcm.WriteOff;
+
+  if (Count > First)
+  {
+    WriteBlockRAM(PCM_RING_ADD + Pcm.WriteOff, Buf, First);
+    WriteBlockRAM(PCM_RING_ADD, Buf + First, Count - First);
+  }
+  else
+    WriteBlockRAM(PCM_RING_ADD + Pcm.WriteOff, Buf, Count);
+  Pcm.WriteOff = (Pcm.WriteOff + Count) % PCM_RING_SIZE;
+  Pcm.Written += Count;
+}
+
+// Put up to Space bytes into the ring, from the file while there is any and then silence
+static void Pcm_Refill(uint32_t Space)
+{
+  uint8_t Buf[WorkBuffSz];
+  uint32_t Start = HAL_Micros(), Took;
+  uint32_t Want, Got, n;
+  uint8_t Per = (Pcm.Convert == PCM_FROM_S16) ? 2 : 1;               // File bytes per ring byte
+
+  if (!Pcm.Eof)
+  {
+    FileOpen(Pcm.Filename, FILEREAD);
+    if(!myFileIsOpen())
+    {
+      Log("%s not open\n", Pcm.Filename);
+      FileClose();
+      Pcm.Eof = true;                                                // Play out what we have
+    }
+    else
+      FileSeek(Pcm.FilePos);
+  }
+
+  while (Space && !Pcm.Eof)
+  {
+    Want = (Space * Per > WorkBuffSz) ? WorkBuffSz : Space * Per;
+    if (Want > Pcm.DataEnd - Pcm.FilePos)
+      Want = Pcm.DataEnd - Pcm.FilePos;
+    FileReadBuf(Buf, Want);
+    Pcm.FilePos += Want;
+
+    Got = Want / Per;
+    if (!Got)                                                        // Nothing whole left, and looping would not help
+    {
+      Pcm.Eof = true;
+      break;
+    }
+    for (n = 0; n < Got; n++)
+    {
+      if (Pcm.Convert == PCM_FROM_U8)
+        Buf[n] ^= 0x80;
+      else if (Pcm.Convert == PCM_FROM_S16)
+        Buf[n] = Buf[n * 2 + 1];
+    }
+    Pcm_RingWrite(Buf, Got);
+    Pcm.DataWritten += Got;
+    Stats.Bytes += Got;
+    Space -= Got;
+
+    if (Pcm.FilePos + Per > Pcm.DataEnd)                             // End of the samples
+    {
+      if (Pcm.Loop)
+      {
+        Pcm.FilePos = Pcm.DataStart;
+        FileSeek(Pcm.FilePos);
+      }
+      else
+        Pcm.Eof = true;
+    }
+  }
+  FileClose();
+
+  if (Space)                                                         // Nothing left to play - silence
+  {
+    memset(Buf, Pcm.Silence, WorkBuffSz);
+    while (Space)
+    {
+      n = (Space > WorkBuffSz) ? WorkBuffSz : Space;
+      Pcm_RingWrite(Buf, n);
+      memset(Buf, Pcm.Silence, n);                                   // The Arduino SPI write overwrites the buffer
+      Space -= n;
+    }
+  }
+
+  Stats.Refills++;
+  Took = HAL_Micros() - Start;
+  if (Took > Stats.RefillUsMax)
+    Stats.RefillUsMax = Took;
+}
+
+// Start playing a file.  Format and Freq are for headerless files; a WAV file says for itself.
+bool Pcm_Play(char *filename, uint8_t Format, uint16_t Freq, uint8_t Volume, bool Loop)
+{
+  uint8_t Wav;
+
+  Pcm_Stop();
+  memset(&Pcm, 0, sizeof(Pcm));
+  memset(&Stats, 0, sizeof(Stats));
+
+  FileOpen(filename, FILEREAD);
+  if(!myFileIsOpen())
+  {
+    Log("%s not open\n", filename);
+    FileClose();
+    return false;
+  }
+  Wav = Pcm_ParseWav(&Format, &Freq);
+  if (Wav == PCM_NOT_WAV)                                            // The whole file is samples
+  {
+    Pcm.DataStart = 0;
+    Pcm.DataEnd = FileSize();
+    Pcm.Convert = PCM_AS_IS;
+  }
+  FileClose();
+  if (Wav == PCM_WAV_BAD)
+  {
+    Log("%s not playable\n", filename);
+    return false;
+  }
+  if ((Pcm.DataEnd - Pcm.DataStart) < ((Pcm.Convert == PCM_FROM_S16) ? 2 : 1))
+  {
+    Log("%s has no samples\n", filename);
+    return false;
+  }
+
+  Pcm.Filename = filename;
+  Pcm.FilePos = Pcm.DataStart;
+  Pcm.Loop = Loop;
+  Pcm.Silence = (Format == ULAW_SAMPLES) ? 0xFF : 0;
+  Pcm_Refill(PCM_RING_SIZE);                                         // Fill the whole ring before starting
+
+  Sound_AmpHold(true);
+  wr8(REG_VOL_PB + RAM_REG, Volume);
+  wr32(REG_PLAYBACK_START + RAM_REG, PCM_RING_ADD);
+  wr32(REG_PLAYBACK_LENGTH + RAM_REG, PCM_RING_SIZE);
+  wr16(REG_PLAYBACK_FREQ + RAM_REG, Freq);
+  wr8(REG_PLAYBACK_FORMAT + RAM_REG, Format);
+  wr8(REG_PLAYBACK_LOOP + RAM_REG, 1);                               // Eve goes round the ring, we keep it full
+  wr8(REG_PLAYBACK_PLAY + RAM_REG, 1);
+  Pcm.Active = true;
+  return true;
+}
+
+// Keep the ring topped up.  Call it well within the time the ring lasts (a scheduler task every 50ms is plenty).
+void Pcm_Service(void)
+{
+  uint32_t Read, Queued;
+
+  if (!Pcm.Active)
+    return;
+
+  Read = rd32(REG_PLAYBACK_READPTR + RAM_REG) - PCM_RING_ADD;
+  Pcm.Consumed += (Read + PCM_RING_SIZE - Pcm.ReadOff) % PCM_RING_SIZE;
+  Pcm.ReadOff = Read;
+
+  if (Pcm.Eof && (Pcm.Consumed >= Pcm.DataWritten))                  // The last real sample has played
+  {
+    Pcm_Stop();
+    return;
+  }
+
+  if (Pcm.Consumed > Pcm.Written)                                    // Eve overtook us
+  {
+    Stats.Underruns++;
+    DLOG1(PCM_UNDERRUN, Pcm.Consumed - Pcm.Written);
+    Pcm.WriteOff = (Read + 8) % PCM_RING_SIZE;                       // Start again just ahead of her
+    Pcm.Written = Pcm.Consumed + 8;
+  }
+
+  Queued = Pcm.Written - Pcm.Consumed;
+  if ((PCM_RING_SIZE - Queued) >= PCM_REFILL_MIN)
+    Pcm_Refill(PCM_RING_SIZE - Queued - 8);                          // Stay a little clear of the read pointer
+}
+
+void Pcm_Stop(void)
+{
+  if (!Pcm.Active)
+    return;
+  wr32(REG_PLAYBACK_LENGTH + RAM_REG, 0);                            // Playing nothing stops it
+  wr8(REG_PLAYBACK_PLAY + RAM_REG, 1);
+  Sound_AmpHold(false);
+  Pcm.Active = false;
+}
+
+bool Pcm_Playing(void)
+{
+  return (Pcm.Active);
+}
+
+PcmStats *Pcm_GetStats(void)
+{
+  return (&Stats);
+}
+
+void Pcm_LogStats(void)
+{
+  Log("PCM %lu B, %lu refills\n", Stats.Bytes, Stats.Refills);
+  Log("%u underruns, %lu us max refill\n", Stats.Underruns, Stats.RefillUsMax);
+}
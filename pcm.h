@@ -0,0 +1,40 @@
+#ifndef PCM_H
+#define PCM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// The ring Eve plays from.  Both must be multiples of 8.  The default sits just below the video media FIFO
+// (video.h), so do not play video and PCM at the same time without moving one of them.
+#ifndef PCM_RING_SIZE
+#define PCM_RING_SIZE         0x8000UL                               // 32KB - 4s of 8kHz u-law
+#endif
+#ifndef PCM_RING_ADD
+#define PCM_RING_ADD          (RAM_G_WORKING - 0x10000UL - PCM_RING_SIZE)
+#endif
+#define PCM_REFILL_MIN        (PCM_RING_SIZE / 4)                    // Wait until this much can be refilled in one go
+
+typedef struct
+{
+  uint32_t Bytes;                // Sample bytes put in the ring
+  uint32_t Refills;
+  uint32_t RefillUsMax;          // Longest refill - the bus time taken from everything else
+  uint16_t Underruns;            // Times Eve caught up with the data
+} PcmStats;
+
+bool Pcm_Play(char *filename, uint8_t Format, uint16_t Freq, uint8_t Volume, bool Loop);
+void Pcm_Service(void);
+void Pcm_Stop(void);
+bool Pcm_Playing(void);
+PcmStats *Pcm_GetStats(void);
+void Pcm_LogStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,370 @@
+// Peephole pass over the CoProcessor FIFO.  All function calls are hardware ambivalent.
+//
+// With the pass on, Send_CMD() hands every word here (through CmdFilter) and this decides what actually goes
+// into the FIFO.  The display list state Eve will be in is tracked with the analyzer in eve_disasm.c, fed with
+// the words written rather than the words asked for, and:
+//   - State set to what it already is is dropped (COLOR_RGB, TAG, POINT_SIZE, BITMAP_SOURCE for the same
+//     handle...), as is a BEGIN of the primitive already begun or an END with nothing begun.
+//   - END is held back.  If the next thing is a BEGIN of the same primitive both are dropped, so runs of
+//     BITMAPS, POINTS, LINES and RECTS become one.  Strips are left alone - a new BEGIN starts a new strip.
+//   - BITMAP_HANDLE and CELL are held back until something needs them.  VERTEX2F in BITMAPS with whole pixel
+//     coordinates from 0 to 511 is written as VERTEX2II, which carries its own handle and cell, so a handle
+//     set only for a few VERTEX2II-able vertices is never written at all.
+// CoProcessor commands go through untouched.  Most of them write display list words of their own (a CMD_TEXT
+// sets handles, colors, BEGIN...) so after one nothing is known, except for the few that only touch RAM_G
+// or the CoProcessor's own state.  A command not in the table leaves the rest of the frame alone, since its
+// arguments can not be told from display list words.
+//
+// Words in and out are counted from CMD_DLSTART to CMD_SWAP and booked to the screen being built.  The pass
+// costs a table lookup per word (the tables are in flash on an AVR) and is only built with EVE_PEEP (peep.h).
+//
+// There is one set of state, so the pass works for one panel: the context bound when it was turned on.  Words
+// for any other panel go straight through, and what is held back for its own panel stays held until that panel
+// is bound again.  It can not be built with EVE_THREADS, where panels would race on the state.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "eve_disasm.h"          // Command parsing and display list state
+#include "peep.h"                // Every c file has it's header and this is the one for this file
+
+#ifdef EVE_PEEP
+
+#ifdef EVE_THREADS
+#error "The peephole pass keeps one panel's state and can not be built with EVE_THREADS"
+#endif
+
+#define OP_HANDLE             5          // BITMAP_HANDLE
+#define OP_CELL               6
+#define OP_BEGIN              31
+#define OP_END                33
+#define OP_VERTEXFORMAT       39
+
+#define PEEP_KNOWN(op)        (Dl.Known[(op) >> 5] & (1UL << ((op) & 31)))
+#define PEEP_IN(Set, op)      ((Set)[(op) >> 5] & (1UL << ((op) & 31)))
+#define PEEP_RUNS(p)          (((p) == BITMAPS) || ((p) == POINTS) || ((p) == LINES) || ((p) == RECTS))  // Not strips
+
+// State that needs nothing else written first: CLEAR_COLOR_RGB, TAG, COLOR_RGB, ALPHA_FUNC to TAG_MASK,
+// SCISSOR_XY, SCISSOR_SIZE, COLOR_MASK, VERTEXFORMAT, PALETTE_SOURCE and VERTEX_TRANSLATE_X/Y
+static const uint32_t PlainOps[2] = { 0x181FFE1CUL, 0x00001C81UL };
+// State kept per bitmap handle, which needs the handle written first: BITMAP_SOURCE, BITMAP_LAYOUT, BITMAP_SIZE,
+// BITMAP_TRANSFORM_A to F, BITMAP_LAYOUT_H, BITMAP_SIZE_H, BITMAP_EXT_FORMAT and BITMAP_SWIZZLE
+static const uint32_t HandleOps[2] = { 0x07E00182UL, 0x0000C300UL };
+
+static bool On;
+static EveContext *Owner;        // The panel the pass is working for
+static uint8_t Screen = 0xFF;
+static EveCmdParser Parser;
+static EveDlAnalyzer Dl;         // Where Eve will be once she has run what has been written
+static bool Bypass;              // A command not in the table - pass everything through until CMD_DLSTART
+static bool EndHeld;
+static uint32_t WantHandle;      // BITMAP_HANDLE and CELL words not written yet, 0 for none
+static uint32_t WantCell;
+static uint16_t FrameIn, FrameOut;
+
+static PeepScreen Screens[PEEP_SCREENS];
+static PeepStats Stats;
+
+static void Peep_Write(uint32_t Word)
+{
+  Send_CMD_Direct(Word);
+  FrameOut++;
+}
+
+// Write a display list word unless it changes nothing
+static void Peep_Put(uint32_t Word)
+{
+  if (Eve_DlAnalyze(&Dl, Word) == EVE_DL_REDUNDANT)
+    Stats.Redundant++;
+  else
+    Peep_Write(Word);
+}
+
+static void Peep_End(void)
+{
+  if (EndHeld)
+  {
+    EndHeld = false;
+    Peep_Put(END());
+  }
+}
+
+static void Peep_Handle(void)
+{
+  uint32_t Word = WantHandle;
+
+  if (Word)
+  {
+    WantHandle = 0;
+    Peep_Put(Word);
+  }
+}
+
+// Write everything held back
+static void Peep_Sync(void)
+{
+  uint32_t Word = WantCell;
+
+  Peep_End();
+  Peep_Handle();
+  if (Word)
+  {
+    WantCell = 0;
+    Peep_Put(Word);
+  }
+}
+
+// Commands which write no display list words
+static bool Peep_Quiet(uint32_t Word)
+{
+  switch (Word)
+  {
+  case CMD_BGCOLOR: case CMD_FGCOLOR: case CMD_GRADCOLOR:
+  case CMD_MEMCRC: case CMD_MEMWRITE: case CMD_MEMSET: case CMD_MEMZERO: case CMD_MEMCPY:
+  case CMD_REGREAD: case CMD_GETPTR: case CMD_INTERRUPT:
+  case CMD_LOADIDENTITY: case CMD_TRANSLATE: case CMD_SCALE: case CMD_ROTATE:
+  case CMD_TRACK: case CMD_FLASHREAD:
+    return true;
+  }
+  return false;
+}
+
+static void Peep_Frame(void)
+{
+  PeepScreen *s;
+  uint16_t Saved = FrameIn - FrameOut;
+
+  if (Screen < PEEP_SCREENS)
+  {
+    s = &Screens[Screen];
+    s->Frames++;
+    s->LastIn = FrameIn;
+    s->LastOut = FrameOut;
+    if (Saved > s->MaxSaved)
+      s->MaxSaved = Saved;
+    s->TotalIn += FrameIn;
+    s->TotalOut += FrameOut;
+  }
+  FrameIn = 0;
+  FrameOut = 0;
+}
+
+static void Peep_Command(uint32_t Word)
+{
+  Peep_Sync();
+  if (Word == CMD_DLSTART)
+  {
+    FrameIn = 1;
+    FrameOut = 0;
+    Peep_Write(Word);
+    Eve_DlAnalyzeReset(&Dl);                                         // CMD_DLSTART starts Eve from the defaults too
+    WantHandle = 0;
+    WantCell = 0;
+    Bypass = false;
+    return;
+  }
+
+  Peep_Write(Word);
+  if (!Parser.Info)
+  {
+    if (!Bypass)
+      Stats.Bypassed++;
+    Bypass = true;
+  }
+  else if (Word == CMD_SWAP)
+    Peep_Frame();
+  else if (!Peep_Quiet(Word))
+    Eve_DlUnknown(&Dl);
+}
+
+// VERTEX2F as VERTEX2II where that is the same thing.  Returns false if it is not.
+static bool Peep_Vertex(uint32_t Word)
+{
+  uint32_t Handle = WantHandle ? WantHandle : Dl.State[OP_HANDLE];
+  uint32_t Cell = WantCell ? WantCell : Dl.State[OP_CELL];
+  int16_t x = (int32_t)(Word << 2) >> 17;
+  int16_t y = (int32_t)(Word << 17) >> 17;
+  uint8_t Frac = Dl.State[OP_VERTEXFORMAT] & 7;
+
+  if ((Dl.Prim != BITMAPS) || !PEEP_KNOWN(OP_VERTEXFORMAT) || (!WantHandle && !PEEP_KNOWN(OP_HANDLE)) ||
+      (!WantCell && !PEEP_KNOWN(OP_CELL)))
+    return false;
+  if ((x < 0) || (y < 0) || ((x | y) & ((1 << Frac) - 1)))
+    return false;
+  x >>= Frac;
+  y >>= Frac;
+  if ((x > 511) || (y > 511))
+    return false;
+
+  Peep_Put(VERTEX2II(x, y, Handle, Cell));
+  Stats.Vertices++;
+  return true;
+}
+
+static void Peep_Dl(uint32_t Word)
+{
+  uint8_t op = Word >> 24;
+
+  if (Word >> 30)                                                    // VERTEX2F or VERTEX2II
+  {
+    Peep_End();
+    if (((Word >> 30) == 1) && !Peep_Vertex(Word))
+    {
+      Peep_Sync();
+      Peep_Put(Word);
+    }
+    else if ((Word >> 30) == 2)
+      Peep_Put(Word);
+    return;
+  }
+
+  switch (op)
+  {
+  case OP_HANDLE:
+    if (WantHandle)
+      Stats.Lazy++;
+    WantHandle = Word;
+    return;
+  case OP_CELL:
+    if (WantCell)
+      Stats.Lazy++;
+    WantCell = Word;
+    return;
+  case OP_BEGIN:
+    if ((Dl.Prim == (Word & 15)) && PEEP_RUNS(Dl.Prim))
+    {
+      if (EndHeld)
+        Stats.Merged++;
+      else
+        Stats.Redundant++;
+      EndHeld = false;
+      return;
+    }
+    Peep_Sync();                                                     // A strip is started again even if it is the same one
+    Eve_DlAnalyze(&Dl, Word);
+    Peep_Write(Word);
+    return;
+  case OP_END:
+    if (EndHeld || !Dl.Prim)
+      Stats.Redundant++;
+    else
+      EndHeld = true;
+    return;
+  }
+
+  if ((op < EVE_DL_OPS) && PEEP_IN(PlainOps, op))
+    Peep_Put(Word);
+  else if ((op < EVE_DL_OPS) && PEEP_IN(HandleOps, op))
+  {
+    Peep_Handle();
+    Peep_Put(Word);
+  }
+  else
+  {
+    Peep_Sync();
+    Peep_Put(Word);
+  }
+}
+
+// CmdFilter - every word Send_CMD() is given
+static void Peep_Word(uint32_t Word)
+{
+  uint8_t Result;
+
+  if (EveCurrent != Owner)
+  {
+    Send_CMD_Direct(Word);
+    return;
+  }
+  Result = Eve_CmdParse(&Parser, Word);
+  FrameIn++;
+  if (Result == EVE_PARSE_MORE)
+    Peep_Write(Word);
+  else if (Result == EVE_PARSE_START)
+    Peep_Command(Word);
+  else if (Bypass || Dl.Done)
+  {
+    Peep_Sync();
+    Peep_Write(Word);
+  }
+  else
+    Peep_Dl(Word);
+}
+
+// CmdFilterFlush - before the FIFO is kicked, and before words go in that are not seen here
+static void Peep_Flush(bool Unseen)
+{
+  if (EveCurrent != Owner)
+    return;
+  Peep_Sync();
+  if (Unseen)
+  {
+    Eve_CmdParseReset(&Parser);
+    Eve_DlUnknown(&Dl);
+  }
+}
+
+// Turn the pass on for the panel bound now, or off.  It starts knowing nothing, so a frame already under way
+// is still right.
+void Peep_Enable(bool NewOn)
+{
+  EveContext *Was = EveCurrent;
+
+  if (NewOn && !On)
+  {
+    Owner = EveCurrent;
+    Eve_CmdParseReset(&Parser);
+    Eve_DlAnalyzeReset(&Dl);
+    Eve_DlUnknown(&Dl);
+    Bypass = false;
+    FrameIn = 0;
+    FrameOut = 0;
+    CmdFilter = Peep_Word;
+    CmdFilterFlush = Peep_Flush;
+  }
+  else if (!NewOn && On)
+  {
+    Eve_Bind(Owner);                                                 // What is held back belongs to its panel
+    Peep_Sync();
+    Eve_Bind(Was);
+    CmdFilter = 0;
+    CmdFilterFlush = 0;
+  }
+  On = NewOn;
+}
+
+// The screen being built, so that its frames are booked to it
+void Peep_Screen(uint8_t ID)
+{
+  Screen = ID;
+}
+
+// Returns 0 for a screen that is not tracked
+const PeepScreen *Peep_Get(uint8_t ID)
+{
+  return ((ID < PEEP_SCREENS) ? &Screens[ID] : 0);
+}
+
+const PeepStats *Peep_GetStats(void)
+{
+  return (&Stats);
+}
+
+void Peep_LogStats(void)
+{
+  uint8_t ID;
+
+  Log("Peep %lu redundant %lu merged %lu V2II\n", (unsigned long)Stats.Redundant, (unsigned long)Stats.Merged,
+      (unsigned long)Stats.Vertices);
+  Log("  %lu lazy, %u frames bypassed\n", (unsigned long)Stats.Lazy, Stats.Bypassed);
+  for (ID = 0; ID < PEEP_SCREENS; ID++)
+  {
+    if (!Screens[ID].Frames)
+      continue;
+    Log("Screen %u %u words in %u out, max saved %u\n", ID, Screens[ID].LastIn, Screens[ID].LastOut,
+        Screens[ID].MaxSaved);
+    Log("  %lu saved in %u frames\n", (unsigned long)(Screens[ID].TotalIn - Screens[ID].TotalOut), Screens[ID].Frames);
+  }
+}
+
+#endif
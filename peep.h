@@ -0,0 +1,59 @@
+#ifndef PEEP_H
+#define PEEP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// The peephole pass (peep.c) is only built with EVE_PEEP defined - uncomment it here or define it for the
+// whole build.  It needs the eve_disasm.c tables and about 300 bytes of RAM for its display list state, which
+// is a lot for an Uno.  Without it the calls below compile to nothing.  The pass works for one panel and can
+// not be built with EVE_THREADS (see peep.c).
+//#define EVE_PEEP
+
+#ifndef PEEP_SCREENS
+#define PEEP_SCREENS          8
+#endif
+
+// Words in and out, counted per frame (CMD_DLSTART to CMD_SWAP)
+typedef struct
+{
+  uint16_t Frames;
+  uint16_t LastIn;               // Display list words in the last frame, before and after
+  uint16_t LastOut;
+  uint16_t MaxSaved;             // Most words saved in one frame
+  uint32_t TotalIn;
+  uint32_t TotalOut;
+} PeepScreen;
+
+typedef struct
+{
+  uint32_t Redundant;            // State set to what it already was, BEGIN of the primitive already begun
+  uint32_t Merged;               // END then BEGIN of the same primitive, both dropped
+  uint32_t Vertices;             // VERTEX2F written as VERTEX2II
+  uint32_t Lazy;                 // BITMAP_HANDLE and CELL that nothing ended up needing
+  uint16_t Bypassed;             // Frames left alone because of a command not in the table
+} PeepStats;
+
+#ifdef EVE_PEEP
+void Peep_Enable(bool On);
+void Peep_Screen(uint8_t ID);
+const PeepScreen *Peep_Get(uint8_t ID);
+const PeepStats *Peep_GetStats(void);
+void Peep_LogStats(void);
+#else
+#define Peep_Enable(On)
+#define Peep_Screen(ID)
+#define Peep_Get(ID)          ((const PeepScreen *)0)
+#define Peep_GetStats()       ((const PeepStats *)0)
+#define Peep_LogStats()
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
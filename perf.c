@@ -0,0 +1,145 @@
+// Screen transition timing.  All function calls are hardware ambivalent.
+//
+// SelectScreen() brackets the host side with Perf_ScreenBegin() and Perf_ScreenEnd(), and the loaders report
+// the time they spend streaming files with Perf_AddUpload().  What happens after that is Eve's business, so
+// Perf_Poll(), a scheduler task, watches for the CoProcessor to go idle (REG_CMD_READ == REG_CMD_WRITE) and
+// then for REG_FRAMES to move on twice: once for the swap to the new display list and once for that list to
+// be scanned out.  The poll period (PERF_POLL_MS, about a frame) is the resolution of those last two phases.
+//
+// Starting a new screen before the last one was on the glass drops the last one - it never made it.
+//
+// Only built with EVE_PERF defined (perf.h).
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "perf.h"                // Every c file has it's header and this is the one for this file
+
+#ifdef EVE_PERF
+
+#define PERF_IDLE             0
+#define PERF_HOST             1                                      // Between Begin and End
+#define PERF_WAIT_COPRO       2
+#define PERF_WAIT_FRAME       3
+
+static const uint8_t BinEdges[PERF_BINS - 1] = { 2, 5, 10, 20, 50, 100, 200 };   // ms
+
+static PerfScreen Screens[PERF_SCREENS];
+
+static struct
+{
+  uint8_t State;
+  uint8_t ID;
+  uint32_t Start;                // HAL_Micros() at each step
+  uint32_t HostDone;
+  uint32_t CoProDone;
+  uint32_t UploadUs;
+  uint32_t Frames;               // REG_FRAMES when the CoProcessor went idle
+} Cur;
+
+static void Perf_Add(PerfHist *h, uint32_t Us)
+{
+  uint32_t Ms = Us / 1000;
+  uint8_t b;
+
+  for (b = 0; (b < PERF_BINS - 1) && (Ms >= BinEdges[b]); b++)
+    ;
+  if (h->Count[b] != 0xFFFF)                                         // Stick rather than wrap
+    h->Count[b]++;
+  if (Ms > h->MaxMs)
+    h->MaxMs = (Ms > 0xFFFF) ? 0xFFFF : Ms;
+  h->TotalUs += Us;
+}
+
+void Perf_ScreenBegin(uint8_t ID)
+{
+  Cur.State = (ID < PERF_SCREENS) ? PERF_HOST : PERF_IDLE;
+  Cur.ID = ID;
+  Cur.UploadUs = 0;
+  Cur.Start = HAL_Micros();
+}
+
+void Perf_AddUpload(uint32_t Us)
+{
+  if (Cur.State == PERF_HOST)
+    Cur.UploadUs += Us;
+}
+
+void Perf_ScreenEnd(void)
+{
+  if (Cur.State != PERF_HOST)
+    return;
+  Cur.HostDone = HAL_Micros();
+  Cur.State = PERF_WAIT_COPRO;
+  Perf_Poll();                                                       // A display list written straight to RAM_DL is already done
+}
+
+void Perf_Poll(void)
+{
+  PerfScreen *s = &Screens[Cur.ID];
+  uint16_t ReadReg;
+  uint32_t Now = HAL_Micros(), Host;
+
+  if (Cur.State == PERF_WAIT_COPRO)
+  {
+    ReadReg = rd16(REG_CMD_READ + RAM_REG);
+    if (ReadReg == 0xFFF)                                            // Faulted - this one will never show
+      Cur.State = PERF_IDLE;
+    else if (ReadReg == rd16(REG_CMD_WRITE + RAM_REG))
+    {
+      Cur.CoProDone = Now;
+      Cur.Frames = rd32(REG_FRAMES + RAM_REG);
+      Cur.State = PERF_WAIT_FRAME;
+    }
+  }
+  else if (Cur.State == PERF_WAIT_FRAME)
+  {
+    if ((rd32(REG_FRAMES + RAM_REG) - Cur.Frames) >= 2)
+    {
+      Host = Cur.HostDone - Cur.Start;
+      Perf_Add(&s->Phase[PERF_BUILD], (Host > Cur.UploadUs) ? Host - Cur.UploadUs : 0);
+      Perf_Add(&s->Phase[PERF_UPLOAD], Cur.UploadUs);
+      Perf_Add(&s->Phase[PERF_COPRO], Cur.CoProDone - Cur.HostDone);
+      Perf_Add(&s->Phase[PERF_PRESENT], Now - Cur.CoProDone);
+      Perf_Add(&s->Phase[PERF_TOTAL], Now - Cur.Start);
+      s->Transitions++;
+      Cur.State = PERF_IDLE;
+    }
+  }
+}
+
+// Returns 0 for a screen that is not measured
+const PerfScreen *Perf_Get(uint8_t ID)
+{
+  return ((ID < PERF_SCREENS) ? &Screens[ID] : 0);
+}
+
+void Perf_Reset(void)
+{
+  memset(Screens, 0, sizeof(Screens));
+  Cur.State = PERF_IDLE;
+}
+
+void Perf_LogStats(void)
+{
+  static const char *Names[PERF_PHASES] = { "build", "upload", "copro", "present", "total" };
+  PerfHist *h;
+  uint8_t ID, p;
+
+  Log("ms <2 <5 <10 <20 <50 <100 <200 more\n");
+  for (ID = 0; ID < PERF_SCREENS; ID++)
+  {
+    if (!Screens[ID].Transitions)
+      continue;
+    Log("Screen %u: %u\n", ID, Screens[ID].Transitions);
+    for (p = 0; p < PERF_PHASES; p++)
+    {
+      h = &Screens[ID].Phase[p];
+      Log(" %-7s %lu/%u ms", Names[p], (h->TotalUs / Screens[ID].Transitions) / 1000, h->MaxMs);
+      Log(" %u %u %u %u %u %u %u %u\n", h->Count[0], h->Count[1], h->Count[2], h->Count[3],
+          h->Count[4], h->Count[5], h->Count[6], h->Count[7]);
+    }
+  }
+}
+
+#endif
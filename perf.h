@@ -0,0 +1,67 @@
+#ifndef PERF_H
+#define PERF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// Screen transition timing.  Each SelectScreen() is split into phases and every phase gets a histogram per
+// screen.  As configured this is about 900 bytes of RAM, which is more than an Uno can spare, so it is only
+// built with EVE_PERF defined - uncomment it here or define it for the whole build.  Without it the calls
+// below compile to nothing.  Cut PERF_SCREENS down to the screens of interest (IDs at or above it are not
+// measured) to make it fit a small part.
+//#define EVE_PERF
+
+#ifndef PERF_SCREENS
+#define PERF_SCREENS          8
+#endif
+#define PERF_POLL_MS          16                                     // Run Perf_Poll() about once a frame
+#define PERF_BINS             8                                      // Bin edges are in perf.c: <2, <5 ... <200, >=200 ms
+
+// Phases
+#define PERF_BUILD            0          // Host building the screen, not counting the uploads
+#define PERF_UPLOAD           1          // Files streaming into Eve (Load_ZLIB etc)
+#define PERF_COPRO            2          // From the host finishing until REG_CMD_READ catches REG_CMD_WRITE
+#define PERF_PRESENT          3          // From there until the first frame of the new display list is scanned out
+#define PERF_TOTAL            4          // All of it
+#define PERF_PHASES           5
+
+typedef struct
+{
+  uint16_t Count[PERF_BINS];
+  uint16_t MaxMs;
+  uint32_t TotalUs;              // Divide by PerfScreen.Transitions for the average
+} PerfHist;
+
+typedef struct
+{
+  uint16_t Transitions;          // Measured all the way to the screen
+  PerfHist Phase[PERF_PHASES];
+} PerfScreen;
+
+#ifdef EVE_PERF
+void Perf_ScreenBegin(uint8_t ID);
+void Perf_AddUpload(uint32_t Us);
+void Perf_ScreenEnd(void);
+void Perf_Poll(void);
+const PerfScreen *Perf_Get(uint8_t ID);
+void Perf_Reset(void);
+void Perf_LogStats(void);
+#else
+#define Perf_ScreenBegin(ID)
+#define Perf_AddUpload(Us)
+#define Perf_ScreenEnd()
+#define Perf_Poll()
+#define Perf_Get(ID)          ((const PerfScreen *)0)
+#define Perf_Reset()
+#define Perf_LogStats()
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,256 @@
+// Idle power management.  All function calls are hardware ambivalent.
+//
+// With nobody using the panel it steps down from full brightness through a dimmed backlight, Eve in standby,
+// Eve asleep and Eve powered down, each after its own time without input (POWER_..._MS, or Power_SetTimeout()).
+// The deeper the state the less it draws and the longer it takes to come back:
+// - DIM: only the backlight changes, so waking is one register write.
+// - STANDBY and SLEEP: the display list, RAM_G and registers are all kept.  Waking is HCMD_ACTIVE (plus the
+//   crystal start up from SLEEP) and the picture is back on the next frame.  The backlight stays off until then.
+// - PWRDOWN: everything in Eve is lost.  Waking initialises her again, puts back the touch calibration, the
+//   sound, font and text state cached on the host and the RAM_G regions given to Power_Keep(), then calls the
+//   application's redraw.  Regions come from the cheapest place they can: the module flash if the flash store
+//   holds the file (Eve copies it herself and nothing crosses the SPI bus), the SD card if not.  Screens which
+//   load their own images through Load_ZLIB() and friends get the same choice when they are redrawn.
+//
+// Eve is woken by Power_Activity(), which the application calls for every input event, and by any touch while
+// dim.  Below DIM the touch engine is stopped along with the clock, so only the keys can wake her - and the tag
+// is not read at all, since any read of Eve wakes her.  The time from waking until the first frame is on the
+// glass is measured for each state.  Power_Poll() runs as a scheduler task.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "power.h"               // Every c file has it's header and this is the one for this file
+#include "input.h"               // To stop reading the tag while Eve is down
+#include "pcm.h"                 // Streamed audio needs Eve awake
+#include "flash_store.h"         // Cheapest source for RAM_G contents
+#include "loader.h"              // Next cheapest
+#include "sound.h"               // Caches Eve's sound volume
+#include "font.h"                // Custom fonts live in RAM_G
+#include "text.h"                // Caches the ROM font metrics
+
+typedef struct
+{
+  uint32_t RamAdd;
+  char *Filename;
+} PowerRegion;
+
+static uint32_t Timeout[POWER_STATES] = { 0, POWER_DIM_MS, POWER_STANDBY_MS, POWER_SLEEP_MS, POWER_PWRDOWN_MS };
+static PowerState States[POWER_STATES];
+static PowerRegion Regions[POWER_REGIONS];
+static uint8_t RegionCount;
+static PowerRedrawFunc RedrawHook;
+static int Display, Board, Touch;                                    // For FT81x_Init() after power down
+
+static uint8_t State;
+static uint32_t Since;                                               // HAL_Millis() when State was entered
+static uint32_t LastActivity;
+static uint32_t WokeAt;
+static uint8_t SavedDuty;                                            // Backlight to go back to
+static uint32_t SavedTransform[6];                                   // Touch calibration, REG_TOUCH_TRANSFORM_A - F
+static bool FlashWasFull;
+
+// The same display, board and touch as FT81x_Init() was given.  Redraw is called after power down to put the
+// screen back (0 if power down is not used).
+void Power_Init(int display, int board, int touch, PowerRedrawFunc Redraw)
+{
+  Display = display;
+  Board = board;
+  Touch = touch;
+  RedrawHook = Redraw;
+  State = POWER_ACTIVE;
+  Since = LastActivity = HAL_Millis();
+  WokeAt = Since - POWER_WAKE_GUARD_MS;
+  RegionCount = 0;
+}
+
+void Power_SetTimeout(uint8_t State, uint32_t Ms)
+{
+  if (State && (State < POWER_STATES))
+    Timeout[State] = Ms;
+}
+
+// Have a raw file put back at RamAdd after power down.  Returns false if the table is full.
+bool Power_Keep(uint32_t RamAdd, char *filename)
+{
+  if (RegionCount == POWER_REGIONS)
+  {
+    Log("Power regions full\n");
+    return false;
+  }
+  Regions[RegionCount].RamAdd = RamAdd;
+  Regions[RegionCount++].Filename = filename;
+  return true;
+}
+
+static void Power_Enter(uint8_t New)
+{
+  uint32_t Now = HAL_Millis();
+  uint8_t n;
+
+  States[State].TimeMs += Now - Since;
+  States[New].Entered++;
+  Since = Now;
+
+  if (State == POWER_ACTIVE)
+    SavedDuty = rd8(REG_PWM_DUTY + RAM_REG);
+  if ((State <= POWER_DIM) && (New >= POWER_STANDBY))                // Last chance to read anything from Eve
+  {
+    for (n = 0; n < 6; n++)
+      SavedTransform[n] = rd32(REG_TOUCH_TRANSFORM_A + RAM_REG + n * 4);
+    FlashWasFull = (rd8(REG_FLASH_STATUS + RAM_REG) == FLASH_STATUS_FULL);
+    Input_TagPause(true);
+    wr8(REG_PWM_DUTY + RAM_REG, 0);
+  }
+
+  switch (New)
+  {
+  case POWER_DIM:
+    if (SavedDuty > POWER_DIM_DUTY)
+      wr8(REG_PWM_DUTY + RAM_REG, POWER_DIM_DUTY);
+    break;
+  case POWER_STANDBY:
+    HostCommand(HCMD_STANDBY);
+    break;
+  case POWER_SLEEP:
+    HostCommand(HCMD_SLEEP);
+    break;
+  case POWER_PWRDOWN:
+    HostCommand(HCMD_PWRDOWN);
+    break;
+  }
+  State = New;
+}
+
+// Put a region back from wherever is cheapest
+static void Power_Restore(PowerRegion *r)
+{
+  FlashAsset *Asset = FlashStore_Find(r->Filename);
+  LoaderStats Stats;
+
+  if (Asset)
+    FlashStore_Read(r->RamAdd, Asset->FlashAdd, Asset->Size);
+  else
+    Loader_Stream(r->Filename, LOADER_SINK_RAMG, r->RamAdd, 0, 0, &Stats);
+}
+
+static void Power_Wake(void)
+{
+  PowerState *s = &States[State];
+  uint32_t Start = HAL_Micros(), Now = HAL_Millis(), Frames, Us;
+  uint8_t Need = 1, n;
+
+  switch (State)
+  {
+  case POWER_DIM:
+    wr8(REG_PWM_DUTY + RAM_REG, SavedDuty);
+    break;
+  case POWER_STANDBY:
+    HostCommand(HCMD_ACTIVE);
+    break;
+  case POWER_SLEEP:
+    HostCommand(HCMD_ACTIVE);
+    HAL_Delay(POWER_SLEEP_WAKE_MS);
+    break;
+  case POWER_PWRDOWN:
+    FT81x_Init(Display, Board, Touch);
+    wr8(REG_PWM_DUTY + RAM_REG, 0);                                  // Dark until there is something to see
+    for (n = 0; n < 6; n++)
+      wr32(REG_TOUCH_TRANSFORM_A + RAM_REG + n * 4, SavedTransform[n]);
+    if (FlashWasFull)
+      FlashStore_Init();
+    Sound_Init();                                                    // Her volume is back to the default
+    Font_Restore();
+    Text_Flush();
+    for (n = 0; n < RegionCount; n++)
+      Power_Restore(&Regions[n]);
+    if (RedrawHook)
+      RedrawHook();
+    Wait4CoProFIFOEmpty();
+    Need = 2;                                                        // The swap lands on one frame, is seen on the next
+    break;
+  }
+
+  if (State >= POWER_STANDBY)
+  {
+    Frames = rd32(REG_FRAMES + RAM_REG);
+    while (((rd32(REG_FRAMES + RAM_REG) - Frames) < Need) && ((HAL_Millis() - Now) < POWER_FRAME_WAIT_MS))
+      ;
+    wr8(REG_PWM_DUTY + RAM_REG, SavedDuty);
+    Input_TagPause(false);
+  }
+
+  Us = HAL_Micros() - Start;
+  s->Wakes++;
+  s->WakeUsTotal += Us;
+  if (Us > s->WakeUsMax)
+    s->WakeUsMax = Us;
+  s->TimeMs += HAL_Millis() - Since;
+  States[POWER_ACTIVE].Entered++;
+  State = POWER_ACTIVE;
+  Since = WokeAt = HAL_Millis();
+}
+
+// Call for every input event.  Wakes Eve if need be, and returns true when the event should be ignored because
+// it is what woke her (or came just after).
+bool Power_Activity(void)
+{
+  bool Woke = (State != POWER_ACTIVE);
+
+  LastActivity = HAL_Millis();
+  if (Woke)
+    Power_Wake();
+  return (Woke || ((HAL_Millis() - WokeAt) < POWER_WAKE_GUARD_MS));
+}
+
+// Step down when it is time to.  Every 50ms or so is plenty.
+void Power_Poll(void)
+{
+  uint32_t Idle;
+  uint8_t Target = State, n;
+
+  if ((State <= POWER_DIM) && (rd32(REG_TOUCH_SCREEN_XY + RAM_REG) != 0x80008000UL))  // Touched, tag or not
+  {
+    Power_Activity();
+    return;
+  }
+
+  Idle = HAL_Millis() - LastActivity;
+  for (n = State + 1; n < POWER_STATES; n++)
+  {
+    if (Timeout[n] && (Idle >= Timeout[n]))
+      Target = n;
+  }
+  if ((Target > POWER_DIM) && Pcm_Playing())                         // Dim is as far as it goes with music playing
+    Target = POWER_DIM;
+  if (Target > State)
+    Power_Enter(Target);
+}
+
+uint8_t Power_State(void)
+{
+  return (State);
+}
+
+const PowerState *Power_Get(uint8_t State)
+{
+  return (&States[State]);
+}
+
+void Power_LogStats(void)
+{
+  static const char *Names[POWER_STATES] = { "active", "dim", "standby", "sleep", "pwrdown" };
+  PowerState *s;
+  uint8_t n;
+
+  States[State].TimeMs += HAL_Millis() - Since;                      // Bring the current state up to date
+  Since = HAL_Millis();
+  for (n = 0; n < POWER_STATES; n++)
+  {
+    s = &States[n];
+    Log("%-7s %lu x %lu s", Names[n], s->Entered, s->TimeMs / 1000);
+    if (s->Wakes)
+      Log(" wake %lu/%lu us", s->WakeUsTotal / s->Wakes, s->WakeUsMax);
+    Log("\n");
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef POWER_H
+#define POWER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// Power states, each deeper than the last
+#define POWER_ACTIVE          0          // Full brightness
+#define POWER_DIM             1          // Backlight down to POWER_DIM_DUTY, everything else running
+#define POWER_STANDBY         2          // Backlight off, Eve clock stopped (oscillator and PLL still running)
+#define POWER_SLEEP           3          // Oscillator and PLL off too
+#define POWER_PWRDOWN         4          // Eve off - RAM_G, the display list and the registers are all lost
+#define POWER_STATES          5
+
+// Time without input before each state is entered, ms.  0 leaves the state out.  Touch can only wake Eve from
+// DIM, as the touch engine stops with the clock - a panel without keys should not go any deeper.
+#ifndef POWER_DIM_MS
+#define POWER_DIM_MS          30000UL
+#endif
+#ifndef POWER_STANDBY_MS
+#define POWER_STANDBY_MS      120000UL
+#endif
+#ifndef POWER_SLEEP_MS
+#define POWER_SLEEP_MS        600000UL
+#endif
+#ifndef POWER_PWRDOWN_MS
+#define POWER_PWRDOWN_MS      0                                      // Waking from this redraws everything
+#endif
+#define POWER_DIM_DUTY        16                                     // Backlight when dim, of 128
+#define POWER_SLEEP_WAKE_MS   20                                     // Crystal and PLL start up leaving SLEEP
+#define POWER_WAKE_GUARD_MS   300                                    // Input this soon after waking only woke us
+#define POWER_FRAME_WAIT_MS   100                                    // Longest wait for the first frame
+#define POWER_REGIONS         4                                      // RAM_G regions put back after power down
+
+typedef void (*PowerRedrawFunc)(void);
+
+typedef struct
+{
+  uint32_t Entered;              // Times the state was entered
+  uint32_t TimeMs;               // Time spent in it
+  uint32_t Wakes;                // Times woken from it
+  uint32_t WakeUsTotal;          // Wake to first frame on the glass - divide by Wakes for the average
+  uint32_t WakeUsMax;
+} PowerState;
+
+void Power_Init(int display, int board, int touch, PowerRedrawFunc Redraw);
+void Power_SetTimeout(uint8_t State, uint32_t Ms);
+bool Power_Keep(uint32_t RamAdd, char *filename);
+bool Power_Activity(void);
+void Power_Poll(void);
+uint8_t Power_State(void);
+const PowerState *Power_Get(uint8_t State);
+void Power_LogStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,10 +3,35 @@
 #include <stdint.h>              // Find integer types like "uint8_t"  
 #include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
 #include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "dlog.h"                // Deferred logging
 #include "process.h"             // Every c file has it's header and this is the one for this file
+#include "flash_store.h"         // Images kept in the display module flash
+#include "loader.h"              // Streams files into Eve
+#include "perf.h"                // Screen transition timing
+#include "dlcheck.h"             // Display list budget
+#include "font.h"                // Custom font glyph cache
+#include "text.h"                // Host side text layout
+#include "peep.h"                // Peephole pass on the FIFO
+
+// The SD card images, copied into flash on EVE3/EVE4 modules the first time they boot.  After that the
+// loaders below find them in flash and the SD card is not touched.  Change FLASH_ASSET_STAMP whenever the
+// images change so that they are programmed again.
+#define FLASH_ASSET_STAMP     0x45564502UL
+FlashAsset FlashAssets[] = { { .Filename = "C480_272.bin" }, { .Filename = "C480_272.jpg" }, { .Filename = "L256_128.raw" },
+                             { .Filename = "P480_272.bin" }, { .Filename = "P480_272.lut" } };
+
+void FlashAssets_Init(void)
+{
+  if (FlashStore_Init())
+    FlashStore_ProgramOnce(FlashAssets, sizeof(FlashAssets) / sizeof(FlashAsset), FLASH_ASSET_STAMP);
+}
 
 void SelectScreen(uint8_t ID)
 {
+  Perf_ScreenBegin(ID);
+  DlCheck_Screen(ID);
+  Font_Screen(ID);
+  Peep_Screen(ID);
   switch(ID)
   {
   case SCR_FTDI:
@@ -30,9 +55,13 @@ void SelectScreen(uint8_t ID)
   case SCR_RAW:
     MakeScreen_Bitmap_DL("L256_128.raw", 256, 128, (480-256)/2, (272-128)/2, 1);           // File retrieval from SD Card
     break;
+  case SCR_PAL:
+    MakeScreen_Paletted("P480_272.bin", "P480_272.lut", PALETTED565, 480, 272, 0, 0, 2);     // The C480_272 image in 256 colours
+    break;
   default:
     break;
   }
+  Perf_ScreenEnd();                                                  // Perf_Poll() times the rest
 }
 
 // blue dot example (Straight into the display list without CoProcessor interaction)
@@ -63,7 +92,7 @@ void MakeScreen_MatrixOrbital(uint8_t DotSize)
   wr32(RAM_DL + 80, VERTEX2II(240, 133, 0, 0));    // place blue point
   wr32(RAM_DL + 84, END());                        // end placing points
   wr32(RAM_DL + 86, DISPLAY());                    // display the image
-  wr8(REG_DLSWAP + RAM_REG, DLSWAP_FRAME);         // swap display lists
+  DlCheck_DlSwap();                                // swap display lists
 }
 
 // blue dot example using the FIFO
@@ -82,8 +111,7 @@ void MakeScreen_MatrixOrbitalFIFO(uint8_t DotSize)
   Send_CMD(COLOR_RGB(255, 255, 255));      //Change color to white for text
   Cmd_Text(Display_Width() / 2, Display_Height() / 2, 30, OPT_CENTER, " MATRIX         ORBITAL"); //Write text in the center of the screen
   Send_CMD(DISPLAY());                     //End the display list
-  Send_CMD(CMD_SWAP);                      //Swap commands into RAM
-  UpdateFIFO();                            // Trigger the CoProcessor to start processing the FIFO
+  DlCheck_Swap();                          //Swap commands into RAM and trigger the CoProcessor
 }
 
 // Sound demo - written to the Co-processor ( AKA GPU and FIFO )
@@ -94,10 +122,10 @@ void MakeScreen_Button(void)
   Send_CMD(CMD_DLSTART);
   Cmd_Gradient(0, 0, 0xA1E1FF, 0, 250, 0x000080);           // The whole screen is a color gradient in blue
   
-  Cmd_Text(470, 250, 26, OPT_RIGHTX, "matrixorbital.com");  // White text
+  Text_Draw(26, 470, 250, OPT_RIGHTX, 0, "matrixorbital.com");  // White text, laid out here rather than by the CoProcessor
   
   Send_CMD(COLOR_RGB(0xDE,0x00,0x08));                      // Change the color of following text to reddish
-  Cmd_Text(240, 40, 31, OPT_CENTERX, "Sound Demo");
+  Text_Draw(31, 240, 40, OPT_CENTERX, 0, "Sound Demo");
   
   Send_CMD(COLOR_RGB(64, 64, 64));                          // Change color of following text to grey
   Cmd_FGcolor(0x228B22);                                    // Change button face color to a mild green
@@ -111,8 +139,7 @@ void MakeScreen_Button(void)
   Cmd_Button(250, 190, 120, 48, 28, 0, "Piano F4");
   
   Send_CMD(DISPLAY());
-  Send_CMD(CMD_SWAP);  
-  UpdateFIFO();                                            // Trigger the CoProcessor to start processing the FIFO
+  DlCheck_Swap();                                          // Swap and trigger the CoProcessor to start processing the FIFO
 }
 
 // Decompress a ZLIB compressed image from SD card into RAM_G
@@ -122,7 +149,7 @@ void MakeScreen_Bitmap(uint8_t *filename, uint16_t Xsize, uint16_t Ysize, uint16
   uint32_t BMPBaseAdd = RAM_G;                                       // Hard-coded Address lacks panache
 
   tmp = Load_ZLIB(BMPBaseAdd, filename);                             // Load a bitmap into RAM_G
-  Log("ZLIB used 0x%08lx\n", tmp - BMPBaseAdd); 
+  DLOG1(ZLIB_USED, tmp - BMPBaseAdd);
   
   // Screen start
   Send_CMD(CMD_DLSTART);                                             // Start a new display list
@@ -135,7 +162,6 @@ void MakeScreen_Bitmap(uint8_t *filename, uint16_t Xsize, uint16_t Ysize, uint16
   
   // Place the bitmap
   Send_CMD(BEGIN(BITMAPS));
-  Send_CMD(BITMAP_HANDLE(Reference));
   Send_CMD(VERTEX2II(Xloc, Yloc, Reference, 0));                     // Define the placement position of the previously defined holding area.
   Send_CMD(END());                                                   // end placing bitmaps
   
@@ -143,10 +169,9 @@ void MakeScreen_Bitmap(uint8_t *filename, uint16_t Xsize, uint16_t Ysize, uint16
   Cmd_Text(11, 11, 26, 0, filename);
   
   Send_CMD(DISPLAY());                                               // End display list
-  Send_CMD(CMD_SWAP);                                                // Activate this display list
-  UpdateFIFO();                                                      // Trigger the CoProcessor to start processing the FIFO
+  DlCheck_Swap();                                                    // Activate this display list and trigger the CoProcessor
 
-  Log("Leave Bitmap\n");
+  DLOG0(SCREEN_BITMAP);
 }
 
 // Using raw uncompressed bitmap data, the CoProcessor is not needed for inflation and the data is 
@@ -157,7 +182,7 @@ void MakeScreen_Bitmap_DL(uint8_t *filename, uint16_t Xsize, uint16_t Ysize, uin
   uint32_t BMPBaseAdd = RAM_G + 0x40000UL;                               // Hard-coded Address lacks panache
   
   Load_RAW(BMPBaseAdd, filename);                                        // Load a bitmap into RAM_G
-  Log("after loadRAW \n"); 
+  DLOG1(RAW_LOADED, BMPBaseAdd);
   
   // Screen start
   wr32(RAM_DL + 0, CLEAR_COLOR_RGB(200,200,200));                        // Set the color for clearing to whitish
@@ -191,9 +216,9 @@ void MakeScreen_Bitmap_DL(uint8_t *filename, uint16_t Xsize, uint16_t Ysize, uin
   wr32(RAM_DL + 88, END());                                              // end placing bitmaps
 
   wr32(RAM_DL + 92, DISPLAY());                                          // End display list
-  wr8(REG_DLSWAP + RAM_REG, DLSWAP_FRAME);                               // swap display lists
+  DlCheck_DlSwap();                                                      // swap display lists
 
-  Log("Leave Bitmap DL\n");
+  DLOG0(SCREEN_DL);
 }
 
 // Decompress a JPEG compressed image from SD card into RAM_G
@@ -203,7 +228,7 @@ void MakeScreen_JPEG(uint8_t *filename, uint16_t Xsize, uint16_t Ysize, uint16_t
   uint32_t BMPBaseAdd = RAM_G + 0x80000UL;                           // Hard-coded Address lacks panache
 
   tmp = Load_JPG(BMPBaseAdd, 0, filename);                           // Load a bitmap into RAM_G
-  Log("JPG used 0x%08lx\n", tmp - BMPBaseAdd); 
+  DLOG1(JPG_USED, tmp - BMPBaseAdd);
   
   // Screen start
   Send_CMD(CMD_DLSTART);                                             // Start a new display list
@@ -216,7 +241,6 @@ void MakeScreen_JPEG(uint8_t *filename, uint16_t Xsize, uint16_t Ysize, uint16_t
   
   // Place the bitmap
   Send_CMD(BEGIN(BITMAPS));
-  Send_CMD(BITMAP_HANDLE(Reference));
   Send_CMD(VERTEX2II(Xloc, Yloc, Reference, 0));                     // Define the placement position of the previously defined holding area.
   Send_CMD(END());                                                   // end placing bitmaps
   
@@ -224,16 +248,49 @@ void MakeScreen_JPEG(uint8_t *filename, uint16_t Xsize, uint16_t Ysize, uint16_t
   Cmd_Text(11, 11, 26, 0, filename);
   
   Send_CMD(DISPLAY());                                               // End display list
-  Send_CMD(CMD_SWAP);                                                // Activate this display list
-  UpdateFIFO();                                                      // Trigger the CoProcessor to start processing the FIFO
+  DlCheck_Swap();                                                    // Activate this display list and trigger the CoProcessor
 
-  Log("Leave jpeg\n");
+  DLOG0(SCREEN_JPEG);
+}
+
+// The same picture as MakeScreen_Bitmap() from a paletted bitmap made by tools/imgcvt.  One byte per pixel
+// instead of two, so half the RAM_G and half the loading.
+void MakeScreen_Paletted(char *filename, char *lutname, uint16_t fmt, uint16_t Xsize, uint16_t Ysize, uint16_t Xloc, uint16_t Yloc, uint8_t Reference)
+{
+  uint32_t tmp, IndexAdd;
+  uint32_t PalAdd = RAM_G + 0x50000UL;                               // Hard-coded Address lacks panache
+
+  tmp = Load_Paletted(PalAdd, filename, lutname, &IndexAdd);         // Palette and indices into RAM_G
+  DLOG2(PAL_USED, PalAdd, tmp);
+  if (!tmp)
+  {
+    Log("%s not loaded, no bitmap\n", filename);
+  }
+
+  // Screen start
+  Send_CMD(CMD_DLSTART);                                             // Start a new display list
+  Send_CMD(CLEAR_COLOR_RGB(255,255,255));                            // Set the color for clearing to full white
+  Send_CMD(CLEAR(1,1,1));                                            // clear screen
+
+  if (tmp)
+  {
+    Bitmap_Setup(Reference, IndexAdd, fmt, Xsize, Ysize);            // The indices are the bitmap
+    Bitmap_DrawPaletted(Reference, PalAdd, fmt, Xloc, Yloc);         // Looked up in the palette as they are drawn
+  }
+
+  Send_CMD(COLOR_RGB(0x20,0xFF,0x20));                               // Set the text color
+  Cmd_Text(11, 11, 26, 0, filename);
+
+  Send_CMD(DISPLAY());                                               // End display list
+  DlCheck_Swap();                                                    // Activate this display list and trigger the CoProcessor
+
+  DLOG0(SCREEN_PAL);
 }
 
 // A calibration screen for the touch digitizer
 void MakeScreen_Calibrate(void)
 {
-  Log("Enter Calibrate\n");
+  DLOG0(CALIBRATE_START);
   
   Send_CMD(CMD_DLSTART);
   Send_CMD(CLEAR_COLOR_RGB(0,0,0));
@@ -247,134 +304,84 @@ void MakeScreen_Calibrate(void)
   Wait4CoProFIFOEmpty();                                      // wait here until the coprocessor has read and executed every pending command.
   HAL_Delay(100);
 
-  Log("Leaving Calibrate\n");
+  DLOG0(CALIBRATE_DONE);
 }
 
-// This define is for the size of the buffer we are going to use for data transfers.  It is 
-// sitting here so uncomfortably because it is a silly tiny buffer in Arduino Uno and you
-// will want a bigger one if you can get it.  Redefine this and add a nice buffer to Load_ZLIB()
-#define COPYBUFSIZE WorkBuffSz
-
 // Load a compressed bitmap from SD card into RAM_G at address "BaseAdd"
-// The file will have been processed by "img_cvt.exe" from FTDI
+// The file will have been processed by "img_cvt.exe" from FTDI (or tools/imgcvt with -z)
 // Return value is the last RAM_G address used during the inflation operation - you might want it
 uint32_t Load_ZLIB(uint32_t BaseAdd, char *filename) 
 {
-  uint32_t Remaining;
-  uint16_t ReadBlockSize = 0;
-
-  // Open the file on SD card by name
-  FileOpen(filename, FILEREAD);
-  if(!myFileIsOpen())
-  {
-    Log("%s not open\n", filename);
-    FileClose();
-    return false;
-  }
-  
-  Remaining = FileSize();                                    // Store the size of the currently opened file
-  
-  Send_CMD(CMD_INFLATE);                                     // Tell the CoProcessor to prepare for compressed data
-  Send_CMD(BaseAdd);                                         // This is the address where decompressed data will go 
+  uint32_t Cmd[2] = { CMD_INFLATE, BaseAdd };                // Tell the CoProcessor to prepare for compressed data and where it goes
+  LoaderStats Stats;
+  FlashAsset *Asset = FlashStore_Find(filename);
 
-  while (Remaining)
-  {
-    if (Remaining > COPYBUFSIZE)
-      ReadBlockSize = COPYBUFSIZE;
-    else
-      ReadBlockSize = Remaining;
-    
-    FileReadBuf(LogBuf, ReadBlockSize);                      // Read a block of data from the file
-    CoProWrCmdBuf(LogBuf, ReadBlockSize);                    // write the block to FIFO - Does FIFO triggering
-    Remaining -= ReadBlockSize;                              // Reduce remaining data value by amount just read
-  }
-  FileClose();
+  if (Asset)                                                 // Already in flash so Eve can inflate it herself
+    return (FlashStore_Inflate(BaseAdd, Asset->FlashAdd));
 
-  Wait4CoProFIFOEmpty();                                     // wait here until the coprocessor has read and executed every pending command.
+  if (!Loader_Stream(filename, LOADER_SINK_CMD, 0, Cmd, 2, &Stats))
+    return false;
+  Loader_LogStats(&Stats);
+  Perf_AddUpload(Stats.ElapsedMs * 1000);
 
   // Get the address of the last RAM location used during inflation
-  Cmd_GetPtr();                                              // FifoWriteLocation is updated twice so the data is returned to it's updated location - 4
-  UpdateFIFO();                                              // force run the GetPtr command
-  return (rd32(FifoWriteLocation + RAM_CMD - 4));            // The result is stored at the FifoWriteLocation - 4 (because FTDI is Chaotic Evil)
+  return (CoProGetPtr());
 }         
 
 // Load a JPEG image from SD card into RAM_G at address "BaseAdd"
 // Return value is the last RAM_G address used during the jpeg decompression operation.
-// The function is virtually identical to Load_ZLIB as the only difference is the memory operation
 uint32_t Load_JPG(uint32_t BaseAdd, uint32_t Options, char *filename) 
 {
-  uint32_t Remaining;
-  uint16_t ReadBlockSize = 0;
+  uint32_t Cmd[3] = { CMD_LOADIMAGE, BaseAdd, Options };     // Options are mostly not obviously useful
+  LoaderStats Stats;
+  FlashAsset *Asset = FlashStore_Find(filename);
 
-  // Open the file on SD card by name
-  FileOpen(filename, FILEREAD);
-  if(!myFileIsOpen())
-  {
-    Log("%s not open\n", filename);
-    FileClose();
-    return false;
-  }
-  
-  Remaining = FileSize();                                    // Store the size of the currently opened file
-  
-  Send_CMD(CMD_LOADIMAGE);                                   // Tell the CoProcessor to prepare for compressed data
-  Send_CMD(BaseAdd);                                         // This is the address where decompressed data will go 
-  Send_CMD(Options);                                         // Send options (options are mostly not obviously useful)
+  if (Asset)                                                 // Already in flash so Eve can decode it herself
+    return (FlashStore_LoadImage(BaseAdd, Asset->FlashAdd, Options));
 
-  while (Remaining)
-  {
-    if (Remaining > COPYBUFSIZE)
-      ReadBlockSize = COPYBUFSIZE;
-    else
-      ReadBlockSize = Remaining;
-    
-    FileReadBuf(LogBuf, ReadBlockSize);                      // Read a block of data from the file
-    CoProWrCmdBuf(LogBuf, ReadBlockSize);                    // write the block to FIFO - Does FIFO triggering
-    Remaining -= ReadBlockSize;                              // Reduce remaining data value by amount just read
-  }
-  FileClose();
-
-  Wait4CoProFIFOEmpty();                                     // wait here until the coprocessor has read and executed every pending command.
+  if (!Loader_Stream(filename, LOADER_SINK_CMD, 0, Cmd, 3, &Stats))
+    return false;
+  Loader_LogStats(&Stats);
+  Perf_AddUpload(Stats.ElapsedMs * 1000);
 
-  // Get the address of the last RAM location used during inflation
-  Cmd_GetPtr();                                              // FifoWriteLocation is updated twice so the data is returned to it's updated location - 4
-  UpdateFIFO();                                              // force run the GetPtr command
-  return (rd32(FifoWriteLocation + RAM_CMD - 4));            // The result is stored at the FifoWriteLocation - 4 (Yes, this is unexpected and random)
+  // Get the address of the last RAM location used during the decode
+  return (CoProGetPtr());
 }         
 
-// Load a raw (image data) bitmap from SD card into RAM_G at address 0
-// The file will have been processed by "img_cvt.exe" from FTDI
+// Load a raw (image data) bitmap from SD card into RAM_G at address "BaseAdd"
+// The file will have been processed by "img_cvt.exe" from FTDI (or tools/imgcvt)
 // While the memory usage is not a mystery, the next available address is returned for convenience.
 uint32_t Load_RAW(uint32_t BaseAdd, char *filename)                                 
 {
-  uint32_t Remaining;
-  uint16_t ReadBlockSize = 0;
-  uint32_t Add_GRAM = BaseAdd;
+  LoaderStats Stats;
+  FlashAsset *Asset = FlashStore_Find(filename);
 
-  // Open the file on SD card by name
-  FileOpen(filename, FILEREAD);
-  if(!myFileIsOpen())
-  {
-    Log("%s not open\n", filename);
-    FileClose();
+  if (Asset)                                                   // Already in flash so Eve can copy it herself
+    return (FlashStore_Read(BaseAdd, Asset->FlashAdd, Asset->Size));
+
+  if (!Loader_Stream(filename, LOADER_SINK_RAMG, BaseAdd, 0, 0, &Stats))
     return false;
-  }
-  
-  Remaining = FileSize();                                      // Store the size of the currently opened file
+  Loader_LogStats(&Stats);
+  Perf_AddUpload(Stats.ElapsedMs * 1000);
+  return (BaseAdd + Stats.Bytes);
+}
 
-  while (Remaining)
-  {
-    if (Remaining > COPYBUFSIZE)
-      ReadBlockSize = COPYBUFSIZE;
-    else
-      ReadBlockSize = Remaining;
-    
-    FileReadBuf(LogBuf, ReadBlockSize);                        // Read a block of data from the file
-    Add_GRAM = WriteBlockRAM(Add_GRAM, LogBuf, ReadBlockSize); // write the block to RAM_G
-    Remaining -= ReadBlockSize;                                // Reduce remaining data value by amount just read
-  }
-  FileClose();
-  return (Add_GRAM);
+// Load a paletted bitmap made by tools/imgcvt with -f PALETTED565, PALETTED4444 or PALETTED8: the palette
+// from lutname at BaseAdd (the PALETTE_SOURCE), then the indices from filename (inflated if it ends in .bin).
+// IndexAdd is set to where the indices went (the BITMAP_SOURCE).  Returns the next available RAM_G address,
+// or 0 if either file did not load.
+uint32_t Load_Paletted(uint32_t BaseAdd, char *filename, char *lutname, uint32_t *IndexAdd)
+{
+  uint32_t End = Load_RAW(BaseAdd, lutname);
+  uint16_t Len = strlen(filename);
+
+  *IndexAdd = 0;
+  if (!End)
+    return 0;
+  *IndexAdd = (End + 3) & ~3UL;                                      // 4 byte aligned, like everything Eve writes
+  if ((Len > 4) && !strcmp(filename + Len - 4, ".bin"))
+    return (Load_ZLIB(*IndexAdd, filename));
+  return (Load_RAW(*IndexAdd, filename));
 }
 
 // Is there a physical key press?
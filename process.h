@@ -16,8 +16,10 @@ extern "C" {
 #define SCR_BMP               4
 #define SCR_JPG               5
 #define SCR_RAW               6
+#define SCR_PAL               7
 
 void MakeScreen_Bitmap(uint8_t *filename, uint16_t Xsize, uint16_t Ysize, uint16_t Xloc, uint16_t Yloc, uint8_t Reference);
+void MakeScreen_Paletted(char *filename, char *lutname, uint16_t fmt, uint16_t Xsize, uint16_t Ysize, uint16_t Xloc, uint16_t Yloc, uint8_t Reference);
 void MakeScreen_Bitmap_DL(uint8_t *filename, uint16_t Xsize, uint16_t Ysize, uint16_t Xloc, uint16_t Yloc, uint8_t Reference);
 uint32_t Load_JPG(uint32_t BaseAdd, uint32_t Options, char *filename); 
 void MakeScreen_Button(void);
@@ -26,6 +28,8 @@ void SelectScreen(uint8_t ID);
 uint8_t CheckKeys(void);
 uint32_t Load_ZLIB(uint32_t BaseAdd, char *filename);
 uint32_t Load_RAW(uint32_t BaseAdd, char *filename); 
+uint32_t Load_Paletted(uint32_t BaseAdd, char *filename, char *lutname, uint32_t *IndexAdd);
+void FlashAssets_Init(void);
 
 #ifdef __cplusplus
 }
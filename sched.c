@@ -0,0 +1,144 @@
+// Cooperative task scheduler.  All function calls are hardware ambivalent.
+//
+// Tasks are plain functions which do a little work and return.  Each runs every PeriodMs (or once, for a
+// timer) and nothing preempts anything, so tasks never need to worry about each other - but a task which
+// blocks holds up everyone.  When nothing is due the idle hook is called with the time the next task is due,
+// which is the place to sleep the processor.
+//
+// All times are HAL_Millis() and compared with TIME_REACHED(), so the wrap at 2^32 ms (49 days) is harmless.
+// A task which falls more than a whole period behind is not run repeatedly to catch up; it skips to the next
+// period from now.  How late each task runs (jitter) and how long it takes are recorded for Sched_LogStats().
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "dlog.h"                // Deferred logging
+#include "sched.h"               // Every c file has it's header and this is the one for this file
+
+static SchedTask Tasks[SCHED_MAX_TASKS];
+static SchedIdleFunc IdleHook;
+
+// Add a periodic task, first run PhaseMs from now.  Spreading the phases of tasks with the same period stops
+// them all landing in the same pass.  Returns the task number, or -1 if the table is full.
+int8_t Sched_Add(const char *Name, SchedFunc Run, uint32_t PeriodMs, uint32_t PhaseMs)
+{
+  int8_t n;
+
+  for (n = 0; n < SCHED_MAX_TASKS; n++)
+  {
+    if (!Tasks[n].Run)
+    {
+      memset(&Tasks[n], 0, sizeof(SchedTask));
+      Tasks[n].Name = Name;
+      Tasks[n].Run = Run;
+      Tasks[n].Period = PeriodMs;
+      Tasks[n].Next = HAL_Millis() + PhaseMs;
+      return n;
+    }
+  }
+  DLOG0(SCHED_FULL);
+  return -1;
+}
+
+// Run a function once, DelayMs from now
+int8_t Sched_Timer(const char *Name, SchedFunc Run, uint32_t DelayMs)
+{
+  return (Sched_Add(Name, Run, 0, DelayMs));
+}
+
+void Sched_Remove(int8_t Task)
+{
+  if ((Task >= 0) && (Task < SCHED_MAX_TASKS))
+    Tasks[Task].Run = 0;
+}
+
+void Sched_SetPeriod(int8_t Task, uint32_t PeriodMs)
+{
+  if ((Task >= 0) && (Task < SCHED_MAX_TASKS))
+    Tasks[Task].Period = PeriodMs;
+}
+
+void Sched_SetIdle(SchedIdleFunc Idle)
+{
+  IdleHook = Idle;
+}
+
+// One pass: run everything that is due.  Returns true if anything ran.
+bool Sched_RunOnce(void)
+{
+  SchedTask *t;
+  uint32_t Now, Late, Start, Took;
+  bool Ran = false;
+  uint8_t n;
+
+  for (n = 0; n < SCHED_MAX_TASKS; n++)
+  {
+    t = &Tasks[n];
+    Now = HAL_Millis();
+    if (!t->Run || !TIME_REACHED(Now, t->Next))
+      continue;
+
+    Late = Now - t->Next;
+    t->LateMsTotal += Late;
+    if (Late > t->LateMsMax)
+      t->LateMsMax = Late;
+
+    if (t->Period)
+      t->Next = (Late >= t->Period) ? (Now + t->Period) : (t->Next + t->Period);  // Skip rather than burst
+
+    Start = HAL_Micros();
+    t->Run();
+    Took = HAL_Micros() - Start;
+
+    t->Runs++;
+    t->RunUsTotal += Took;
+    if (Took > t->RunUsMax)
+      t->RunUsMax = Took;
+    if (!t->Period)                                                  // A timer only runs once
+      t->Run = 0;
+    Ran = true;
+  }
+  return (Ran);
+}
+
+// The main loop.  Never returns.
+void Sched_Run(void)
+{
+  uint32_t Until = 0;
+  uint8_t n;
+  bool Any;
+
+  while (1)
+  {
+    if (Sched_RunOnce() || !IdleHook)
+      continue;
+
+    // Nothing was due - let the idle hook have the time up to the next task
+    Any = false;
+    for (n = 0; n < SCHED_MAX_TASKS; n++)
+    {
+      if (Tasks[n].Run && (!Any || !TIME_REACHED(Tasks[n].Next, Until)))
+      {
+        Until = Tasks[n].Next;
+        Any = true;
+      }
+    }
+    if (Any && !TIME_REACHED(HAL_Millis(), Until))
+      IdleHook(Until);
+  }
+}
+
+void Sched_LogStats(void)
+{
+  SchedTask *t;
+  uint8_t n;
+
+  for (n = 0; n < SCHED_MAX_TASKS; n++)
+  {
+    t = &Tasks[n];
+    if (!t->Run || !t->Runs)
+      continue;
+    Log("%s: %lu runs %lu/%lu us\n", t->Name, t->Runs, t->RunUsTotal / t->Runs, t->RunUsMax);
+    Log("  late %lu/%lu ms\n", t->LateMsTotal / t->Runs, t->LateMsMax);
+  }
+}
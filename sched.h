@@ -0,0 +1,45 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+#define SCHED_MAX_TASKS       8
+
+// Wrap safe time comparison: true once time a has reached time b.  Good for intervals up to 24 days.
+#define TIME_REACHED(a, b)    ((int32_t)((uint32_t)(a) - (uint32_t)(b)) >= 0)
+
+typedef void (*SchedFunc)(void);
+typedef void (*SchedIdleFunc)(uint32_t UntilMs);
+
+typedef struct
+{
+  const char *Name;
+  SchedFunc Run;
+  uint32_t Period;               // ms, 0 for a one shot timer
+  uint32_t Next;                 // HAL_Millis() when it is next due
+  uint32_t Runs;
+  uint32_t RunUsTotal;           // Time spent running - divide by Runs for the average
+  uint32_t RunUsMax;
+  uint32_t LateMsTotal;          // Jitter: how late it ran compared with when it was due
+  uint32_t LateMsMax;
+} SchedTask;
+
+int8_t Sched_Add(const char *Name, SchedFunc Run, uint32_t PeriodMs, uint32_t PhaseMs);
+int8_t Sched_Timer(const char *Name, SchedFunc Run, uint32_t DelayMs);
+void Sched_Remove(int8_t Task);
+void Sched_SetPeriod(int8_t Task, uint32_t PeriodMs);
+void Sched_SetIdle(SchedIdleFunc Idle);
+bool Sched_RunOnce(void);
+void Sched_Run(void);
+void Sched_LogStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,224 @@
+// Screenshots.  All function calls are hardware ambivalent.
+//
+// Eve draws the screen into RAM_G with CMD_SNAPSHOT, and it is read back in bursts of SHOT_BUFSZ bytes.  Each
+// burst is turned into 24 bit colour and run length coded as it arrives, and the output goes to the file in
+// SHOT_OUTSZ pieces, so nothing the size of a frame is ever held on the host.  The file is a run length coded
+// TGA (type 10), which most image viewers open and which costs next to nothing to write.
+//
+// CMD_SNAPSHOT wants room for the whole frame (ARGB4, 2 bytes a pixel - 255K at 480x272).  A BT81x has
+// CMD_SNAPSHOT2, which takes any rectangle, so there the frame is taken in strips of as many lines as fit in the
+// scratch space, and the 4K working block will do.  The default SHOT_SCRATCH (shot.h) holds a whole frame, so it
+// suits either.  The display is stopped (REG_PCLK = 0) while Eve takes each snapshot, as she needs the time the
+// display would be using, so the screen blanks briefly.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <string.h>              // memset
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "dlog.h"                // Deferred logging
+#include "shot.h"                // Every c file has it's header and this is the one for this file
+
+static ShotStats *Cur;
+static uint8_t Out[SHOT_OUTSZ];
+static uint16_t OutLen;
+static uint8_t Raw[SHOT_RAW_MAX * 3];                                // Pixels waiting to go out as one raw packet
+static uint8_t RawCount;
+static uint32_t Run;                                                 // The pixel being repeated, as B, G, R
+static uint8_t RunCount;
+
+static void Shot_Drain(void)
+{
+  uint32_t Start = HAL_Micros();
+
+  FileWriteBuf(Out, OutLen);
+  Cur->WriteUs += HAL_Micros() - Start;
+  Cur->Bytes += OutLen;
+  OutLen = 0;
+}
+
+static void Shot_Put(const uint8_t *Data, uint16_t Len)
+{
+  while (Len--)
+  {
+    Out[OutLen++] = *Data++;
+    if (OutLen == SHOT_OUTSZ)
+      Shot_Drain();
+  }
+}
+
+static void Shot_FlushRaw(void)
+{
+  uint8_t Head;
+
+  if (!RawCount)
+    return;
+  Head = RawCount - 1;
+  Shot_Put(&Head, 1);
+  Shot_Put(Raw, RawCount * 3);
+  RawCount = 0;
+}
+
+// A single pixel joins the raw packet, a repeat becomes a run packet of its own
+static void Shot_FlushRun(void)
+{
+  uint8_t Packet[4];
+
+  if (RunCount == 1)
+  {
+    Raw[RawCount * 3] = Run;
+    Raw[RawCount * 3 + 1] = Run >> 8;
+    Raw[RawCount * 3 + 2] = Run >> 16;
+    if (++RawCount == SHOT_RAW_MAX)
+      Shot_FlushRaw();
+  }
+  else if (RunCount)
+  {
+    Shot_FlushRaw();
+    Packet[0] = 0x80 | (RunCount - 1);
+    Packet[1] = Run;
+    Packet[2] = Run >> 8;
+    Packet[3] = Run >> 16;
+    Shot_Put(Packet, 4);
+  }
+  RunCount = 0;
+}
+
+static void Shot_Pixel(uint32_t Pixel)
+{
+  if (RunCount && (Pixel == Run) && (RunCount < 128))
+    RunCount++;
+  else
+  {
+    Shot_FlushRun();
+    Run = Pixel;
+    RunCount = 1;
+  }
+}
+
+// Eve's 16 bit pixel as B, G, R with the bits repeated down, so full scale stays full scale
+static uint32_t Shot_Colour(uint16_t Pixel, uint8_t fmt)
+{
+  uint8_t r, g, b;
+
+  if (fmt == ARGB4)
+  {
+    r = ((Pixel >> 8) & 0x0F) * 0x11;
+    g = ((Pixel >> 4) & 0x0F) * 0x11;
+    b = (Pixel & 0x0F) * 0x11;
+  }
+  else
+  {
+    r = (Pixel >> 11) << 3;
+    r |= r >> 5;
+    g = ((Pixel >> 5) & 0x3F) << 2;
+    g |= g >> 6;
+    b = (Pixel & 0x1F) << 3;
+    b |= b >> 5;
+  }
+  return (b | ((uint32_t)g << 8) | ((uint32_t)r << 16));
+}
+
+// Take a screenshot of whatever is on the display into filename.  Scratch is the RAM_G it may use, which
+// must hold the whole frame on an FT81x and a line or more on a BT81x.  Returns false if it could not.
+bool Shot_Capture(char *filename, uint32_t Scratch, uint32_t ScratchSize, ShotStats *Stats)
+{
+  uint8_t Buf[SHOT_BUFSZ];
+  uint8_t Header[18];
+  uint16_t Width = Display_Width();
+  uint16_t Height = Display_Height();
+  uint32_t LineBytes = (uint32_t)Width * 2;
+  uint32_t Start = HAL_Millis(), Us, Add, Left, Chunk;
+  uint16_t Lines, Strip, y, x = 0, n;
+  uint8_t fmt, Pclk;
+
+  memset(Stats, 0, sizeof(ShotStats));
+  Cur = Stats;
+  OutLen = 0;
+  RawCount = 0;
+  RunCount = 0;
+
+  if (ScratchSize >= LineBytes * Height)
+  {
+    Lines = Height;                                                  // One CMD_SNAPSHOT does it
+    fmt = ARGB4;
+  }
+  else if (IS_BT81X(EveCurrent->Chip) && (ScratchSize >= LineBytes))
+  {
+    Lines = ScratchSize / LineBytes;
+    fmt = RGB565;
+  }
+  else
+  {
+    Log("Snapshot needs %lu B of RAM_G\n", (unsigned long)(LineBytes * Height));
+    return false;
+  }
+
+  FileOpen(filename, FILEWRITE);
+  if(!myFileIsOpen())
+  {
+    Log("%s not open\n", filename);
+    FileClose();
+    return false;
+  }
+
+  memset(Header, 0, sizeof(Header));
+  Header[2] = 10;                                                    // Run length coded true colour
+  Header[12] = Width;
+  Header[13] = Width >> 8;
+  Header[14] = Height;
+  Header[15] = Height >> 8;
+  Header[16] = 24;
+  Header[17] = 0x20;                                                 // Top line first
+  Shot_Put(Header, sizeof(Header));
+
+  Pclk = rd8(REG_PCLK + RAM_REG);
+  for (y = 0; y < Height; y += Strip)
+  {
+    Strip = ((Height - y) < Lines) ? (Height - y) : Lines;
+
+    Us = HAL_Micros();
+    wr8(REG_PCLK + RAM_REG, 0);
+    if (fmt == ARGB4)
+      Cmd_Snapshot(Scratch);
+    else
+      Cmd_Snapshot2(RGB565, Scratch, 0, y, Width, Strip);
+    UpdateFIFO();
+    Wait4CoProFIFOEmpty();
+    wr8(REG_PCLK + RAM_REG, Pclk);
+    Stats->SnapUs += HAL_Micros() - Us;
+    Stats->Strips++;
+
+    // Bursts and lines are both whole pixels, so a burst never splits one.  With an odd Width the last burst of
+    // a strip is not whole words, which a read from RAM_G does not mind.
+    for (Add = Scratch, Left = LineBytes * Strip; Left; Add += Chunk, Left -= Chunk)
+    {
+      Chunk = (Left > SHOT_BUFSZ) ? SHOT_BUFSZ : Left;
+      Us = HAL_Micros();
+      ReadBlockRAM(Add, Buf, Chunk);
+      Stats->ReadUs += HAL_Micros() - Us;
+
+      for (n = 0; n < Chunk; n += 2)
+      {
+        Shot_Pixel(Shot_Colour(Buf[n] | ((uint16_t)Buf[n + 1] << 8), fmt));
+        if (++x == Width)                                            // TGA packets may not run past the end of a line
+        {
+          Shot_FlushRun();
+          Shot_FlushRaw();
+          x = 0;
+        }
+      }
+    }
+  }
+
+  Shot_Drain();
+  FileClose();
+  Stats->ElapsedMs = HAL_Millis() - Start;
+  return true;
+}
+
+void Shot_LogStats(char *filename, ShotStats *Stats)
+{
+  Log("Shot %s\n", filename);
+  DLOG3(SHOT_DONE, Stats->Bytes, Stats->ElapsedMs, Stats->Strips);
+  DLOG3(SHOT_TIME, Stats->SnapUs, Stats->ReadUs, Stats->WriteUs);
+}
@@ -0,0 +1,49 @@
+#ifndef SHOT_H
+#define SHOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+#ifndef SHOT_BUFSZ
+#define SHOT_BUFSZ            64         // Bytes read back from RAM_G in one burst, a multiple of 4.  Bigger is faster.
+#endif
+#ifndef SHOT_OUTSZ
+#define SHOT_OUTSZ            64         // Bytes of file collected before each write
+#endif
+#define SHOT_RAW_MAX          32         // Pixels in one uncompressed TGA packet (128 at most)
+
+// Where the snapshot goes unless told otherwise.  An FT81x needs the whole frame at once, 2 bytes a pixel (255K
+// at 480x272), and everything below 0xC0000 belongs to one screen or another (process.c), so the default runs
+// from there to 0xFFC00.  That is over the PCM ring, the video media FIFO and the first 3K of the working block
+// (RAM_G_WORKING), so do not capture while sound or video is playing.  The font and flash helpers only borrow
+// the working block while they run, which they never do during a capture.  A BT81x takes the frame in strips
+// and gets by with as little as SHOT_SCRATCH = RAM_G_WORKING, size 4096.
+#ifndef SHOT_SCRATCH
+#define SHOT_SCRATCH          (RAM_G + 0xC0000UL)
+#endif
+#ifndef SHOT_SCRATCH_SIZE
+#define SHOT_SCRATCH_SIZE     (480UL * 272UL * 2UL)
+#endif
+
+typedef struct
+{
+  uint32_t Bytes;                // File size
+  uint16_t Strips;               // Snapshots taken
+  uint32_t SnapUs;               // Eve taking the snapshots, with the display stopped
+  uint32_t ReadUs;               // Reading them back over SPI
+  uint32_t WriteUs;              // Writing the file
+  uint32_t ElapsedMs;            // The lot, conversion and compression included
+} ShotStats;
+
+bool Shot_Capture(char *filename, uint32_t Scratch, uint32_t ScratchSize, ShotStats *Stats);
+void Shot_LogStats(char *filename, ShotStats *Stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
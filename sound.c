@@ -0,0 +1,133 @@
+// Sound effects.  All function calls are hardware ambivalent.
+//
+// Sound_Play() never waits for a sound to finish.  Sounds are queued, and Sound_Service(), called regularly
+// (it is a scheduler task), starts the next one when Eve is done with the last.  It also looks after the audio
+// amplifier: on before a sound starts, off once nothing has played for SOUND_AMP_HOLD_MS.  Keeping it on for
+// a moment stops it clicking on and off between notes.
+//
+// Completion is found by reading REG_PLAY, one register read per service and only while a sound is playing.
+// Eve can raise INT_SOUND instead, but REG_INT_FLAGS clears on read and input.c already owns it for the tag
+// interrupt, so polling is simpler and costs next to nothing.
+//
+// The volume is remembered so that REG_VOL_SOUND is only written when it changes.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "sound.h"               // Every c file has it's header and this is the one for this file
+
+typedef struct
+{
+  uint8_t Sound;
+  uint8_t Note;
+  uint8_t Volume;
+} SoundEntry;
+
+static SoundEntry Queue[SOUND_QUEUE_SIZE];
+static uint8_t QueueHead, QueueCount;
+static bool Playing;
+static bool AmpOn;
+static bool AmpHeld;                                                 // Someone else (PCM playback) needs the amplifier
+static uint8_t Volume;
+static uint32_t LastPlayed;                                          // HAL_Millis() when the last sound ended
+
+void Sound_Init(void)
+{
+  QueueHead = QueueCount = 0;
+  Playing = false;
+  AmpOn = false;
+  AmpHeld = false;
+  SetPin(EveAudioEnable_PIN, false);
+  Volume = rd8(REG_VOL_SOUND + RAM_REG);
+}
+
+static void Sound_Start(SoundEntry *s)
+{
+  if (!AmpOn)
+  {
+    SetPin(EveAudioEnable_PIN, true);                                // Enable Audio
+    AmpOn = true;
+  }
+  if (s->Volume != Volume)                                           // Only when it changes
+  {
+    wr8(REG_VOL_SOUND + RAM_REG, s->Volume);
+    Volume = s->Volume;
+  }
+  wr16(REG_SOUND + RAM_REG, ((uint16_t)s->Note << 8) | s->Sound);
+  wr8(REG_PLAY + RAM_REG, 1);                                        // Play the sound
+  Playing = true;
+}
+
+// Play a sound, or queue it behind the ones already playing.  Now drops anything queued and plays it at once,
+// which is what touch feedback wants.  Returns false if the queue is full.
+bool Sound_Play(uint8_t Sound, uint8_t Note, uint8_t Volume, bool Now)
+{
+  SoundEntry s;
+
+  s.Sound = Sound;
+  s.Note = Note;
+  s.Volume = Volume;
+
+  if (Now || (!Playing && !QueueCount))
+  {
+    QueueCount = 0;
+    Sound_Start(&s);                                                 // Writing REG_PLAY cuts off whatever is playing
+    return true;
+  }
+  if (QueueCount == SOUND_QUEUE_SIZE)
+    return false;
+  Queue[(QueueHead + QueueCount++) % SOUND_QUEUE_SIZE] = s;
+  return true;
+}
+
+// Silence, and forget anything queued
+void Sound_Stop(void)
+{
+  QueueCount = 0;
+  wr16(REG_SOUND + RAM_REG, SOUND_SILENCE);
+  wr8(REG_PLAY + RAM_REG, 1);
+  Playing = false;
+  LastPlayed = HAL_Millis();
+}
+
+// Keep the amplifier on for audio which does not come through here (PCM playback).  Sound_Service() turns it
+// off in the usual way once released.
+void Sound_AmpHold(bool Hold)
+{
+  AmpHeld = Hold;
+  if (Hold && !AmpOn)
+  {
+    SetPin(EveAudioEnable_PIN, true);                                // Enable Audio
+    AmpOn = true;
+  }
+  LastPlayed = HAL_Millis();
+}
+
+bool Sound_Busy(void)
+{
+  return (Playing || QueueCount);
+}
+
+// Call regularly - every 10 to 20ms keeps the gap between queued sounds short
+void Sound_Service(void)
+{
+  if (Playing)
+  {
+    if (rd8(REG_PLAY + RAM_REG))                                     // Still going
+      return;
+    Playing = false;
+    LastPlayed = HAL_Millis();
+  }
+
+  if (QueueCount)
+  {
+    Sound_Start(&Queue[QueueHead]);
+    QueueHead = (QueueHead + 1) % SOUND_QUEUE_SIZE;
+    QueueCount--;
+  }
+  else if (AmpOn && !AmpHeld && ((HAL_Millis() - LastPlayed) >= SOUND_AMP_HOLD_MS))
+  {
+    SetPin(EveAudioEnable_PIN, false);                                 // Disable Audio
+    AmpOn = false;
+  }
+}
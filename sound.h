@@ -0,0 +1,73 @@
+#ifndef SOUND_H
+#define SOUND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+#define SOUND_QUEUE_SIZE      4
+#define SOUND_AMP_HOLD_MS     200                                    // Keep the amplifier on this long after the last sound
+
+// Sound effects - FT81x Series Programmers Guide Section 4.4, Table 4-3
+#define SOUND_SILENCE         0x00
+#define SOUND_SQUAREWAVE      0x01                                   // These are continuous - stop them with Sound_Stop()
+#define SOUND_SINEWAVE        0x02
+#define SOUND_SAWTOOTH        0x03
+#define SOUND_TRIANGLE        0x04
+#define SOUND_BEEPING         0x05
+#define SOUND_ALARM           0x06
+#define SOUND_WARBLE          0x07
+#define SOUND_CAROUSEL        0x08
+#define SOUND_PIPS(n)         (0x0F + (n))                           // 1 to 16 pips
+#define SOUND_HARP            0x40                                   // Instruments play Note
+#define SOUND_XYLOPHONE       0x41
+#define SOUND_TUBA            0x42
+#define SOUND_GLOCKENSPIEL    0x43
+#define SOUND_ORGAN           0x44
+#define SOUND_TRUMPET         0x45
+#define SOUND_PIANO           0x46
+#define SOUND_CHIMES          0x47
+#define SOUND_MUSICBOX        0x48
+#define SOUND_BELL            0x49
+#define SOUND_CLICK           0x50
+#define SOUND_SWITCH          0x51
+#define SOUND_COWBELL         0x52
+#define SOUND_NOTCH           0x53
+#define SOUND_HIHAT           0x54
+#define SOUND_KICKDRUM        0x55
+#define SOUND_POP             0x56
+#define SOUND_CLACK           0x57
+#define SOUND_CHACK           0x58
+#define SOUND_MUTE            0x60
+#define SOUND_UNMUTE          0x61
+
+// Notes are MIDI note numbers, e.g. MIDI_NOTE(NOTE_C, 4) is middle C
+#define MIDI_NOTE(note, octave)  (((octave) + 1) * 12 + (note))
+#define NOTE_C                0
+#define NOTE_CS               1
+#define NOTE_D                2
+#define NOTE_DS               3
+#define NOTE_E                4
+#define NOTE_F                5
+#define NOTE_FS               6
+#define NOTE_G                7
+#define NOTE_GS               8
+#define NOTE_A                9
+#define NOTE_AS               10
+#define NOTE_B                11
+
+void Sound_Init(void);
+bool Sound_Play(uint8_t Sound, uint8_t Note, uint8_t Volume, bool Now);
+void Sound_Stop(void);
+bool Sound_Busy(void);
+void Sound_AmpHold(bool Hold);
+void Sound_Service(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
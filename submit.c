@@ -0,0 +1,191 @@
+// Command submission from several threads.  All function calls are hardware ambivalent.
+//
+// Send_CMD() and the FIFO write pointer belong to whichever thread talks to the panel, so other threads can not
+// simply call the Cmd_ functions.  Instead a producer thread records its commands into a batch of its own
+// (Eve_RecordStart() in the library does the recording, nothing touches the bus) and queues the batch.  The one
+// thread which owns the bus calls Submit_Drain() whenever it likes, which packs whatever is queued into bursts
+// and writes each burst into the FIFO in as few SPI transfers as the FIFO space allows.
+//
+// The queue is a lock free intrusive MPSC list (producers swap themselves onto the head, the bus owner walks
+// from the tail) so a producer never waits for the bus or for another producer.  A batch is always written
+// whole and nothing from another batch gets in between, so a batch holding CMD_DLSTART through CMD_SWAP is one
+// frame, intact.  Each batch goes back to its producer (Submit_Idle()) once it is in the FIFO; a producer
+// which wants to keep going while one batch is queued builds the next in a second one.
+//
+// Built with EVE_THREADS only, which means a GCC or Clang host (the __atomic builtins), and one with the same
+// byte order as Eve since recorded words are written as bytes.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdio.h>               // printf - Log() shares one buffer between threads, so it is not used here
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "submit.h"              // Every c file has it's header and this is the one for this file
+
+#if defined(EVE_THREADS)
+
+static SubmitBatch Stub;                                             // Keeps the list from ever being empty
+static SubmitBatch *Head = &Stub;                                    // Producers swap themselves in here
+static SubmitBatch *Tail = &Stub;                                    // Only the bus owner touches this
+static uint32_t Burst[SUBMIT_BURST_WORDS];
+static SubmitStats Stats;                                            // Written by the bus owner only (Overflows aside)
+static const uint16_t BinEdgeUs[SUBMIT_BINS - 1] = { 50, 100, 200, 500, 1000, 2000, 5000 };
+
+static void Push(SubmitBatch *Batch)
+{
+  SubmitBatch *Prev;
+
+  __atomic_store_n(&Batch->Next, (SubmitBatch *)0, __ATOMIC_RELAXED);
+  Prev = __atomic_exchange_n(&Head, Batch, __ATOMIC_ACQ_REL);
+  __atomic_store_n(&Prev->Next, Batch, __ATOMIC_RELEASE);           // Between the two the list is briefly broken here
+}
+
+// Take the oldest batch, or 0 if there is none - or if the newest is half way through being pushed, in which
+// case it comes out next time.
+static SubmitBatch *Pop(void)
+{
+  SubmitBatch *t = Tail, *Next = __atomic_load_n(&t->Next, __ATOMIC_ACQUIRE);
+
+  if (t == &Stub)
+  {
+    if (!Next)
+      return 0;
+    Tail = t = Next;
+    Next = __atomic_load_n(&t->Next, __ATOMIC_ACQUIRE);
+  }
+  if (Next)
+  {
+    Tail = Next;
+    return (t);
+  }
+  if (t != __atomic_load_n(&Head, __ATOMIC_ACQUIRE))
+    return 0;
+  Push(&Stub);                                                       // t is the last one, put the stub behind it
+  Next = __atomic_load_n(&t->Next, __ATOMIC_ACQUIRE);
+  if (Next)
+  {
+    Tail = Next;
+    return (t);
+  }
+  return 0;
+}
+
+// Start recording a batch on this thread.  Returns false if the batch is still queued from last time.
+bool Submit_Begin(SubmitBatch *Batch, uint8_t Producer)
+{
+  if (!Submit_Idle(Batch))
+    return false;
+  Batch->Producer = Producer;
+  Eve_RecordStart(Batch->Words, SUBMIT_BATCH_WORDS);
+  return true;
+}
+
+// Stop recording and queue the batch.  A batch which overflowed is not queued and false is returned.
+bool Submit_End(SubmitBatch *Batch)
+{
+  Batch->Count = Eve_RecordStop();
+  if (!Batch->Count)
+  {
+    __atomic_add_fetch(&Stats.Overflows, 1, __ATOMIC_RELAXED);
+    return false;
+  }
+  Batch->QueuedUs = HAL_Micros();
+  __atomic_store_n(&Batch->Busy, 1, __ATOMIC_RELAXED);
+  Push(Batch);
+  return true;
+}
+
+// True when the batch is the producer's again
+bool Submit_Idle(SubmitBatch *Batch)
+{
+  return (!__atomic_load_n(&Batch->Busy, __ATOMIC_ACQUIRE));
+}
+
+// Write Count words to the FIFO and hand the batches they came from back
+static void Flush(SubmitBatch **Batches, uint8_t n, const uint32_t *Words, uint32_t Count)
+{
+  SubmitProducer *p;
+  uint32_t Start = HAL_Micros(), Now, Us;
+  uint8_t i, Bin;
+
+  CoProWrCmdBuf((const uint8_t *)Words, Count * 4);
+  Now = HAL_Micros();
+  Stats.Bursts++;
+  Stats.Bytes += Count * 4;
+  Stats.BusUs += Now - Start;
+
+  for (i = 0; i < n; i++)
+  {
+    p = &Stats.Producer[Batches[i]->Producer % SUBMIT_PRODUCERS];
+    Us = Now - Batches[i]->QueuedUs;
+    for (Bin = 0; (Bin < SUBMIT_BINS - 1) && (Us >= BinEdgeUs[Bin]); Bin++)
+      ;
+    p->Count[Bin]++;
+    p->Batches++;
+    p->TotalUs += Us;
+    if (Us > p->MaxUs)
+      p->MaxUs = Us;
+    __atomic_store_n(&Batches[i]->Busy, 0, __ATOMIC_RELEASE);       // The producer may have it back
+  }
+}
+
+// Bus owner only: write everything queued into the FIFO.  Returns the number of batches written.
+uint32_t Submit_Drain(void)
+{
+  SubmitBatch *b, *InBurst[SUBMIT_BURST_BATCHES];
+  uint32_t Words = 0, Drained = 0;
+  uint8_t n = 0;
+
+  while ((b = Pop()) != 0)
+  {
+    if (n && ((n == SUBMIT_BURST_BATCHES) || (Words + b->Count > SUBMIT_BURST_WORDS)))
+    {
+      Flush(InBurst, n, Burst, Words);
+      n = 0;
+      Words = 0;
+    }
+    if (b->Count > SUBMIT_BURST_WORDS)                              // Too big to pack, so it is a burst by itself
+      Flush(&b, 1, b->Words, b->Count);
+    else
+    {
+      memcpy(&Burst[Words], b->Words, b->Count * 4);
+      Words += b->Count;
+      InBurst[n++] = b;
+    }
+    Drained++;
+  }
+  if (n)
+    Flush(InBurst, n, Burst, Words);
+  Stats.Batches += Drained;
+  return (Drained);
+}
+
+const SubmitStats *Submit_GetStats(void)
+{
+  return (&Stats);
+}
+
+void Submit_LogStats(void)
+{
+  SubmitProducer *p;
+  uint8_t i;
+
+  printf("Submit %lu batches %lu bursts\n", (unsigned long)Stats.Batches, (unsigned long)Stats.Bursts);
+  if (Stats.BusUs)
+    printf(" %lu bytes %lu KB/s\n", (unsigned long)Stats.Bytes,
+           (unsigned long)((uint64_t)Stats.Bytes * 1000 / Stats.BusUs / 1024));
+  if (Stats.Overflows)
+    printf(" %lu overflowed\n", (unsigned long)Stats.Overflows);
+  printf("us <50 <100 <200 <500 <1k <2k <5k more\n");
+  for (i = 0; i < SUBMIT_PRODUCERS; i++)
+  {
+    p = &Stats.Producer[i];
+    if (!p->Batches)
+      continue;
+    printf(" %u: %lu avg %lu max %lu", i, (unsigned long)p->Batches, (unsigned long)(p->TotalUs / p->Batches),
+           (unsigned long)p->MaxUs);
+    printf(" %u %u %u %u %u %u %u %u\n", p->Count[0], p->Count[1], p->Count[2], p->Count[3],
+           p->Count[4], p->Count[5], p->Count[6], p->Count[7]);
+  }
+}
+
+#endif
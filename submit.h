@@ -0,0 +1,63 @@
+#ifndef SUBMIT_H
+#define SUBMIT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// Command submission from several threads (EVE_THREADS builds).  Producer threads record batches of commands
+// and queue them; one thread owns the bus and drains the queue into the FIFO.
+#ifndef SUBMIT_BATCH_WORDS
+#define SUBMIT_BATCH_WORDS    1024                                   // Largest batch (4K, the size of the FIFO)
+#endif
+#ifndef SUBMIT_BURST_WORDS
+#define SUBMIT_BURST_WORDS    1024                                   // Small batches are packed into bursts this big
+#endif
+#define SUBMIT_BURST_BATCHES  16                                     // Batches in one burst at most
+#define SUBMIT_PRODUCERS      8                                      // Producer numbers for the statistics
+#define SUBMIT_BINS           8                                      // Bin edges are in submit.c: <50, <100 ... <5000, >=5000 us
+
+// One batch.  Owned by its producer, and by the queue from Submit_End() until Submit_Idle() says it is back.
+typedef struct SubmitBatch
+{
+  struct SubmitBatch *Next;      // The queue's link
+  uint32_t Count;                // Words recorded
+  uint32_t QueuedUs;             // HAL_Micros() when it was queued
+  uint8_t Producer;              // Whose it is, for the statistics
+  uint8_t Busy;                  // Queued and not yet in the FIFO
+  uint32_t Words[SUBMIT_BATCH_WORDS];
+} SubmitBatch;
+
+typedef struct
+{
+  uint32_t Batches;
+  uint32_t TotalUs;              // Queueing latency: from Submit_End() until the batch is in the FIFO
+  uint32_t MaxUs;
+  uint16_t Count[SUBMIT_BINS];
+} SubmitProducer;
+
+typedef struct
+{
+  uint32_t Batches;
+  uint32_t Bursts;
+  uint32_t Bytes;                // Into the FIFO
+  uint32_t BusUs;                // Time spent writing them - Bytes / BusUs is the throughput
+  uint32_t Overflows;            // Batches which did not fit in SUBMIT_BATCH_WORDS and were dropped
+  SubmitProducer Producer[SUBMIT_PRODUCERS];
+} SubmitStats;
+
+bool Submit_Begin(SubmitBatch *Batch, uint8_t Producer);
+bool Submit_End(SubmitBatch *Batch);
+bool Submit_Idle(SubmitBatch *Batch);
+uint32_t Submit_Drain(void);
+const SubmitStats *Submit_GetStats(void);
+void Submit_LogStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,219 @@
+// Text measured and laid out by the host.  All function calls are hardware ambivalent.
+//
+// Cmd_Text() has the CoProcessor look up the width of every character of the string every time it is drawn,
+// and anything that depends on how wide a string is needs a round trip to find out.  Here the widths live on
+// the host instead: read out of the ROM font metric blocks the first time a font is used (TEXT_ROM_FONTS of
+// them are kept), or taken from a font loaded with font.c.  With them strings can be measured for nothing and
+// drawn straight into the display list as one VERTEX2II per glyph, the way MakeScreen_MatrixOrbital() does by
+// hand - the CoProcessor just passes the words along.  Text_Box() wraps at spaces and clips to a box.
+//
+// Glyphs beyond x or y 511 (which VERTEX2II can not reach) are drawn with BITMAP_HANDLE, CELL and VERTEX2F, so
+// the bitmap handle may be left changed.  Spaces take their width but draw nothing.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "text.h"                // Every c file has it's header and this is the one for this file
+#include "font.h"                // Loaded fonts
+
+static TextMetrics Rom[TEXT_ROM_FONTS];
+static uint8_t RomNext;                                              // Next to be replaced
+
+// The widths and height of a font, reading them from Eve if need be.  0 for a font we know nothing of.
+static const uint8_t *Text_Metrics(uint8_t Font, uint16_t *Height)
+{
+  EveFont *Custom = Font_Find(Font);
+  TextMetrics *m;
+  uint32_t Add;
+  uint8_t n;
+
+  if (Custom)
+  {
+    *Height = Custom->Height;
+    return (Custom->Widths);
+  }
+  if ((Font < 16) || (Font > 31))
+    return 0;
+
+  for (n = 0; n < TEXT_ROM_FONTS; n++)
+  {
+    if (Rom[n].Font == Font)
+    {
+      *Height = Rom[n].Height;
+      return (Rom[n].Widths);
+    }
+  }
+  m = &Rom[RomNext];
+  RomNext = (RomNext + 1) % TEXT_ROM_FONTS;
+  Add = rd32(ROMFONT_TABLEADDRESS) + 148UL * (Font - 16);
+  ReadBlockRAM(Add, m->Widths, 128);
+  m->Height = rd32(Add + 140);
+  m->Font = Font;
+  *Height = m->Height;
+  return (m->Widths);
+}
+
+// Forget the ROM font metrics, so that they are read from Eve again (after she has been reset)
+void Text_Flush(void)
+{
+  memset(Rom, 0, sizeof(Rom));
+  RomNext = 0;
+}
+
+uint16_t Text_Width(uint8_t Font, const char *str)
+{
+  const uint8_t *Widths;
+  uint16_t Width = 0, Height;
+
+  if (!(Widths = Text_Metrics(Font, &Height)))
+    return 0;
+  for ( ; *str; str++)
+    Width += ((uint8_t)*str < 128) ? Widths[(uint8_t)*str] : 0;
+  return (Width);
+}
+
+uint16_t Text_Height(uint8_t Font)
+{
+  uint16_t Height = 0;
+
+  Text_Metrics(Font, &Height);
+  return (Height);
+}
+
+// How many characters of str fit in MaxWidth
+uint8_t Text_Fit(uint8_t Font, const char *str, uint16_t MaxWidth)
+{
+  const uint8_t *Widths;
+  uint16_t Width = 0, Height;
+  uint8_t n, c;
+
+  if (!(Widths = Text_Metrics(Font, &Height)))
+    return 0;
+  for (n = 0; str[n] && (n < 255); n++)
+  {
+    c = (uint8_t)str[n];
+    Width += (c < 128) ? Widths[c] : 0;
+    if (Width > MaxWidth)
+      break;
+  }
+  return (n);
+}
+
+// Draw up to Len characters, clipped to MaxWidth (0 for no limit).  Returns the width drawn.
+static uint16_t Text_Run(uint8_t Font, int16_t x, int16_t y, uint16_t options, uint16_t MaxWidth, const char *str, uint8_t Len)
+{
+  const uint8_t *Widths;
+  char Chars[TEXT_RUN_MAX], Cells[TEXT_RUN_MAX];
+  EveFont *Custom = Font_Find(Font);
+  uint16_t Width = 0, Height;
+  uint8_t n = 0, Mapped, i, c;
+  bool Far = false;
+
+  if (!(Widths = Text_Metrics(Font, &Height)))
+    return 0;
+  for ( ; *str && Len && (n < TEXT_RUN_MAX); str++, Len--)           // What there is to draw, and what fits
+  {
+    c = (uint8_t)*str;
+    if ((c >= 128) || !Widths[c])
+      continue;
+    if (MaxWidth && (Width + Widths[c] > MaxWidth))
+      break;
+    Chars[n++] = c;
+    Width += Widths[c];
+  }
+
+  if (Custom)                                                        // Cells are slots in the glyph cache
+  {
+    Mapped = Font_Map(Custom, Chars, n, Cells);
+    for (Width = 0, i = 0; i < Mapped; i++)                          // It may not have found a slot for them all
+      Width += Widths[(uint8_t)Chars[i]];
+  }
+  else
+  {
+    memcpy(Cells, Chars, n);
+    Mapped = n;
+  }
+
+  if (options & OPT_RIGHTX)
+    x -= Width;
+  else if (options & OPT_CENTERX)
+    x -= Width / 2;
+  if (options & OPT_CENTERY)
+    y -= Height / 2;
+
+  Send_CMD(BEGIN(BITMAPS));
+  for (i = 0; i < Mapped; i++)
+  {
+    c = (uint8_t)Chars[i];
+    if (c != ' ')
+    {
+      if ((x >= 0) && (x < 512) && (y >= 0) && (y < 512))
+        Send_CMD(VERTEX2II(x, y, Font, Cells[i]));
+      else
+      {
+        if (!Far)
+          Send_CMD(BITMAP_HANDLE(Font));
+        Far = true;
+        Send_CMD(CELL(Cells[i]));
+        Send_CMD(VERTEX2F((int32_t)x * 16, (int32_t)y * 16));
+      }
+    }
+    x += Widths[c];
+  }
+  Send_CMD(END());
+  return (Width);
+}
+
+// Draw a string like Cmd_Text() does (OPT_CENTERX, OPT_CENTERY and OPT_RIGHTX), but without the CoProcessor
+// laying it out.  Characters which would go past MaxWidth are left off (0 for no limit).  Returns the width.
+uint16_t Text_Draw(uint8_t Font, int16_t x, int16_t y, uint16_t options, uint16_t MaxWidth, const char *str)
+{
+  return (Text_Run(Font, x, y, options, MaxWidth, str, 255));
+}
+
+// Draw a string wrapped to fit a box, breaking at spaces (or anywhere, for a word too long for a line) and at
+// '\n'.  Lines which would not fit in the box whole are left off.  OPT_CENTERX and OPT_RIGHTX align each line
+// within the box.  Returns the number of lines drawn.
+uint8_t Text_Box(uint8_t Font, int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t options, const char *str)
+{
+  const uint8_t *Widths;
+  uint16_t Width, Height;
+  uint8_t n, Break, c, Lines = 0;
+  int16_t Anchor = x;
+
+  if (!(Widths = Text_Metrics(Font, &Height)))
+    return 0;
+  if (options & OPT_RIGHTX)
+    Anchor = x + w;
+  else if (options & OPT_CENTERX)
+    Anchor = x + w / 2;
+  options &= (OPT_CENTERX | OPT_RIGHTX);
+
+  while (*str && (Lines + 1) * Height <= h)
+  {
+    Width = 0;
+    Break = 0;
+    for (n = 0; str[n] && (str[n] != '\n') && (n < TEXT_RUN_MAX); n++)
+    {
+      c = (uint8_t)str[n];
+      if (c == ' ')
+        Break = n;                                                   // The line can end here
+      Width += (c < 128) ? Widths[c] : 0;
+      if (Width > w)
+        break;
+    }
+    if (str[n] && (str[n] != '\n') && Break)                         // Too long - back up to the last space
+      n = Break;
+    if (!n && str[0] && (str[0] != '\n'))                            // Not even one character fits
+      break;
+
+    Text_Run(Font, Anchor, y + Lines * Height, options, w, str, n);
+    Lines++;
+    str += n;
+    if (*str == '\n')
+      str++;
+    while (*str == ' ')
+      str++;
+  }
+  return (Lines);
+}
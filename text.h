@@ -0,0 +1,34 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+#include "font.h"                // FONT_TEXT_MAX
+
+// Text measured and laid out by the host.  See text.c.
+#define TEXT_ROM_FONTS        4                                      // ROM fonts with their widths kept here (128 bytes each)
+#define TEXT_RUN_MAX          FONT_TEXT_MAX                          // Most characters drawn on one line (font.h)
+
+typedef struct
+{
+  uint8_t Font;                  // 16 - 31, 0 for none
+  uint8_t Height;
+  uint8_t Widths[128];
+} TextMetrics;
+
+void Text_Flush(void);
+uint16_t Text_Width(uint8_t Font, const char *str);
+uint16_t Text_Height(uint8_t Font);
+uint8_t Text_Fit(uint8_t Font, const char *str, uint16_t MaxWidth);
+uint16_t Text_Draw(uint8_t Font, int16_t x, int16_t y, uint16_t options, uint16_t MaxWidth, const char *str);
+uint8_t Text_Box(uint8_t Font, int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t options, const char *str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,127 @@
+// coprof - analyse CoProcessor profiler traces on the host.
+//
+// Feed it a capture of the serial port with the output of CoProf_DumpTrace() in it (other lines are skipped).
+// Every traced command from every dump is replayed into per-command totals, a table by size, and a straight
+// line fit of time against size - the fixed cost of a command and what each character, pixel or byte adds.
+//
+// Build:  cc -O2 -o coprof coprof.c ../../eve_disasm.c
+// Usage:  coprof [-s] [capture.txt]
+//   -s  Also print the table by size (powers of 2)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../../Eve2_81x.h"
+#include "../../eve_disasm.h"
+
+#define BUCKETS               33
+
+typedef struct
+{
+  unsigned long Count;
+  double Us, Size;               // Sums, and the sums the fit needs
+  double SizeSq, SizeUs;
+  unsigned long MaxUs;
+  unsigned long BucketCount[BUCKETS];
+  double BucketUs[BUCKETS];
+} OpStats;
+
+static OpStats Ops[256];
+
+static int ByTotal(const void *a, const void *b)
+{
+  double d = Ops[*(const int *)b].Us - Ops[*(const int *)a].Us;
+  return ((d > 0) - (d < 0));
+}
+
+int main(int argc, char **argv)
+{
+  FILE *f = stdin;
+  char Line[256];
+  unsigned Offset, Op;
+  unsigned long Size, Us, Dumps = 0, Cmds = 0;
+  int opt, BySize = 0, Order[256], n, b, Used = 0;
+  double Total = 0, Slope, Fixed, Den;
+  OpStats *s;
+
+  while ((opt = getopt(argc, argv, "s")) != -1)
+  {
+    if (opt == 's')
+      BySize = 1;
+    else
+    {
+      fprintf(stderr, "usage: coprof [-s] [capture.txt]\n");
+      return 1;
+    }
+  }
+  if ((optind < argc) && !(f = fopen(argv[optind], "r")))
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  while (fgets(Line, sizeof(Line), f))
+  {
+    if (!strncmp(Line, "coprof ", 7) && strncmp(Line, "coprof end", 10))
+      Dumps++;
+    if (sscanf(Line, "C %x %x %lu %lu", &Offset, &Op, &Size, &Us) != 4)
+      continue;
+    s = &Ops[Op & 0xFF];
+    for (b = 0; (b < BUCKETS - 1) && ((Size >> b) > 1); b++)
+      ;
+    s->Count++;
+    s->Us += Us;
+    s->Size += Size;
+    s->SizeSq += (double)Size * Size;
+    s->SizeUs += (double)Size * Us;
+    if (Us > s->MaxUs)
+      s->MaxUs = Us;
+    s->BucketCount[b]++;
+    s->BucketUs[b] += Us;
+    Total += Us;
+    Cmds++;
+  }
+  if (!Cmds)
+  {
+    fprintf(stderr, "no traced commands found\n");
+    return 1;
+  }
+
+  for (n = 0; n < 256; n++)
+    if (Ops[n].Count)
+      Order[Used++] = n;
+  qsort(Order, Used, sizeof(int), ByTotal);
+
+  printf("%lu dumps, %lu commands, %.0f us\n\n", Dumps, Cmds, Total);
+  printf("%-14s %8s %10s %6s %9s %8s %12s %12s\n", "command", "count", "total us", "%", "avg us", "max us", "fixed us", "us per size");
+  for (n = 0; n < Used; n++)
+  {
+    s = &Ops[Order[n]];
+    Den = s->Count * s->SizeSq - s->Size * s->Size;
+    printf("%-14s %8lu %10.0f %6.1f %9.1f %8lu", Eve_CmdName(Order[n]), s->Count, s->Us, 100.0 * s->Us / Total,
+           s->Us / s->Count, s->MaxUs);
+    if (Den > 0)                                                     // Sizes vary, so fit us = Fixed + Slope * size
+    {
+      Slope = (s->Count * s->SizeUs - s->Size * s->Us) / Den;
+      Fixed = (s->Us - Slope * s->Size) / s->Count;
+      printf(" %12.1f %12.4f\n", Fixed, Slope);
+    }
+    else
+      printf(" %12s %12s\n", "-", "-");
+  }
+
+  if (BySize)
+  {
+    printf("\n%-14s %-8s %8s %9s\n", "command", "size", "count", "avg us");
+    for (n = 0; n < Used; n++)
+    {
+      s = &Ops[Order[n]];
+      for (b = 0; b < BUCKETS; b++)
+        if (s->BucketCount[b])
+          printf("%-14s <2^%-5d %8lu %9.1f\n", Eve_CmdName(Order[n]), b + 1, s->BucketCount[b],
+                 s->BucketUs[b] / s->BucketCount[b]);
+    }
+  }
+  return 0;
+}
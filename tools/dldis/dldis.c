@@ -0,0 +1,77 @@
+// dldis - disassemble and check a display list on the host.
+//
+// Reads a binary RAM_DL dump (little endian words, as ReadBlockRAM() or an emulator's memory dump gives them)
+// and prints each word as the Eve2_81x.h macro that makes it, along with anything wasteful: state set to what
+// it already is, BEGIN/END pairs with nothing drawn, END followed by a BEGIN of the same thing.  The checks are
+// the ones dlcheck.c runs on the device (eve_disasm.c).
+//
+// Build:  cc -O2 -o dldis dldis.c ../../eve_disasm.c
+// Usage:  dldis [-a] [-q] [-w percent] ramdl.bin
+//   -a  Keep going after DISPLAY (the rest of the 8K is whatever was there before)
+//   -q  Only print words with findings, and the summary
+//   -w  Warn when the list uses more than this much of RAM_DL (default 87)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "../../Eve2_81x.h"
+#include "../../eve_disasm.h"
+
+int main(int argc, char **argv)
+{
+  FILE *f;
+  EveDlAnalyzer a;
+  uint8_t b[4];
+  uint32_t Word;
+  char Text[64];
+  int opt, All = 0, Quiet = 0, WarnPct = 87;
+  uint8_t Finding;
+
+  while ((opt = getopt(argc, argv, "aqw:")) != -1)
+  {
+    if (opt == 'a')
+      All = 1;
+    else if (opt == 'q')
+      Quiet = 1;
+    else if (opt == 'w')
+      WarnPct = atoi(optarg);
+    else
+      optind = argc + 1;
+  }
+  if (optind != argc - 1)
+  {
+    fprintf(stderr, "usage: dldis [-a] [-q] [-w percent] ramdl.bin\n");
+    return 1;
+  }
+  if (!(f = fopen(argv[optind], "rb")))
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  Eve_DlAnalyzeReset(&a);
+  while ((a.Words < FT_DL_SIZE / 4) && (fread(b, 1, 4, f) == 4))
+  {
+    if (a.Done && !All)
+      break;
+    Word = b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+    Finding = Eve_DlAnalyze(&a, Word);
+    if (Quiet && !Finding)
+      continue;
+    Eve_DlDisasm(Word, Text, sizeof(Text));
+    printf("%04x  %08lx  %-40s%s%s\n", (a.Words - 1) * 4, (unsigned long)Word, Text, Finding ? "; " : "",
+           Eve_DlFinding(Finding));
+  }
+  fclose(f);
+
+  printf("\n%u words (%u bytes, %u%% of RAM_DL), %u vertices\n", a.Words, a.Words * 4, a.Words * 400 / FT_DL_SIZE,
+         a.Vertices);
+  printf("%u redundant, %u empty BEGIN/END, %u unneeded END\n", a.Findings[EVE_DL_REDUNDANT], a.Findings[EVE_DL_EMPTY],
+         a.Findings[EVE_DL_REBEGIN]);
+  if (!a.Done)
+    printf("No DISPLAY - the list runs off the end\n");
+  if (a.Words * 400 / FT_DL_SIZE > (unsigned)WarnPct)
+    printf("Warning: close to the %u byte display list limit\n", FT_DL_SIZE);
+  return 0;
+}
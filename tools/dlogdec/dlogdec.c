@@ -0,0 +1,106 @@
+// dlogdec - turn the deferred log frames written by dlog.c into text on the host.
+//
+// The format strings never leave the host: they come from the same dlog_msgs.h the firmware was built with.
+// Anything on the port which is not a frame (the output of Log() and Serial.print) is passed through as is,
+// so a whole capture of the serial port can be fed in.
+//
+// Build:  cc -O2 -o dlogdec dlogdec.c
+// Usage:  dlogdec [-l level] [capture.bin]     (reads stdin without a file, e.g. from the serial port)
+//   -l  Only show messages at this level and more severe: 0 err, 1 warn, 2 info, 3 debug (default 3)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define DLOG_ERR              0
+#define DLOG_WARN             1
+#define DLOG_INFO             2
+#define DLOG_DEBUG            3
+#define DLOG_SYNC             0xA5                                   // As in dlog.h
+
+typedef struct
+{
+  const char *Id;
+  int Level;
+  const char *Format;
+} Msg;
+
+#define DLOG_MSG(Id, Level, Format) { #Id, Level, Format },
+static const Msg Msgs[] = {
+#include "../../dlog_msgs.h"
+};
+#undef DLOG_MSG
+#define MSG_COUNT             (sizeof(Msgs) / sizeof(Msgs[0]))
+
+static const char *LevelNames[] = { "ERR", "WARN", "INFO", "DEBUG" };
+
+static int ReadWord(FILE *f, uint32_t *w)
+{
+  int n, c;
+
+  *w = 0;
+  for (n = 0; n < 4; n++)
+  {
+    if ((c = getc(f)) == EOF)
+      return 0;
+    *w |= (uint32_t)c << (n * 8);
+  }
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  FILE *f = stdin;
+  uint32_t Words[4], Ms;
+  unsigned Id, Args, n;
+  int c, opt, MaxLevel = DLOG_DEBUG;
+  unsigned long Bad = 0;
+
+  while ((opt = getopt(argc, argv, "l:")) != -1)
+  {
+    if (opt == 'l')
+      MaxLevel = atoi(optarg);
+    else
+    {
+      fprintf(stderr, "usage: dlogdec [-l level] [capture.bin]\n");
+      return 1;
+    }
+  }
+  if ((optind < argc) && !(f = fopen(argv[optind], "rb")))
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  while ((c = getc(f)) != EOF)
+  {
+    if (c != DLOG_SYNC)                                              // Plain text from Log()
+    {
+      putchar(c);
+      continue;
+    }
+    if (!ReadWord(f, &Words[0]))
+      break;
+    Id = Words[0] & 0xFF;
+    Args = (Words[0] >> 8) & 3;
+    Ms = Words[0] >> 10;
+    for (n = 1; n <= Args; n++)
+      if (!ReadWord(f, &Words[n]))
+        return 0;
+    if (Id >= MSG_COUNT)                                             // A newer firmware than this decoder, or noise
+    {
+      Bad++;
+      printf("%7lu.%03lu ?     message %u\n", (unsigned long)(Ms / 1000), (unsigned long)(Ms % 1000), Id);
+      continue;
+    }
+    if (Msgs[Id].Level > MaxLevel)
+      continue;
+    printf("%7lu.%03lu %-5s ", (unsigned long)(Ms / 1000), (unsigned long)(Ms % 1000), LevelNames[Msgs[Id].Level]);
+    printf(Msgs[Id].Format, (unsigned long)Words[1], (unsigned long)Words[2], (unsigned long)Words[3]);
+    putchar('\n');
+  }
+  if (Bad)
+    fprintf(stderr, "%lu unknown messages - is dlog_msgs.h the one the firmware was built with?\n", Bad);
+  return 0;
+}
@@ -0,0 +1,434 @@
+// evepack - build an indexed flash image for BT81x modules on the host.
+//
+// Reads a manifest of assets, converts them in parallel, and lays them out behind the BT81x blob with the
+// index that flash_index.c searches at run time.  Program the output with EVE Asset Builder or any flash
+// programmer, then call FlashIndex_Open() on the device.
+//
+// Build:  cc -O2 -pthread -o evepack evepack.c -lz
+// Usage:  evepack [-j threads] [-b blob] [-s] [-o image.bin] manifest.txt
+//   -j  Number of worker threads (default: one per CPU)
+//   -b  The 4K BT81x blob (unified.blob).  Without it the first 4K is left erased.
+//   -s  Start every asset on a 4K sector so that each can be reprogrammed on its own.
+//
+// Manifest: one asset per line, '#' starts a comment.
+//   name type file [format width height]
+// type is raw, bitmap, zlib, image, font or anim.  zlib assets are compressed here.  Bitmaps need a format
+// (by name, e.g. RGB565 or ASTC_8x8, or by number) and size, except ASTC files with an .astc header, which
+// carry their own.  Bitmap data is taken as is, so it must already be laid out the way Eve wants it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "../../Eve2_81x.h"
+#include "../../flash_index.h"
+
+#define PACK_ALIGN          64                                       // CMD_FLASHREAD wants 64 byte aligned flash
+#define PACK_SECTOR         4096
+#define PACK_MAX            4096                                     // Assets in one image
+#define ASTC_MAGIC          0x5CA1AB13UL
+
+typedef char SizeCheckHeader[(sizeof(FlashIndexHeader) == 16) ? 1 : -1];
+typedef char SizeCheckEntry[(sizeof(FlashIndexEntry) == 48) ? 1 : -1];
+
+typedef struct
+{
+  char Name[FLASHINDEX_NAMELEN];
+  char Path[256];
+  int Line;                                                          // In the manifest, for errors
+  uint16_t Type, Format, Width, Height;
+  uint8_t *Data;                                                     // Converted data
+  uint32_t Size;
+  uint32_t Crc;
+  uint32_t Hash;
+  uint32_t FlashAdd;
+  const char *Error;                                                 // Set by a worker when conversion fails
+} PackItem;
+
+static const struct { const char *Name; uint16_t Value; } TypeNames[] =
+{
+  {"raw", FLASHINDEX_RAW}, {"bitmap", FLASHINDEX_BITMAP}, {"zlib", FLASHINDEX_ZLIB},
+  {"image", FLASHINDEX_IMAGE}, {"font", FLASHINDEX_FONT}, {"anim", FLASHINDEX_ANIM},
+};
+
+static const struct { const char *Name; uint16_t Value; } FormatNames[] =
+{
+  {"ARGB1555", ARGB1555}, {"L1", L1}, {"L2", L2}, {"L4", L4}, {"L8", L8}, {"RGB332", RGB332},
+  {"ARGB2", ARGB2}, {"ARGB4", ARGB4}, {"RGB565", RGB565}, {"PALETTED565", PALETTED565},
+  {"PALETTED4444", PALETTED4444}, {"PALETTED8", PALETTED8},
+  {"ASTC_4x4", COMPRESSED_RGBA_ASTC_4x4_KHR}, {"ASTC_5x4", COMPRESSED_RGBA_ASTC_5x4_KHR},
+  {"ASTC_5x5", COMPRESSED_RGBA_ASTC_5x5_KHR}, {"ASTC_6x5", COMPRESSED_RGBA_ASTC_6x5_KHR},
+  {"ASTC_6x6", COMPRESSED_RGBA_ASTC_6x6_KHR}, {"ASTC_8x5", COMPRESSED_RGBA_ASTC_8x5_KHR},
+  {"ASTC_8x6", COMPRESSED_RGBA_ASTC_8x6_KHR}, {"ASTC_8x8", COMPRESSED_RGBA_ASTC_8x8_KHR},
+  {"ASTC_10x5", COMPRESSED_RGBA_ASTC_10x5_KHR}, {"ASTC_10x6", COMPRESSED_RGBA_ASTC_10x6_KHR},
+  {"ASTC_10x8", COMPRESSED_RGBA_ASTC_10x8_KHR}, {"ASTC_10x10", COMPRESSED_RGBA_ASTC_10x10_KHR},
+  {"ASTC_12x10", COMPRESSED_RGBA_ASTC_12x10_KHR}, {"ASTC_12x12", COMPRESSED_RGBA_ASTC_12x12_KHR},
+};
+
+static PackItem Items[PACK_MAX];
+static int ItemCount;
+static int NextItem;                                                 // Work queue - the next item to convert
+static pthread_mutex_t NextLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Must match FlashIndex_Hash() in flash_index.c
+static uint32_t Pack_Hash(const char *name)
+{
+  uint32_t Hash = 2166136261UL;
+
+  while (*name)
+  {
+    Hash ^= (uint8_t)*name++;
+    Hash *= 16777619UL;
+  }
+  return (Hash);
+}
+
+static uint8_t *Pack_ReadFile(const char *path, uint32_t *Size)
+{
+  FILE *f = fopen(path, "rb");
+  uint8_t *Data;
+  long Len;
+
+  if (!f)
+    return NULL;
+  fseek(f, 0, SEEK_END);
+  Len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  Data = malloc(Len ? Len : 1);
+  if (Data && (fread(Data, 1, Len, f) != (size_t)Len))
+  {
+    free(Data);
+    Data = NULL;
+  }
+  fclose(f);
+  *Size = (uint32_t)Len;
+  return (Data);
+}
+
+// Which ASTC format has these block dimensions
+static uint16_t Pack_AstcFormat(uint8_t bw, uint8_t bh)
+{
+  static const uint8_t Blocks[][2] = {{4,4},{5,4},{5,5},{6,5},{6,6},{8,5},{8,6},{8,8},{10,5},{10,6},{10,8},{10,10},{12,10},{12,12}};
+  unsigned n;
+
+  for (n = 0; n < sizeof(Blocks) / sizeof(Blocks[0]); n++)
+    if ((Blocks[n][0] == bw) && (Blocks[n][1] == bh))
+      return (COMPRESSED_RGBA_ASTC_4x4_KHR + n);
+  return 0;
+}
+
+// Convert one asset.  Runs on a worker thread, so it only touches its own item.
+static void Pack_Convert(PackItem *Item)
+{
+  uint8_t *Raw;
+  uint32_t RawSize;
+  uLongf ZSize;
+
+  Raw = Pack_ReadFile(Item->Path, &RawSize);
+  if (!Raw)
+  {
+    Item->Error = strerror(errno);
+    return;
+  }
+
+  switch (Item->Type)
+  {
+  case FLASHINDEX_ZLIB:                                              // Compressed here, inflated by CMD_INFLATE2
+    ZSize = compressBound(RawSize);
+    Item->Data = malloc(ZSize);
+    if (!Item->Data || (compress2(Item->Data, &ZSize, Raw, RawSize, Z_BEST_COMPRESSION) != Z_OK))
+    {
+      Item->Error = "compression failed";
+      free(Raw);
+      return;
+    }
+    Item->Size = ZSize;
+    free(Raw);
+    break;
+
+  case FLASHINDEX_BITMAP:
+    if ((RawSize >= 16) && ((Raw[0] | (Raw[1] << 8) | (Raw[2] << 16) | ((uint32_t)Raw[3] << 24)) == ASTC_MAGIC))
+    {
+      Item->Format = Pack_AstcFormat(Raw[4], Raw[5]);
+      Item->Width = Raw[7] | (Raw[8] << 8);                          // 24 bit sizes, but Eve stops well short of that
+      Item->Height = Raw[10] | (Raw[11] << 8);
+      if (!Item->Format)
+      {
+        Item->Error = "ASTC block size not supported";
+        free(Raw);
+        return;
+      }
+      memmove(Raw, Raw + 16, RawSize - 16);                          // Strip the header
+      RawSize -= 16;
+    }
+    if (!Item->Width || !Item->Height)
+    {
+      Item->Error = "bitmap needs a format and size";
+      free(Raw);
+      return;
+    }
+    // Fall through
+  default:
+    Item->Data = Raw;
+    Item->Size = RawSize;
+    break;
+  }
+
+  Item->Crc = crc32(0L, Item->Data, Item->Size);
+  Item->Hash = Pack_Hash(Item->Name);
+}
+
+static void *Pack_Worker(void *arg)
+{
+  int n;
+
+  (void)arg;
+  while (1)
+  {
+    pthread_mutex_lock(&NextLock);
+    n = NextItem++;
+    pthread_mutex_unlock(&NextLock);
+    if (n >= ItemCount)
+      return NULL;
+    Pack_Convert(&Items[n]);
+  }
+}
+
+static int Pack_Lookup(const char *name, bool Format)
+{
+  char *End;
+  unsigned long Value;
+  unsigned n;
+
+  if (Format)
+  {
+    Value = strtoul(name, &End, 0);
+    if (!*End)
+      return (int)Value;
+    for (n = 0; n < sizeof(FormatNames) / sizeof(FormatNames[0]); n++)
+      if (!strcasecmp(FormatNames[n].Name, name))
+        return (FormatNames[n].Value);
+  }
+  else
+  {
+    for (n = 0; n < sizeof(TypeNames) / sizeof(TypeNames[0]); n++)
+      if (!strcasecmp(TypeNames[n].Name, name))
+        return (TypeNames[n].Value);
+  }
+  return -1;
+}
+
+static bool Pack_ReadManifest(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  char Line[512], Name[64], Type[32], File[256], Format[32];
+  unsigned Width, Height;
+  int Fields, LineNo = 0, Value;
+  char *Hash;
+  PackItem *Item;
+
+  if (!f)
+  {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return false;
+  }
+  while (fgets(Line, sizeof(Line), f))
+  {
+    LineNo++;
+    if ((Hash = strchr(Line, '#')))
+      *Hash = 0;
+    Width = Height = 0;
+    Fields = sscanf(Line, "%63s %31s %255s %31s %u %u", Name, Type, File, Format, &Width, &Height);
+    if (Fields <= 0)
+      continue;
+    if (Fields < 3)
+    {
+      fprintf(stderr, "%s:%d: expected name type file\n", path, LineNo);
+      return false;
+    }
+    if (ItemCount == PACK_MAX)
+    {
+      fprintf(stderr, "%s:%d: too many assets\n", path, LineNo);
+      return false;
+    }
+    if (strlen(Name) >= FLASHINDEX_NAMELEN)
+    {
+      fprintf(stderr, "%s:%d: name longer than %d characters\n", path, LineNo, FLASHINDEX_NAMELEN - 1);
+      return false;
+    }
+
+    Item = &Items[ItemCount++];
+    memset(Item, 0, sizeof(PackItem));
+    strcpy(Item->Name, Name);
+    strcpy(Item->Path, File);
+    Item->Line = LineNo;
+    if ((Value = Pack_Lookup(Type, false)) < 0)
+    {
+      fprintf(stderr, "%s:%d: unknown type %s\n", path, LineNo, Type);
+      return false;
+    }
+    Item->Type = Value;
+    if (Fields >= 4)
+    {
+      if ((Value = Pack_Lookup(Format, true)) < 0)
+      {
+        fprintf(stderr, "%s:%d: unknown format %s\n", path, LineNo, Format);
+        return false;
+      }
+      Item->Format = Value;
+      Item->Width = Width;
+      Item->Height = Height;
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+static int Pack_Compare(const void *a, const void *b)
+{
+  const PackItem *A = a, *B = b;
+
+  if (A->Hash != B->Hash)
+    return (A->Hash < B->Hash) ? -1 : 1;
+  return strcmp(A->Name, B->Name);
+}
+
+#define ROUND_UP(v, a)      (((v) + (a) - 1) / (a) * (a))
+
+int main(int argc, char **argv)
+{
+  const char *OutPath = "flash.bin", *BlobPath = NULL;
+  int Threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t Align = PACK_ALIGN, Add, ImageSize;
+  uint32_t Blob = 0;
+  pthread_t *Workers;
+  FlashIndexHeader Hdr;
+  FlashIndexEntry *Entries;
+  uint8_t *Image, *BlobData;
+  FILE *f;
+  int n, opt;
+
+  while ((opt = getopt(argc, argv, "j:b:so:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'j': Threads = atoi(optarg); break;
+    case 'b': BlobPath = optarg; break;
+    case 's': Align = PACK_SECTOR; break;
+    case 'o': OutPath = optarg; break;
+    default:
+      fprintf(stderr, "usage: %s [-j threads] [-b blob] [-s] [-o image.bin] manifest.txt\n", argv[0]);
+      return 1;
+    }
+  }
+  if (optind != argc - 1)
+  {
+    fprintf(stderr, "usage: %s [-j threads] [-b blob] [-s] [-o image.bin] manifest.txt\n", argv[0]);
+    return 1;
+  }
+  if (Threads < 1)
+    Threads = 1;
+
+  if (!Pack_ReadManifest(argv[optind]))
+    return 1;
+  if (!ItemCount)
+  {
+    fprintf(stderr, "%s: no assets\n", argv[optind]);
+    return 1;
+  }
+
+  // Convert everything in parallel
+  if (Threads > ItemCount)
+    Threads = ItemCount;
+  Workers = calloc(Threads, sizeof(pthread_t));
+  for (n = 0; n < Threads; n++)
+    pthread_create(&Workers[n], NULL, Pack_Worker, NULL);
+  for (n = 0; n < Threads; n++)
+    pthread_join(Workers[n], NULL);
+  free(Workers);
+
+  for (n = 0; n < ItemCount; n++)
+  {
+    if (Items[n].Error)
+    {
+      fprintf(stderr, "%s:%d: %s: %s\n", argv[optind], Items[n].Line, Items[n].Path, Items[n].Error);
+      return 1;
+    }
+  }
+
+  // Sort on hash for the binary search on the device
+  qsort(Items, ItemCount, sizeof(PackItem), Pack_Compare);
+  for (n = 1; n < ItemCount; n++)
+  {
+    if (!strcmp(Items[n].Name, Items[n - 1].Name))
+    {
+      fprintf(stderr, "%s: %s appears twice\n", argv[optind], Items[n].Name);
+      return 1;
+    }
+  }
+
+  // Lay it out: blob, index, then the data
+  memset(&Hdr, 0, sizeof(Hdr));
+  Hdr.Magic = FLASHINDEX_MAGIC;
+  Hdr.Version = FLASHINDEX_VERSION;
+  Hdr.Count = ItemCount;
+  Hdr.Size = ROUND_UP(sizeof(Hdr) + ItemCount * sizeof(FlashIndexEntry), PACK_ALIGN);
+  Add = ROUND_UP(FLASHINDEX_ADD + Hdr.Size, Align);
+  for (n = 0; n < ItemCount; n++)
+  {
+    Items[n].FlashAdd = Add;
+    Add = ROUND_UP(Add + Items[n].Size, Align);
+  }
+  ImageSize = Add;
+
+  Image = malloc(ImageSize);
+  memset(Image, 0xFF, ImageSize);                                    // Erased flash
+  if (BlobPath)
+  {
+    BlobData = Pack_ReadFile(BlobPath, &Blob);
+    if (!BlobData || (Blob != FLASHINDEX_ADD))
+    {
+      fprintf(stderr, "%s: not a %d byte blob\n", BlobPath, FLASHINDEX_ADD);
+      return 1;
+    }
+    memcpy(Image, BlobData, Blob);
+    free(BlobData);
+  }
+
+  Entries = (FlashIndexEntry *)(Image + FLASHINDEX_ADD + sizeof(Hdr));
+  memset(Entries, 0, ItemCount * sizeof(FlashIndexEntry));
+  for (n = 0; n < ItemCount; n++)
+  {
+    Entries[n].NameHash = Items[n].Hash;
+    Entries[n].FlashAdd = Items[n].FlashAdd;
+    Entries[n].Size = Items[n].Size;
+    Entries[n].Crc = Items[n].Crc;
+    Entries[n].Type = Items[n].Type;
+    Entries[n].Format = Items[n].Format;
+    Entries[n].Width = Items[n].Width;
+    Entries[n].Height = Items[n].Height;
+    strcpy(Entries[n].Name, Items[n].Name);
+    memcpy(Image + Items[n].FlashAdd, Items[n].Data, Items[n].Size);
+  }
+  Hdr.Crc = crc32(0L, (uint8_t *)Entries, ItemCount * sizeof(FlashIndexEntry));
+  memcpy(Image + FLASHINDEX_ADD, &Hdr, sizeof(Hdr));
+
+  f = fopen(OutPath, "wb");
+  if (!f || (fwrite(Image, 1, ImageSize, f) != ImageSize) || fclose(f))
+  {
+    fprintf(stderr, "%s: %s\n", OutPath, strerror(errno));
+    return 1;
+  }
+
+  printf("%-24s %-6s %8s %8s %s\n", "Name", "Type", "Flash", "Size", "CRC");
+  for (n = 0; n < ItemCount; n++)
+    printf("%-24s %-6s %08X %8u %08X\n", Items[n].Name, TypeNames[Items[n].Type].Name,
+           Items[n].FlashAdd, Items[n].Size, Items[n].Crc);
+  printf("%d assets, %u bytes%s\n", ItemCount, ImageSize, BlobPath ? "" : " (no blob - the first 4K is erased)");
+  return 0;
+}
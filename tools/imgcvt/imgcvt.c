@@ -0,0 +1,994 @@
+// imgcvt - convert images into Eve bitmap formats on the host.  A native stand in for FTDI's img_cvt.exe.
+//
+// Build:  cc -O2 -pthread -o imgcvt imgcvt.c -lz
+// Usage:  imgcvt -f format [-d] [-z] [-c colours] [-j threads] [-o dir] [-x isa] image.ppm ...
+//   -f  RGB565, ARGB1555, ARGB4, ARGB2, RGB332, L1, L2, L4, L8, PALETTED565, PALETTED4444 or PALETTED8
+//   -d  Ordered (4x4 Bayer) dithering instead of plain truncation (not for the paletted formats)
+//   -c  Most colours in the palette of a paletted format, 2 to 256 (default 256)
+//   -z  zlib wrap the output for Load_ZLIB() / CMD_INFLATE and name it .bin.  Otherwise it is the raw bitmap
+//       for Load_RAW() and named .raw.
+//   -j  Number of worker threads (default: one per CPU).  Each image is converted by one thread, and when there
+//       are more threads than images the palette matching of each image is shared out between the spare ones.
+//   -o  Output directory (default: next to the input)
+//   -x  Force an instruction set: scalar, sse2, avx2 or neon.  Every path gives the same bytes, so this is
+//       only for checking that they do.
+//
+// Input is binary PPM (P6), PGM (P5) or PAM (P7) with 8 bit samples.  Anything else can be turned into one of
+// those with ImageMagick or netpbm first.
+//
+// Output is what Eve wants in RAM_G for BITMAP_LAYOUT: lines of ceil(width * bits / 8) bytes, 16 bit pixels
+// little endian, and L1/L2/L4 with the leftmost pixel in the most significant bits.  The paletted formats
+// give an index file plus a .lut palette (16 bit entries for PALETTED565/4444, ARGB8888 for PALETTED8) to load
+// at the PALETTE_SOURCE address.  The .lut holds only the entries used, so its size says how many there are,
+// and it is never zlib wrapped.
+//
+// The palette is made for each image by median cut: the distinct colours are boxed, and the box with the most
+// pixels times its widest channel range is split at the pixel median of that channel until there are enough
+// boxes.  Each box gives the pixel weighted mean of its colours, rounded to what the palette format can hold,
+// and every distinct colour is given the nearest entry.  PALETTED565 has no alpha, so alpha is ignored there.
+//
+// The work is split into three row kernels - luminance, quantize (dither + truncate) and pack - each with
+// SSE2, AVX2 and NEON versions and a scalar version which defines the result.  The SIMD versions do the same
+// integer arithmetic, so the output does not depend on the machine it was made on.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "../../Eve2_81x.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define CVT_MAX_FILES       65536
+
+// How a format is built from 8 bit RGBA.  Bits and bit positions in the output pixel for R, G, B, A.
+// Luminance formats use the R entry.
+typedef struct
+{
+  const char *Name;
+  uint16_t Format;
+  uint8_t Bpp;                                                       // Bits per pixel in the output
+  uint8_t Luma;                                                      // Luminance format
+  uint8_t Paletted;                                                  // Index into a palette made for the image
+  uint8_t Bits[4];
+  uint8_t Pos[4];
+} CvtFormat;
+
+static const CvtFormat Formats[] =
+{
+  {"RGB565",       RGB565,       16, 0, 0, {5, 6, 5, 0}, {11, 5, 0, 0}},
+  {"ARGB1555",     ARGB1555,     16, 0, 0, {5, 5, 5, 1}, {10, 5, 0, 15}},
+  {"ARGB4",        ARGB4,        16, 0, 0, {4, 4, 4, 4}, {8, 4, 0, 12}},
+  {"ARGB2",        ARGB2,         8, 0, 0, {2, 2, 2, 2}, {4, 2, 0, 6}},
+  {"RGB332",       RGB332,        8, 0, 0, {3, 3, 2, 0}, {5, 2, 0, 0}},
+  {"L1",           L1,            1, 1, 0, {1, 0, 0, 0}, {0, 0, 0, 0}},
+  {"L2",           L2,            2, 1, 0, {2, 0, 0, 0}, {0, 0, 0, 0}},
+  {"L4",           L4,            4, 1, 0, {4, 0, 0, 0}, {0, 0, 0, 0}},
+  {"L8",           L8,            8, 1, 0, {8, 0, 0, 0}, {0, 0, 0, 0}},
+  {"PALETTED565",  PALETTED565,   8, 0, 1, {5, 6, 5, 0}, {0, 0, 0, 0}},        // Bits are those of the entries
+  {"PALETTED4444", PALETTED4444,  8, 0, 1, {4, 4, 4, 4}, {0, 0, 0, 0}},
+  {"PALETTED8",    PALETTED8,     8, 0, 1, {8, 8, 8, 8}, {0, 0, 0, 0}},
+};
+
+static const uint8_t Bayer[4][4] =
+{
+  { 0,  8,  2, 10},
+  {12,  4, 14,  6},
+  { 3, 11,  1,  9},
+  {15,  7, 13,  5},
+};
+
+// Per channel shift taking a truncated 8 bit channel value to its place in the packed pixel
+typedef struct
+{
+  int8_t Shift[4];                                                   // Left if positive, right if negative
+  uint8_t Bytes;                                                     // 1 or 2 bytes per packed pixel
+} CvtPack;
+
+// The row kernels.  Luma: RGBA to 8 bit luminance.  Quantize: saturating add of a 16 byte periodic dither
+// pattern then AND with a 16 byte periodic mask.  Pack: truncated RGBA to 8 or 16 bit pixels.
+typedef struct
+{
+  const char *Name;
+  void (*Luma)(const uint8_t *Rgba, uint8_t *Out, int Count);
+  void (*Quantize)(uint8_t *Data, int Count, const uint8_t *Offsets, const uint8_t *Masks);
+  void (*Pack)(const uint8_t *Rgba, uint8_t *Out, int Count, const CvtPack *Pack);
+} CvtKernels;
+
+// *** Scalar kernels - these define the output ******************************************************************
+
+static void Luma_Scalar(const uint8_t *Rgba, uint8_t *Out, int Count)
+{
+  int n;
+
+  for (n = 0; n < Count; n++, Rgba += 4)
+    Out[n] = (77 * Rgba[0] + 150 * Rgba[1] + 29 * Rgba[2] + 128) >> 8;
+}
+
+static void Quantize_Scalar(uint8_t *Data, int Count, const uint8_t *Offsets, const uint8_t *Masks)
+{
+  int n, v;
+
+  for (n = 0; n < Count; n++)
+  {
+    v = Data[n] + Offsets[n & 15];
+    Data[n] = ((v > 255) ? 255 : v) & Masks[n & 15];
+  }
+}
+
+static void Pack_Scalar(const uint8_t *Rgba, uint8_t *Out, int Count, const CvtPack *Pack)
+{
+  uint32_t Pixel;
+  int n, c;
+
+  for (n = 0; n < Count; n++, Rgba += 4)
+  {
+    Pixel = 0;
+    for (c = 0; c < 4; c++)
+      Pixel |= (Pack->Shift[c] >= 0) ? ((uint32_t)Rgba[c] << Pack->Shift[c]) : ((uint32_t)Rgba[c] >> -Pack->Shift[c]);
+    *Out++ = Pixel;
+    if (Pack->Bytes == 2)
+      *Out++ = Pixel >> 8;
+  }
+}
+
+// *** SSE2 kernels **********************************************************************************************
+#if defined(__SSE2__)
+
+static void Luma_SSE2(const uint8_t *Rgba, uint8_t *Out, int Count)
+{
+  const __m128i Low = _mm_set1_epi32(0xFF);
+  const __m128i Kr = _mm_set1_epi32(77), Kg = _mm_set1_epi32(150), Kb = _mm_set1_epi32(29), Round = _mm_set1_epi32(128);
+  __m128i p, l[4];
+  int n, k;
+
+  for (n = 0; n + 16 <= Count; n += 16)
+  {
+    for (k = 0; k < 4; k++)                                          // 4 pixels at a time, one per 32 bit lane
+    {
+      p = _mm_loadu_si128((const __m128i *)(Rgba + (n + k * 4) * 4));
+      // All products and sums stay below 65536 in the low half of each lane, so 16 bit multiplies do
+      l[k] = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(p, Low), Kr),
+                                         _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(p, 8), Low), Kg)),
+                           _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(p, 16), Low), Kb), Round));
+      l[k] = _mm_and_si128(_mm_srli_epi32(l[k], 8), Low);
+    }
+    _mm_storeu_si128((__m128i *)(Out + n), _mm_packus_epi16(_mm_packs_epi32(l[0], l[1]), _mm_packs_epi32(l[2], l[3])));
+  }
+  Luma_Scalar(Rgba + n * 4, Out + n, Count - n);
+}
+
+static void Quantize_SSE2(uint8_t *Data, int Count, const uint8_t *Offsets, const uint8_t *Masks)
+{
+  const __m128i Off = _mm_loadu_si128((const __m128i *)Offsets);
+  const __m128i Mask = _mm_loadu_si128((const __m128i *)Masks);
+  __m128i v;
+  int n;
+
+  for (n = 0; n + 16 <= Count; n += 16)
+  {
+    v = _mm_loadu_si128((const __m128i *)(Data + n));
+    _mm_storeu_si128((__m128i *)(Data + n), _mm_and_si128(_mm_adds_epu8(v, Off), Mask));
+  }
+  Quantize_Scalar(Data + n, Count - n, Offsets, Masks);              // n is a multiple of 16 so the pattern lines up
+}
+
+// Move each channel of 4 pixels (one per lane) into place and OR them together
+static inline __m128i Pack4_SSE2(__m128i p, const CvtPack *Pack)
+{
+  __m128i Pixel = _mm_setzero_si128(), Chan;
+  int c, s;
+
+  for (c = 0; c < 4; c++)
+  {
+    Chan = _mm_and_si128(p, _mm_set1_epi32(0xFFu << (c * 8)));
+    s = Pack->Shift[c] - c * 8;                                      // Channel c starts at bit 8c in the lane
+    Chan = (s >= 0) ? _mm_sll_epi32(Chan, _mm_cvtsi32_si128(s)) : _mm_srl_epi32(Chan, _mm_cvtsi32_si128(-s));
+    Pixel = _mm_or_si128(Pixel, Chan);
+  }
+  return (_mm_srai_epi32(_mm_slli_epi32(Pixel, 16), 16));            // Sign extend so packs_epi32 keeps all 16 bits
+}
+
+static void Pack_SSE2(const uint8_t *Rgba, uint8_t *Out, int Count, const CvtPack *Pack)
+{
+  __m128i a, b, c, d;
+  int n;
+
+  for (n = 0; n + 16 <= Count; n += 16)
+  {
+    a = Pack4_SSE2(_mm_loadu_si128((const __m128i *)(Rgba + n * 4)), Pack);
+    b = Pack4_SSE2(_mm_loadu_si128((const __m128i *)(Rgba + n * 4 + 16)), Pack);
+    c = Pack4_SSE2(_mm_loadu_si128((const __m128i *)(Rgba + n * 4 + 32)), Pack);
+    d = Pack4_SSE2(_mm_loadu_si128((const __m128i *)(Rgba + n * 4 + 48)), Pack);
+    a = _mm_packs_epi32(a, b);
+    c = _mm_packs_epi32(c, d);
+    if (Pack->Bytes == 2)
+    {
+      _mm_storeu_si128((__m128i *)(Out + n * 2), a);
+      _mm_storeu_si128((__m128i *)(Out + n * 2 + 16), c);
+    }
+    else
+      _mm_storeu_si128((__m128i *)(Out + n), _mm_packus_epi16(a, c));
+  }
+  Pack_Scalar(Rgba + n * 4, Out + n * Pack->Bytes, Count - n, Pack);
+}
+
+// *** AVX2 kernels - same as SSE2 with twice the width.  The packs work within 128 bit halves, hence the permutes.
+
+__attribute__((target("avx2")))
+static void Luma_AVX2(const uint8_t *Rgba, uint8_t *Out, int Count)
+{
+  const __m256i Low = _mm256_set1_epi32(0xFF);
+  const __m256i Kr = _mm256_set1_epi32(77), Kg = _mm256_set1_epi32(150), Kb = _mm256_set1_epi32(29), Round = _mm256_set1_epi32(128);
+  __m256i p, l[4];
+  int n, k;
+
+  for (n = 0; n + 32 <= Count; n += 32)
+  {
+    for (k = 0; k < 4; k++)
+    {
+      p = _mm256_loadu_si256((const __m256i *)(Rgba + (n + k * 8) * 4));
+      l[k] = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_and_si256(p, Low), Kr),
+                                               _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi32(p, 8), Low), Kg)),
+                              _mm256_add_epi16(_mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi32(p, 16), Low), Kb), Round));
+      l[k] = _mm256_and_si256(_mm256_srli_epi32(l[k], 8), Low);
+    }
+    p = _mm256_packus_epi16(_mm256_packs_epi32(l[0], l[1]), _mm256_packs_epi32(l[2], l[3]));
+    _mm256_storeu_si256((__m256i *)(Out + n), _mm256_permutevar8x32_epi32(p, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+  }
+  Luma_SSE2(Rgba + n * 4, Out + n, Count - n);
+}
+
+__attribute__((target("avx2")))
+static void Quantize_AVX2(uint8_t *Data, int Count, const uint8_t *Offsets, const uint8_t *Masks)
+{
+  const __m256i Off = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)Offsets));
+  const __m256i Mask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)Masks));
+  __m256i v;
+  int n;
+
+  for (n = 0; n + 32 <= Count; n += 32)
+  {
+    v = _mm256_loadu_si256((const __m256i *)(Data + n));
+    _mm256_storeu_si256((__m256i *)(Data + n), _mm256_and_si256(_mm256_adds_epu8(v, Off), Mask));
+  }
+  Quantize_SSE2(Data + n, Count - n, Offsets, Masks);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i Pack8_AVX2(__m256i p, const CvtPack *Pack)
+{
+  __m256i Pixel = _mm256_setzero_si256(), Chan;
+  int c, s;
+
+  for (c = 0; c < 4; c++)
+  {
+    Chan = _mm256_and_si256(p, _mm256_set1_epi32(0xFFu << (c * 8)));
+    s = Pack->Shift[c] - c * 8;
+    Chan = (s >= 0) ? _mm256_sll_epi32(Chan, _mm_cvtsi32_si128(s)) : _mm256_srl_epi32(Chan, _mm_cvtsi32_si128(-s));
+    Pixel = _mm256_or_si256(Pixel, Chan);
+  }
+  return (_mm256_srai_epi32(_mm256_slli_epi32(Pixel, 16), 16));
+}
+
+__attribute__((target("avx2")))
+static void Pack_AVX2(const uint8_t *Rgba, uint8_t *Out, int Count, const CvtPack *Pack)
+{
+  __m256i a, b, c, d;
+  int n;
+
+  for (n = 0; n + 32 <= Count; n += 32)
+  {
+    a = Pack8_AVX2(_mm256_loadu_si256((const __m256i *)(Rgba + n * 4)), Pack);
+    b = Pack8_AVX2(_mm256_loadu_si256((const __m256i *)(Rgba + n * 4 + 32)), Pack);
+    c = Pack8_AVX2(_mm256_loadu_si256((const __m256i *)(Rgba + n * 4 + 64)), Pack);
+    d = Pack8_AVX2(_mm256_loadu_si256((const __m256i *)(Rgba + n * 4 + 96)), Pack);
+    a = _mm256_packs_epi32(a, b);
+    c = _mm256_packs_epi32(c, d);
+    if (Pack->Bytes == 2)
+    {
+      _mm256_storeu_si256((__m256i *)(Out + n * 2), _mm256_permute4x64_epi64(a, 0xD8));
+      _mm256_storeu_si256((__m256i *)(Out + n * 2 + 32), _mm256_permute4x64_epi64(c, 0xD8));
+    }
+    else
+      _mm256_storeu_si256((__m256i *)(Out + n), _mm256_permutevar8x32_epi32(_mm256_packus_epi16(a, c), _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+  }
+  Pack_SSE2(Rgba + n * 4, Out + n * Pack->Bytes, Count - n, Pack);
+}
+#endif
+
+// *** NEON kernels **********************************************************************************************
+#if defined(__ARM_NEON)
+
+static void Luma_NEON(const uint8_t *Rgba, uint8_t *Out, int Count)
+{
+  uint8x16x4_t p;
+  uint16x8_t Lo, Hi;
+  int n;
+
+  for (n = 0; n + 16 <= Count; n += 16)
+  {
+    p = vld4q_u8(Rgba + n * 4);                                      // De-interleaves into R, G, B, A
+    Lo = vmull_u8(vget_low_u8(p.val[0]), vdup_n_u8(77));
+    Lo = vmlal_u8(Lo, vget_low_u8(p.val[1]), vdup_n_u8(150));
+    Lo = vmlal_u8(Lo, vget_low_u8(p.val[2]), vdup_n_u8(29));
+    Hi = vmull_u8(vget_high_u8(p.val[0]), vdup_n_u8(77));
+    Hi = vmlal_u8(Hi, vget_high_u8(p.val[1]), vdup_n_u8(150));
+    Hi = vmlal_u8(Hi, vget_high_u8(p.val[2]), vdup_n_u8(29));
+    vst1q_u8(Out + n, vcombine_u8(vrshrn_n_u16(Lo, 8), vrshrn_n_u16(Hi, 8)));  // (x + 128) >> 8
+  }
+  Luma_Scalar(Rgba + n * 4, Out + n, Count - n);
+}
+
+static void Quantize_NEON(uint8_t *Data, int Count, const uint8_t *Offsets, const uint8_t *Masks)
+{
+  const uint8x16_t Off = vld1q_u8(Offsets);
+  const uint8x16_t Mask = vld1q_u8(Masks);
+  int n;
+
+  for (n = 0; n + 16 <= Count; n += 16)
+    vst1q_u8(Data + n, vandq_u8(vqaddq_u8(vld1q_u8(Data + n), Off), Mask));
+  Quantize_Scalar(Data + n, Count - n, Offsets, Masks);
+}
+
+static void Pack_NEON(const uint8_t *Rgba, uint8_t *Out, int Count, const CvtPack *Pack)
+{
+  uint8x16x4_t p;
+  uint16x8_t Lo, Hi;
+  int n, c;
+
+  for (n = 0; n + 16 <= Count; n += 16)
+  {
+    p = vld4q_u8(Rgba + n * 4);
+    Lo = Hi = vdupq_n_u16(0);
+    for (c = 0; c < 4; c++)                                          // vshlq shifts right for a negative count
+    {
+      Lo = vorrq_u16(Lo, vshlq_u16(vmovl_u8(vget_low_u8(p.val[c])), vdupq_n_s16(Pack->Shift[c])));
+      Hi = vorrq_u16(Hi, vshlq_u16(vmovl_u8(vget_high_u8(p.val[c])), vdupq_n_s16(Pack->Shift[c])));
+    }
+    if (Pack->Bytes == 2)
+    {
+      vst1q_u8(Out + n * 2, vreinterpretq_u8_u16(Lo));               // Little endian
+      vst1q_u8(Out + n * 2 + 16, vreinterpretq_u8_u16(Hi));
+    }
+    else
+      vst1q_u8(Out + n, vcombine_u8(vmovn_u16(Lo), vmovn_u16(Hi)));
+  }
+  Pack_Scalar(Rgba + n * 4, Out + n * Pack->Bytes, Count - n, Pack);
+}
+#endif
+
+static const CvtKernels Kernels[] =
+{
+  {"scalar", Luma_Scalar, Quantize_Scalar, Pack_Scalar},
+#if defined(__SSE2__)
+  {"sse2", Luma_SSE2, Quantize_SSE2, Pack_SSE2},
+  {"avx2", Luma_AVX2, Quantize_AVX2, Pack_AVX2},
+#endif
+#if defined(__ARM_NEON)
+  {"neon", Luma_NEON, Quantize_NEON, Pack_NEON},
+#endif
+};
+
+// *** The rest ***************************************************************************************************
+
+typedef struct
+{
+  uint32_t Width, Height;
+  uint8_t *Rgba;
+} CvtImage;
+
+static const CvtFormat *Format;
+static const CvtKernels *Use;
+static int Dither, Zlib;
+static int Colours = 256;
+static int Split = 1;                                                // Threads per image for palette matching
+static const char *OutDir;
+static char **Files;
+static int FileCount, NextFile, Failed;
+static pthread_mutex_t NextLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Read the next header token of a netpbm file, skipping comments
+static int Cvt_Token(FILE *f, char *Buf, int Size)
+{
+  int ch, n = 0;
+
+  while ((ch = fgetc(f)) != EOF)
+  {
+    if (ch == '#')
+      while (((ch = fgetc(f)) != EOF) && (ch != '\n'));
+    else if (ch > ' ')
+      break;
+  }
+  while ((ch != EOF) && (ch > ' ') && (n < Size - 1))
+  {
+    Buf[n++] = ch;
+    ch = fgetc(f);
+  }
+  Buf[n] = 0;
+  return n;                                                          // The single whitespace after it is eaten
+}
+
+// Load a P5, P6 or P7 file as 8 bit RGBA
+static const char *Cvt_Load(const char *path, CvtImage *Img)
+{
+  FILE *f = fopen(path, "rb");
+  char Tok[32], Magic[4];
+  uint32_t Depth = 0, MaxVal = 0, n, Pixels;
+  uint8_t *Raw, *s, *d;
+
+  if (!f)
+    return strerror(errno);
+  Img->Width = Img->Height = 0;
+  Cvt_Token(f, Magic, sizeof(Magic));
+  if (!strcmp(Magic, "P5") || !strcmp(Magic, "P6"))
+  {
+    Depth = (Magic[1] == '5') ? 1 : 3;
+    Cvt_Token(f, Tok, sizeof(Tok)); Img->Width = atoi(Tok);
+    Cvt_Token(f, Tok, sizeof(Tok)); Img->Height = atoi(Tok);
+    Cvt_Token(f, Tok, sizeof(Tok)); MaxVal = atoi(Tok);
+  }
+  else if (!strcmp(Magic, "P7"))
+  {
+    while (Cvt_Token(f, Tok, sizeof(Tok)) && strcmp(Tok, "ENDHDR"))
+    {
+      if (!strcmp(Tok, "WIDTH"))  { Cvt_Token(f, Tok, sizeof(Tok)); Img->Width = atoi(Tok); }
+      else if (!strcmp(Tok, "HEIGHT")) { Cvt_Token(f, Tok, sizeof(Tok)); Img->Height = atoi(Tok); }
+      else if (!strcmp(Tok, "DEPTH"))  { Cvt_Token(f, Tok, sizeof(Tok)); Depth = atoi(Tok); }
+      else if (!strcmp(Tok, "MAXVAL")) { Cvt_Token(f, Tok, sizeof(Tok)); MaxVal = atoi(Tok); }
+      else if (!strcmp(Tok, "TUPLTYPE")) Cvt_Token(f, Tok, sizeof(Tok));
+    }
+  }
+  else
+  {
+    fclose(f);
+    return "not a PPM, PGM or PAM file";
+  }
+  if (!Img->Width || !Img->Height || (Depth < 1) || (Depth > 4) || (MaxVal != 255))
+  {
+    fclose(f);
+    return "unsupported image (8 bit samples only)";
+  }
+
+  Pixels = Img->Width * Img->Height;
+  Raw = malloc((size_t)Pixels * Depth);
+  Img->Rgba = malloc((size_t)Pixels * 4 + 64);                       // Slack so kernels may read a little past the end
+  if (!Raw || !Img->Rgba || (fread(Raw, Depth, Pixels, f) != Pixels))
+  {
+    fclose(f);
+    free(Raw);
+    return "short file";
+  }
+  fclose(f);
+
+  for (n = 0, s = Raw, d = Img->Rgba; n < Pixels; n++, s += Depth, d += 4)
+  {
+    switch (Depth)
+    {
+    case 1: d[0] = d[1] = d[2] = s[0]; d[3] = 255; break;            // Gray
+    case 2: d[0] = d[1] = d[2] = s[0]; d[3] = s[1]; break;           // Gray + alpha
+    case 3: d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = 255; break;
+    case 4: memcpy(d, s, 4); break;
+    }
+  }
+  free(Raw);
+  return NULL;
+}
+
+// The 16 byte dither and mask patterns for row y.  Pixel x % 4 in byte n: for RGBA n / 4, for luminance n.
+static void Cvt_Patterns(uint32_t y, uint8_t *Offsets, uint8_t *Masks)
+{
+  int n, c, x, Bits;
+
+  for (n = 0; n < 16; n++)
+  {
+    c = Format->Luma ? 0 : (n & 3);
+    x = Format->Luma ? (n & 3) : (n >> 2);
+    Bits = Format->Bits[c];
+    Masks[n] = Bits ? (uint8_t)(0xFF << (8 - Bits)) : 0;
+    Offsets[n] = (Dither && Bits) ? (uint8_t)((Bayer[y & 3][x] << (8 - Bits)) >> 4) : 0;  // Less than one step
+  }
+}
+
+// Convert an image into the chosen format.  Returns the bitmap and sets Size.
+static uint8_t *Cvt_Convert(CvtImage *Img, uint32_t *Size)
+{
+  uint32_t Stride = (Img->Width * Format->Bpp + 7) / 8;
+  uint8_t Offsets[16], Masks[16];
+  CvtPack Pack;
+  uint8_t *Out, *Row, *Line, *Luma;
+  uint32_t x, y;
+  int c, Per, Shift;
+
+  Out = calloc(Stride, Img->Height);
+  Luma = malloc(Img->Width + 64);
+  for (c = 0; c < 4; c++)
+    Pack.Shift[c] = Format->Pos[c] - (8 - Format->Bits[c]);
+  Pack.Bytes = Format->Bpp / 8;
+
+  for (y = 0; y < Img->Height; y++)
+  {
+    Row = Img->Rgba + (size_t)y * Img->Width * 4;
+    Line = Out + (size_t)y * Stride;
+    Cvt_Patterns(y, Offsets, Masks);
+    if (Format->Luma)
+    {
+      Use->Luma(Row, Luma, Img->Width);
+      Use->Quantize(Luma, Img->Width, Offsets, Masks);
+      if (Format->Bpp == 8)
+        memcpy(Line, Luma, Img->Width);
+      else
+      {
+        Per = 8 / Format->Bpp;                                       // Pixels per byte, leftmost in the top bits
+        for (x = 0; x < Img->Width; x++)
+        {
+          Shift = 8 - Format->Bpp * (1 + x % Per);
+          Line[x / Per] |= (Luma[x] >> (8 - Format->Bpp)) << Shift;
+        }
+      }
+    }
+    else
+    {
+      Use->Quantize(Row, Img->Width * 4, Offsets, Masks);            // In place - the image is not needed again
+      Use->Pack(Row, Line, Img->Width, &Pack);
+    }
+  }
+  free(Luma);
+  *Size = Stride * Img->Height;
+  return (Out);
+}
+
+// *** Palette ****************************************************************************************************
+
+typedef struct
+{
+  uint32_t Rgba;                                                     // R in the low byte, as the image holds it
+  uint32_t Count;                                                    // Pixels of this colour
+  uint8_t Index;                                                     // Palette entry it is drawn with
+} CvtColour;
+
+typedef struct
+{
+  uint32_t First, Count;                                             // Colours[First] to Colours[First + Count - 1]
+  uint64_t Pixels;
+  int Channel;                                                       // Widest channel
+  uint32_t Range;                                                    // Its range
+} CvtBox;
+
+typedef struct
+{
+  CvtColour *Colours;
+  uint32_t First, Count;
+  const uint8_t (*Shown)[4];                                         // Palette entries as Eve shows them
+  int Entries, Channels;
+} CvtMatch;
+
+#define CVT_CHAN(c, n)      (((c) >> ((n) * 8)) & 0xFF)
+
+static int Cvt_CmpKey(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+  return ((x > y) - (x < y));
+}
+
+// qsort has no context pointer, so one comparison per channel
+#define CVT_CMP(n) \
+  static int Cvt_Cmp##n(const void *a, const void *b) \
+  { \
+    return ((int)CVT_CHAN(((const CvtColour *)a)->Rgba, n) - (int)CVT_CHAN(((const CvtColour *)b)->Rgba, n)); \
+  }
+CVT_CMP(0)
+CVT_CMP(1)
+CVT_CMP(2)
+CVT_CMP(3)
+static int (*const Cvt_CmpChannel[4])(const void *, const void *) = { Cvt_Cmp0, Cvt_Cmp1, Cvt_Cmp2, Cvt_Cmp3 };
+
+static void Cvt_Measure(CvtBox *Box, const CvtColour *Colours, int Channels)
+{
+  uint32_t Lo[4] = {255, 255, 255, 255}, Hi[4] = {0, 0, 0, 0}, n, v;
+  int c;
+
+  Box->Pixels = 0;
+  for (n = Box->First; n < Box->First + Box->Count; n++)
+  {
+    Box->Pixels += Colours[n].Count;
+    for (c = 0; c < Channels; c++)
+    {
+      v = CVT_CHAN(Colours[n].Rgba, c);
+      if (v < Lo[c]) Lo[c] = v;
+      if (v > Hi[c]) Hi[c] = v;
+    }
+  }
+  Box->Range = 0;
+  Box->Channel = 0;
+  for (c = 0; c < Channels; c++)
+  {
+    if (Hi[c] - Lo[c] > Box->Range)
+    {
+      Box->Range = Hi[c] - Lo[c];
+      Box->Channel = c;
+    }
+  }
+}
+
+// Round an 8 bit channel to Bits and back to 8 bits, as Eve will show it
+static uint8_t Cvt_Round(uint32_t v, int Bits)
+{
+  uint32_t Max = (1u << Bits) - 1;
+
+  v = (v * Max + 127) / 255;
+  return ((v * 255 + Max / 2) / Max);
+}
+
+// Nearest palette entry for each colour in a slice of the list
+static void *Cvt_MatchSlice(void *arg)
+{
+  CvtMatch *m = arg;
+  uint32_t n, Dist, Best;
+  int e, c, d;
+
+  for (n = m->First; n < m->First + m->Count; n++)
+  {
+    Best = UINT32_MAX;
+    for (e = 0; e < m->Entries; e++)
+    {
+      for (c = 0, Dist = 0; c < m->Channels; c++)
+      {
+        d = (int)CVT_CHAN(m->Colours[n].Rgba, c) - m->Shown[e][c];
+        Dist += d * d;
+      }
+      if (Dist < Best)
+      {
+        Best = Dist;
+        m->Colours[n].Index = e;
+        if (!Dist)
+          break;
+      }
+    }
+  }
+  return NULL;
+}
+
+// Make a palette for the image and the index bitmap that goes with it.  Returns the index bitmap and sets Size,
+// with the palette in Lut (LutSize bytes, LutSize / entry size entries).
+static uint8_t *Cvt_Quantize(CvtImage *Img, uint32_t *Size, uint8_t **Lut, uint32_t *LutSize)
+{
+  uint32_t Pixels = Img->Width * Img->Height, n, Unique, Half, Sum, Key;
+  int Channels = Format->Bits[3] ? 4 : 3, Boxes = 1, b, Pick, c, Threads;
+  uint32_t *Keys = malloc((size_t)Pixels * 4);
+  CvtColour *List, Find, *Hit;
+  CvtBox Box[256];
+  uint64_t Score, Best, Mean[4];
+  uint8_t Shown[256][4], *Out, *p;
+  uint32_t Entry;
+  CvtMatch Match[64];
+  pthread_t Helpers[64];
+  int Started[64];
+
+  // The distinct colours and how many pixels have each.  Without alpha every pixel is opaque, and with it every
+  // fully transparent pixel is the same colour.
+  for (n = 0; n < Pixels; n++)
+  {
+    memcpy(&Key, Img->Rgba + (size_t)n * 4, 4);
+    if (Channels == 3)
+      Key |= 0xFF000000u;
+    else if (!(Key >> 24))
+      Key = 0;
+    Keys[n] = Key;
+  }
+  List = malloc((size_t)Pixels * sizeof(CvtColour));
+  memcpy(Img->Rgba, Keys, (size_t)Pixels * 4);                       // Looked up again once the palette is made
+  qsort(Keys, Pixels, 4, Cvt_CmpKey);
+  for (n = 0, Unique = 0; n < Pixels; n++)
+  {
+    if (Unique && (List[Unique - 1].Rgba == Keys[n]))
+      List[Unique - 1].Count++;
+    else
+    {
+      List[Unique].Rgba = Keys[n];
+      List[Unique].Count = 1;
+      Unique++;
+    }
+  }
+  free(Keys);
+
+  // Median cut
+  Box[0].First = 0;
+  Box[0].Count = Unique;
+  Cvt_Measure(&Box[0], List, Channels);
+  while (Boxes < Colours)
+  {
+    for (b = 0, Pick = -1, Best = 0; b < Boxes; b++)
+    {
+      Score = Box[b].Pixels * Box[b].Range;
+      if ((Box[b].Count > 1) && (Score > Best))
+      {
+        Best = Score;
+        Pick = b;
+      }
+    }
+    if (Pick < 0)                                                    // Every box is down to one colour
+      break;
+    qsort(List + Box[Pick].First, Box[Pick].Count, sizeof(CvtColour), Cvt_CmpChannel[Box[Pick].Channel]);
+    Half = Box[Pick].Pixels / 2;
+    for (n = 0, Sum = 0; n < Box[Pick].Count - 1; n++)               // At least one colour stays on each side
+    {
+      Sum += List[Box[Pick].First + n].Count;
+      if (Sum >= Half)
+        break;
+    }
+    Box[Boxes].First = Box[Pick].First + n + 1;
+    Box[Boxes].Count = Box[Pick].Count - n - 1;
+    Box[Pick].Count = n + 1;
+    Cvt_Measure(&Box[Pick], List, Channels);
+    Cvt_Measure(&Box[Boxes], List, Channels);
+    Boxes++;
+  }
+
+  // One entry per box, as the palette format holds it
+  *LutSize = Boxes * ((Format->Format == PALETTED8) ? 4 : 2);
+  *Lut = malloc(*LutSize);
+  for (b = 0; b < Boxes; b++)
+  {
+    memset(Mean, 0, sizeof(Mean));
+    for (n = Box[b].First; n < Box[b].First + Box[b].Count; n++)
+      for (c = 0; c < 4; c++)
+        Mean[c] += (uint64_t)CVT_CHAN(List[n].Rgba, c) * List[n].Count;
+    for (c = 0; c < 4; c++)
+      Shown[b][c] = Cvt_Round((Mean[c] + Box[b].Pixels / 2) / Box[b].Pixels, Format->Bits[c] ? Format->Bits[c] : 8);
+    if (Format->Format == PALETTED8)                                 // ARGB8888, little endian: B G R A
+    {
+      (*Lut)[b * 4 + 0] = Shown[b][2];
+      (*Lut)[b * 4 + 1] = Shown[b][1];
+      (*Lut)[b * 4 + 2] = Shown[b][0];
+      (*Lut)[b * 4 + 3] = Shown[b][3];
+    }
+    else
+    {
+      if (Format->Format == PALETTED565)
+        Entry = ((Shown[b][0] >> 3) << 11) | ((Shown[b][1] >> 2) << 5) | (Shown[b][2] >> 3);
+      else
+        Entry = ((Shown[b][3] >> 4) << 12) | ((Shown[b][0] >> 4) << 8) | ((Shown[b][1] >> 4) << 4) | (Shown[b][2] >> 4);
+      (*Lut)[b * 2] = Entry;
+      (*Lut)[b * 2 + 1] = Entry >> 8;
+    }
+  }
+
+  // Nearest entry for every distinct colour, shared out between the threads this image has
+  qsort(List, Unique, sizeof(CvtColour), Cvt_CmpKey);             // Rgba is the first member
+  Threads = Split;
+  if (Threads > 64)
+    Threads = 64;
+  if ((uint32_t)Threads > Unique)
+    Threads = Unique;
+  for (b = 0; b < Threads; b++)
+  {
+    Match[b].Colours = List;
+    Match[b].First = (uint64_t)Unique * b / Threads;
+    Match[b].Count = (uint64_t)Unique * (b + 1) / Threads - Match[b].First;
+    Match[b].Shown = (const uint8_t (*)[4])Shown;
+    Match[b].Entries = Boxes;
+    Match[b].Channels = Channels;
+  }
+  for (b = 1; b < Threads; b++)
+    Started[b] = !pthread_create(&Helpers[b], NULL, Cvt_MatchSlice, &Match[b]);
+  Cvt_MatchSlice(&Match[0]);
+  for (b = 1; b < Threads; b++)
+  {
+    if (Started[b])
+      pthread_join(Helpers[b], NULL);
+    else
+      Cvt_MatchSlice(&Match[b]);                                     // No thread to be had - do it here
+  }
+
+  Out = malloc(Pixels);
+  for (n = 0, p = Img->Rgba; n < Pixels; n++, p += 4)
+  {
+    memcpy(&Find.Rgba, p, 4);
+    Hit = bsearch(&Find, List, Unique, sizeof(CvtColour), Cvt_CmpKey);
+    Out[n] = Hit->Index;
+  }
+  free(List);
+  *Size = Pixels;
+  return (Out);
+}
+
+// Write one output file, zlib wrapped if Wrap.  Name is the input with its extension replaced.
+static const char *Cvt_Write(const char *path, const char *Ext, uint8_t *Data, uint32_t Size, int Wrap)
+{
+  char Name[4096];
+  const char *Base = strrchr(path, '/');
+  char *Dot;
+  uLongf ZSize = compressBound(Size);
+  uint8_t *Z = NULL;
+  FILE *f;
+
+  if (OutDir)
+    snprintf(Name, sizeof(Name), "%s/%s", OutDir, Base ? Base + 1 : path);
+  else
+    snprintf(Name, sizeof(Name), "%s", path);
+  Dot = strrchr(Name, '.');
+  if (Dot && !strchr(Dot, '/'))
+    *Dot = 0;
+  strncat(Name, Ext, sizeof(Name) - strlen(Name) - 1);
+
+  if (Wrap)
+  {
+    Z = malloc(ZSize);
+    if (!Z || (compress2(Z, &ZSize, Data, Size, Z_BEST_COMPRESSION) != Z_OK))
+    {
+      free(Z);
+      return "compression failed";
+    }
+    Data = Z;
+    Size = ZSize;
+  }
+  f = fopen(Name, "wb");
+  if (!f || (fwrite(Data, 1, Size, f) != Size) || fclose(f))
+  {
+    free(Z);
+    return strerror(errno);
+  }
+  free(Z);
+  return NULL;
+}
+
+static void Cvt_File(const char *path)
+{
+  CvtImage Img = {0};
+  uint8_t *Bitmap, *Lut = NULL;
+  uint32_t Size, LutSize = 0;
+  const char *Error;
+
+  Error = Cvt_Load(path, &Img);
+  if (!Error)
+  {
+    if (Format->Paletted)
+      Bitmap = Cvt_Quantize(&Img, &Size, &Lut, &LutSize);
+    else
+      Bitmap = Cvt_Convert(&Img, &Size);
+    Error = Cvt_Write(path, Zlib ? ".bin" : ".raw", Bitmap, Size, Zlib);
+    if (!Error && Lut)
+      Error = Cvt_Write(path, ".lut", Lut, LutSize, 0);       // Small, and always raw for Load_RAW()
+    free(Lut);
+    free(Bitmap);
+  }
+  free(Img.Rgba);
+
+  pthread_mutex_lock(&NextLock);
+  if (Error)
+  {
+    fprintf(stderr, "%s: %s\n", path, Error);
+    Failed++;
+  }
+  else if (Lut)
+    printf("%s: %ux%u %s, %u colours\n", path, Img.Width, Img.Height, Format->Name,
+           LutSize / ((Format->Format == PALETTED8) ? 4 : 2));
+  else
+    printf("%s: %ux%u %s\n", path, Img.Width, Img.Height, Format->Name);
+  pthread_mutex_unlock(&NextLock);
+}
+
+static void *Cvt_Worker(void *arg)
+{
+  int n;
+
+  (void)arg;
+  while (1)
+  {
+    pthread_mutex_lock(&NextLock);
+    n = NextFile++;
+    pthread_mutex_unlock(&NextLock);
+    if (n >= FileCount)
+      return NULL;
+    Cvt_File(Files[n]);
+  }
+}
+
+static const CvtKernels *Cvt_PickKernels(const char *Isa)
+{
+  unsigned n;
+
+  for (n = 0; n < sizeof(Kernels) / sizeof(Kernels[0]); n++)
+  {
+    if (Isa && !strcasecmp(Isa, Kernels[n].Name))
+    {
+#if defined(__SSE2__)
+      if (!strcmp(Kernels[n].Name, "avx2") && !__builtin_cpu_supports("avx2"))
+        return NULL;
+#endif
+      return (&Kernels[n]);
+    }
+  }
+  if (Isa)
+    return NULL;
+#if defined(__SSE2__)
+  return (__builtin_cpu_supports("avx2") ? &Kernels[2] : &Kernels[1]);
+#elif defined(__ARM_NEON)
+  return (&Kernels[1]);
+#else
+  return (&Kernels[0]);
+#endif
+}
+
+static void Cvt_Usage(const char *Prog)
+{
+  fprintf(stderr, "usage: %s -f format [-d] [-z] [-c colours] [-j threads] [-o dir] [-x isa] image.ppm ...\n", Prog);
+  exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  int Threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  const char *Isa = NULL;
+  pthread_t *Workers;
+  unsigned n;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "f:dzc:j:o:x:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'f':
+      for (n = 0; n < sizeof(Formats) / sizeof(Formats[0]); n++)
+        if (!strcasecmp(optarg, Formats[n].Name))
+          Format = &Formats[n];
+      if (!Format)
+      {
+        fprintf(stderr, "unknown format %s\n", optarg);
+        return 1;
+      }
+      break;
+    case 'd': Dither = 1; break;
+    case 'z': Zlib = 1; break;
+    case 'c':
+      Colours = atoi(optarg);
+      if ((Colours < 2) || (Colours > 256))
+      {
+        fprintf(stderr, "colours must be 2 to 256\n");
+        return 1;
+      }
+      break;
+    case 'j': Threads = atoi(optarg); break;
+    case 'o': OutDir = optarg; break;
+    case 'x': Isa = optarg; break;
+    default: Cvt_Usage(argv[0]);
+    }
+  }
+  if (!Format || (optind == argc))
+    Cvt_Usage(argv[0]);
+  Use = Cvt_PickKernels(Isa);
+  if (!Use)
+  {
+    fprintf(stderr, "%s not available here\n", Isa);
+    return 1;
+  }
+
+  Files = argv + optind;
+  FileCount = argc - optind;
+  Split = Threads / FileCount;                                       // Spare threads help with each image
+  if (Split < 1)
+    Split = 1;
+  if (Threads > FileCount)
+    Threads = FileCount;
+  if (Threads < 1)
+    Threads = 1;
+  Workers = calloc(Threads, sizeof(pthread_t));
+  for (opt = 0; opt < Threads; opt++)
+    pthread_create(&Workers[opt], NULL, Cvt_Worker, NULL);
+  for (opt = 0; opt < Threads; opt++)
+    pthread_join(Workers[opt], NULL);
+  free(Workers);
+  return (Failed ? 1 : 0);
+}
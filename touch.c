@@ -0,0 +1,295 @@
+// Multi-touch tracking and gestures for the capacitive touch controller.  All function calls are hardware ambivalent.
+//
+// With REG_CTOUCH_EXTEND set to extended mode Eve reports up to five calibrated touch points, each with its
+// own tag.  The registers are scattered over 0x11C - 0x193, so each sample reads that whole block in a single
+// SPI burst (120 bytes) rather than ten separate register reads with their address overhead.
+//
+// Eve's point slots are not a reliable identity - a slot can be reused by a different finger - so contacts
+// are followed from sample to sample by distance and given our own IDs.  Gestures are worked out from the
+// contacts: tap, long press and swipe for one finger, pinch for two.  Events go into a small queue which
+// the application empties with Touch_GetEvent().
+//
+// Touch_Poll() can be called as often as you like; it only samples every PeriodMs.  A shorter period gives
+// lower latency and costs bus time - Touch_LogStats() shows how much.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "touch.h"               // Every c file has it's header and this is the one for this file
+
+// Offsets into the sampled block of each slot's XY (X in the top 16 bits) and tag.  Slot 4 is special: X and
+// Y have registers of their own.
+static const uint8_t SlotXY[TOUCH_POINTS]  = { 0x124 - TOUCH_BLOCK_START, 0x11C - TOUCH_BLOCK_START,
+                                               0x18C - TOUCH_BLOCK_START, 0x190 - TOUCH_BLOCK_START, 0 };
+static const uint8_t SlotTag[TOUCH_POINTS] = { 0x12C - TOUCH_BLOCK_START, 0x134 - TOUCH_BLOCK_START,
+                                               0x13C - TOUCH_BLOCK_START, 0x144 - TOUCH_BLOCK_START,
+                                               0x14C - TOUCH_BLOCK_START };
+#define SLOT4_X               (0x16C - TOUCH_BLOCK_START)
+#define SLOT4_Y               (0x120 - TOUCH_BLOCK_START)
+
+// A finger we are following
+typedef struct
+{
+  bool Active;
+  bool Seen;                     // Matched in the current sample
+  bool Gesture;                  // Already used up by a long press or pinch - no tap or swipe on release
+  uint8_t Id;
+  uint8_t Tag;
+  int16_t X, Y;
+  int16_t StartX, StartY;
+  uint32_t StartTime;
+} TouchContact;
+
+static TouchContact Contacts[TOUCH_POINTS];
+static TouchEvent Queue[TOUCH_QUEUE_SIZE];
+static uint8_t QueueHead, QueueCount;
+static TouchStats Stats;
+static uint16_t Period;
+static uint32_t LastSample;
+static uint8_t NextId;
+static uint16_t PinchStart, PinchLast;                               // Finger spacing, 0 when not pinching
+
+static uint16_t Touch_Get16(const uint8_t *p)
+{
+  return (p[0] | ((uint16_t)p[1] << 8));
+}
+
+static uint16_t Touch_Sqrt(uint32_t v)
+{
+  uint32_t Root = 0, Bit = 1UL << 30;
+
+  while (Bit > v)
+    Bit >>= 2;
+  while (Bit)
+  {
+    if (v >= Root + Bit)
+    {
+      v -= Root + Bit;
+      Root = (Root >> 1) + Bit;
+    }
+    else
+      Root >>= 1;
+    Bit >>= 2;
+  }
+  return (Root);
+}
+
+static uint32_t Touch_Dist2(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+  int32_t dx = x1 - x0, dy = y1 - y0;
+
+  return ((uint32_t)(dx * dx + dy * dy));
+}
+
+static void Touch_Queue(uint8_t Type, TouchContact *c, int16_t x, int16_t y, uint16_t Param, uint32_t Now)
+{
+  TouchEvent *Ev;
+
+  if (QueueCount == TOUCH_QUEUE_SIZE)
+  {
+    Stats.Dropped++;
+    return;
+  }
+  Ev = &Queue[(QueueHead + QueueCount++) % TOUCH_QUEUE_SIZE];
+  Ev->Type = Type;
+  Ev->Id = c->Id;
+  Ev->Tag = c->Tag;
+  Ev->X = x;
+  Ev->Y = y;
+  Ev->Param = Param;
+  Ev->Time = Now;
+}
+
+// Put the touch controller into extended (multi-touch) mode and start sampling every PeriodMs
+void Touch_Init(uint16_t PeriodMs)
+{
+  wr8(REG_CTOUCH_EXTEND + RAM_REG, 0);                               // 0 = extended mode, 1 = compatibility mode
+  memset(Contacts, 0, sizeof(Contacts));
+  memset(&Stats, 0, sizeof(Stats));
+  QueueHead = QueueCount = 0;
+  PinchStart = 0;
+  Period = PeriodMs;
+  LastSample = HAL_Millis();
+}
+
+void Touch_SetPeriod(uint16_t PeriodMs)
+{
+  Period = PeriodMs;
+}
+
+// A finger has lifted - work out what it was
+static void Touch_Release(TouchContact *c, uint32_t Now)
+{
+  int16_t dx = c->X - c->StartX, dy = c->Y - c->StartY;
+  uint32_t Held = Now - c->StartTime;
+  uint32_t Moved2 = Touch_Dist2(c->StartX, c->StartY, c->X, c->Y);
+
+  Touch_Queue(TOUCH_EV_UP, c, c->X, c->Y, 0, Now);
+  if (!c->Gesture)
+  {
+    if ((Moved2 <= (uint32_t)TOUCH_SLOP * TOUCH_SLOP) && (Held <= TOUCH_TAP_MS))
+      Touch_Queue(TOUCH_EV_TAP, c, c->StartX, c->StartY, 0, Now);
+    else if ((Moved2 >= (uint32_t)TOUCH_SWIPE_DIST * TOUCH_SWIPE_DIST) && (Held <= TOUCH_SWIPE_MS))
+    {
+      if (abs(dx) > abs(dy))
+        Touch_Queue(TOUCH_EV_SWIPE, c, c->StartX, c->StartY, (dx < 0) ? TOUCH_LEFT : TOUCH_RIGHT, Now);
+      else
+        Touch_Queue(TOUCH_EV_SWIPE, c, c->StartX, c->StartY, (dy < 0) ? TOUCH_UP : TOUCH_DOWN, Now);
+    }
+  }
+  c->Active = false;
+}
+
+// Two fingers down - report changes in their spacing
+static void Touch_Pinch(TouchContact *a, TouchContact *b, uint32_t Now)
+{
+  uint16_t Spacing = Touch_Sqrt(Touch_Dist2(a->X, a->Y, b->X, b->Y));
+
+  if (!PinchStart)
+  {
+    PinchStart = PinchLast = Spacing ? Spacing : 1;
+    return;
+  }
+  if (abs((int16_t)Spacing - (int16_t)PinchLast) >= TOUCH_PINCH_STEP)
+  {
+    a->Gesture = b->Gesture = true;
+    PinchLast = Spacing;
+    Touch_Queue(TOUCH_EV_PINCH, a, (a->X + b->X) / 2, (a->Y + b->Y) / 2, ((uint32_t)Spacing << 8) / PinchStart, Now);
+  }
+}
+
+// Take a sample if it is time.  Returns true if a sample was taken.
+bool Touch_Poll(void)
+{
+  uint8_t Block[TOUCH_BLOCK_SIZE];
+  uint32_t Now = HAL_Millis();
+  uint32_t Start, Best, d;
+  int16_t x, y;
+  uint8_t s, n, Match, Down;
+  TouchContact *c, *Two[2];
+
+  if ((Now - LastSample) < Period)                                   // Wrap safe
+    return false;
+  LastSample = Now;
+  Start = HAL_Micros();
+
+  ReadBlockRAM(RAM_REG + TOUCH_BLOCK_START, Block, TOUCH_BLOCK_SIZE);
+
+  for (n = 0; n < TOUCH_POINTS; n++)
+    Contacts[n].Seen = false;
+
+  for (s = 0; s < TOUCH_POINTS; s++)
+  {
+    if (s == 4)
+    {
+      x = Touch_Get16(Block + SLOT4_X);
+      y = Touch_Get16(Block + SLOT4_Y);
+    }
+    else
+    {
+      x = Touch_Get16(Block + SlotXY[s] + 2);
+      y = Touch_Get16(Block + SlotXY[s]);
+    }
+    if (((uint16_t)x == TOUCH_NONE) || ((uint16_t)y == TOUCH_NONE))
+      continue;
+
+    // The nearest contact not yet matched is this finger
+    Match = TOUCH_POINTS;
+    Best = (uint32_t)TOUCH_TRACK_DIST * TOUCH_TRACK_DIST;
+    for (n = 0; n < TOUCH_POINTS; n++)
+    {
+      if (Contacts[n].Active && !Contacts[n].Seen && ((d = Touch_Dist2(Contacts[n].X, Contacts[n].Y, x, y)) <= Best))
+      {
+        Best = d;
+        Match = n;
+      }
+    }
+
+    if (Match == TOUCH_POINTS)                                       // A new finger
+    {
+      for (n = 0; (n < TOUCH_POINTS) && Contacts[n].Active; n++);
+      if (n == TOUCH_POINTS)
+        continue;
+      c = &Contacts[n];
+      c->Active = true;
+      c->Gesture = false;
+      c->Id = NextId++;
+      c->Tag = Block[SlotTag[s]];
+      c->StartX = x;
+      c->StartY = y;
+      c->StartTime = Now;
+      Touch_Queue(TOUCH_EV_DOWN, c, x, y, 0, Now);
+    }
+    else
+      c = &Contacts[Match];
+    c->X = x;
+    c->Y = y;
+    c->Seen = true;
+  }
+
+  Down = 0;
+  for (n = 0; n < TOUCH_POINTS; n++)
+  {
+    c = &Contacts[n];
+    if (!c->Active)
+      continue;
+    if (!c->Seen)
+    {
+      Touch_Release(c, Now);
+      continue;
+    }
+    if (Down < 2)
+      Two[Down] = c;
+    Down++;
+    if (!c->Gesture && ((Now - c->StartTime) >= TOUCH_LONG_MS) &&
+        (Touch_Dist2(c->StartX, c->StartY, c->X, c->Y) <= (uint32_t)TOUCH_SLOP * TOUCH_SLOP))
+    {
+      c->Gesture = true;
+      Touch_Queue(TOUCH_EV_LONGPRESS, c, c->X, c->Y, 0, Now);
+    }
+  }
+
+  if (Down == 2)
+    Touch_Pinch(Two[0], Two[1], Now);
+  else
+    PinchStart = 0;
+
+  Stats.Samples++;
+  Stats.CostUs = HAL_Micros() - Start;
+  Stats.CostUsTotal += Stats.CostUs;
+  if (Stats.CostUs > Stats.CostUsMax)
+    Stats.CostUsMax = Stats.CostUs;
+  return true;
+}
+
+// Collect the oldest event.  Returns false when there are none.
+bool Touch_GetEvent(TouchEvent *Event)
+{
+  if (!QueueCount)
+    return false;
+  *Event = Queue[QueueHead];
+  QueueHead = (QueueHead + 1) % TOUCH_QUEUE_SIZE;
+  QueueCount--;
+  return true;
+}
+
+// Number of fingers down at the last sample
+uint8_t Touch_Count(void)
+{
+  uint8_t n, Count = 0;
+
+  for (n = 0; n < TOUCH_POINTS; n++)
+    Count += Contacts[n].Active;
+  return (Count);
+}
+
+TouchStats *Touch_GetStats(void)
+{
+  return (&Stats);
+}
+
+void Touch_LogStats(void)
+{
+  Log("Touch %lu samples, %u dropped\n", Stats.Samples, Stats.Dropped);
+  Log("%lu us avg, %lu us max\n", Stats.Samples ? Stats.CostUsTotal / Stats.Samples : 0, Stats.CostUsMax);
+}
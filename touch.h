@@ -0,0 +1,75 @@
+#ifndef TOUCH_H
+#define TOUCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// The capacitive touch registers Eve reports all five points in, read as one block.  0x11C is
+// REG_CTOUCH_TOUCH1_XY and 0x190 is REG_CTOUCH_TOUCH3_XY, the last of them.
+#define TOUCH_BLOCK_START     0x11C
+#define TOUCH_BLOCK_SIZE      (0x190 + 4 - TOUCH_BLOCK_START)
+#define TOUCH_POINTS          5
+#define TOUCH_NONE            0x8000                                 // X or Y when a point is not touched
+
+// Gesture tuning, in pixels and milliseconds
+#define TOUCH_SLOP            12                                     // Movement still counted as holding still
+#define TOUCH_TAP_MS          250                                    // Longest press which is a tap
+#define TOUCH_LONG_MS         600                                    // Holding still this long is a long press
+#define TOUCH_SWIPE_DIST      60                                     // Shortest swipe
+#define TOUCH_SWIPE_MS        500                                    // Slowest swipe
+#define TOUCH_TRACK_DIST      80                                     // Furthest a contact can move between samples
+#define TOUCH_PINCH_STEP      8                                      // Change in finger spacing worth an event
+
+#define TOUCH_QUEUE_SIZE      8                                      // Events held until collected
+
+// Event types
+#define TOUCH_EV_DOWN         1
+#define TOUCH_EV_UP           2
+#define TOUCH_EV_TAP          3
+#define TOUCH_EV_LONGPRESS    4
+#define TOUCH_EV_SWIPE        5                                      // Param is the direction
+#define TOUCH_EV_PINCH        6                                      // Param is the spacing relative to the start, 256 = 1.0
+
+// Swipe directions
+#define TOUCH_LEFT            0
+#define TOUCH_RIGHT           1
+#define TOUCH_UP              2
+#define TOUCH_DOWN            3
+
+typedef struct
+{
+  uint8_t Type;                  // TOUCH_EV_...
+  uint8_t Id;                    // Contact the event belongs to (the first one of a pinch)
+  uint8_t Tag;                   // Tag under the contact when it came down
+  int16_t X, Y;                  // Where it happened (the middle of a pinch)
+  uint16_t Param;
+  uint32_t Time;                 // HAL_Millis() of the sample it came from
+} TouchEvent;
+
+// Where the time goes.  CostUs is SPI read plus processing, which with the sample period gives the bus load.
+typedef struct
+{
+  uint32_t Samples;
+  uint32_t CostUs;               // Last sample
+  uint32_t CostUsMax;
+  uint32_t CostUsTotal;          // Divide by Samples for the average
+  uint16_t Dropped;              // Events lost because nobody collected them
+} TouchStats;
+
+void Touch_Init(uint16_t PeriodMs);
+void Touch_SetPeriod(uint16_t PeriodMs);
+bool Touch_Poll(void);
+bool Touch_GetEvent(TouchEvent *Event);
+uint8_t Touch_Count(void);
+TouchStats *Touch_GetStats(void);
+void Touch_LogStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,241 @@
+// Video playback.  AVI (MJPEG) files are streamed from the file layer through the media FIFO and decoded by
+// the CoProcessor.  All function calls are hardware ambivalent.
+//
+// Two ways to play:
+// - Video_PlayFullScreen() hands the whole job to CMD_PLAYVIDEO.  The CoProcessor decodes, scales and paces
+//   the frames itself and we just keep the media FIFO topped up until the command completes.
+// - Video_PlayBitmap() decodes one frame at a time with CMD_VIDEOFRAME into a bitmap in RAM_G and builds the
+//   display list itself.  That way the video can sit anywhere on a screen, and we control the pacing.  A frame
+//   which finishes decoding more than one frame period late is dropped (decoded but never shown) so that the
+//   video keeps time instead of slowly falling behind.  Frames are decoded into two alternating buffers so
+//   that the frame on screen is never overwritten.
+//
+// The media FIFO can only be fed while we are waiting for the CoProcessor, so the feed is done in the wait
+// loops.  If the file ends before the CoProcessor is satisfied (truncated file) we give up after
+// VIDEO_STALL_MS and reset the CoProcessor rather than wait forever.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "dlog.h"                // Deferred logging
+#include "video.h"               // Every c file has it's header and this is the one for this file
+
+// Size of the chunks read from the file.  Must be a multiple of 4 to keep the media FIFO aligned.
+#define VIDEO_CHUNK           WorkBuffSz
+
+// The bit of the file we have read but not yet managed to put into the media FIFO
+typedef struct
+{
+  uint8_t Buf[VIDEO_CHUNK];
+  uint16_t Fill;                 // Bytes in Buf
+  uint16_t Offset;               // Bytes of Buf already written to the media FIFO
+  uint32_t Remaining;            // Bytes of the file not yet read
+} VideoFeeder;
+
+// Open the file, check that it is an AVI and pick up the frame period from the main AVI header.
+// RIFF header (12 bytes), "LIST" + size + "hdrl" (12 bytes), "avih" + size (8 bytes), dwMicroSecPerFrame
+static bool Video_Open(char *filename, VideoFeeder *Feeder, VideoStats *Stats)
+{
+  uint8_t *Hdr = Feeder->Buf;
+
+  memset(Stats, 0, sizeof(VideoStats));
+
+  FileOpen(filename, FILEREAD);
+  if(!myFileIsOpen())
+  {
+    Log("%s not open\n", filename);
+    FileClose();
+    return false;
+  }
+
+  Feeder->Remaining = FileSize();
+  Feeder->Fill = 0;
+  Feeder->Offset = 0;
+
+  if (Feeder->Remaining < 36)
+  {
+    Log("%s not AVI\n", filename);
+    FileClose();
+    return false;
+  }
+  FileReadBuf(Hdr, 36);
+  if (memcmp(Hdr, "RIFF", 4) || memcmp(Hdr + 8, "AVI ", 4) || memcmp(Hdr + 24, "avih", 4))
+  {
+    Log("%s not AVI\n", filename);
+    FileClose();
+    return false;
+  }
+  Stats->FrameMs = (Hdr[32] + ((uint32_t)Hdr[33] << 8) + ((uint32_t)Hdr[34] << 16) + ((uint32_t)Hdr[35] << 24)) / 1000;
+  FileSeek(0);                                               // The CoProcessor wants the whole file, headers and all
+  return true;
+}
+
+// Top up the media FIFO from the file.  Returns the number of bytes that went into the FIFO.
+static uint32_t Video_Feed(VideoFeeder *Feeder, VideoStats *Stats)
+{
+  uint32_t Sent = 0;
+  uint32_t Written;
+
+  while (1)
+  {
+    if (Feeder->Offset == Feeder->Fill)                      // Buffer all sent, so get some more
+    {
+      if (!Feeder->Remaining)
+        break;
+      Feeder->Fill = (Feeder->Remaining > VIDEO_CHUNK) ? VIDEO_CHUNK : Feeder->Remaining;
+      Feeder->Offset = 0;
+      FileReadBuf(Feeder->Buf, Feeder->Fill);
+      Feeder->Remaining -= Feeder->Fill;
+    }
+
+    Written = MediaFifo_Write(Feeder->Buf + Feeder->Offset, Feeder->Fill - Feeder->Offset);
+    if (!Written)                                            // Media FIFO is full
+      break;
+    Feeder->Offset += Written;
+    Sent += Written;
+  }
+  Stats->Bytes += Sent;
+  return (Sent);
+}
+
+// Keep the media FIFO fed until the CoProcessor has executed everything in the command FIFO.
+// Returns false if the CoProcessor faulted or stalled waiting for data that is never coming.
+static bool Video_Wait(VideoFeeder *Feeder, VideoStats *Stats)
+{
+  uint16_t ReadReg;
+  uint32_t LastProgress = HAL_Millis();
+
+  while (1)
+  {
+    ReadReg = rd16(REG_CMD_READ + RAM_REG);
+    if (ReadReg == 0xFFF)                                    // CoProcessor fault - this reports and recovers
+    {
+      Wait4CoProFIFOEmpty();
+      return false;
+    }
+    if (ReadReg == FifoWriteLocation)                        // Done
+      return true;
+
+    if (Video_Feed(Feeder, Stats) || MediaFifo_Pending())    // Still data moving
+      LastProgress = HAL_Millis();
+    else if ((HAL_Millis() - LastProgress) > VIDEO_STALL_MS)
+    {
+      DLOG1(VIDEO_STALL, Stats->Frames);
+      CoProReset();
+      return false;
+    }
+  }
+}
+
+static void Video_Finish(VideoStats *Stats, uint32_t Start)
+{
+  Stats->ElapsedMs = HAL_Millis() - Start;
+  if (Stats->ElapsedMs)                                      // Split so that bytes * 1000 does not overflow
+    Stats->Throughput = (Stats->Bytes / Stats->ElapsedMs) * 1000 + ((Stats->Bytes % Stats->ElapsedMs) * 1000) / Stats->ElapsedMs;
+}
+
+// Play an AVI full screen with CMD_PLAYVIDEO.  Options are added to OPT_MEDIAFIFO | OPT_FULLSCREEN | OPT_NOTEAR,
+// OPT_SOUND being the useful one.  The screen is left showing the last frame.
+bool Video_PlayFullScreen(char *filename, uint32_t Options, VideoStats *Stats)
+{
+  VideoFeeder Feeder;
+  uint32_t Start;
+  bool Result;
+
+  if (!Video_Open(filename, &Feeder, Stats))
+    return false;
+
+  MediaFifo_Init(VIDEO_FIFO_BASE, VIDEO_FIFO_SIZE);
+  Start = HAL_Millis();
+
+  Cmd_PlayVideo(OPT_MEDIAFIFO | OPT_FULLSCREEN | OPT_NOTEAR | Options);
+  Video_Feed(&Feeder, Stats);                                // Prime the media FIFO before the CoProcessor goes looking
+  UpdateFIFO();                                              // Trigger the CoProcessor to start processing the FIFO
+  Result = Video_Wait(&Feeder, Stats);
+
+  FileClose();
+  Video_Finish(Stats, Start);
+  return (Result);
+}
+
+// Put the decoded frame on screen
+static void Video_ShowFrame(uint32_t FrameAdd, uint16_t Xsize, uint16_t Ysize, uint16_t Xloc, uint16_t Yloc, uint8_t Reference)
+{
+  Send_CMD(CMD_DLSTART);                                     // Start a new display list
+  Send_CMD(CLEAR_COLOR_RGB(0,0,0));                          // Black surround
+  Send_CMD(CLEAR(1,1,1));                                    // clear screen
+  Send_CMD(BITMAP_HANDLE(Reference));                        // handle for this bitmap
+  Cmd_SetBitmap(FrameAdd, RGB565, Xsize, Ysize);             // CMD_VIDEOFRAME always decodes to RGB565
+  Send_CMD(BEGIN(BITMAPS));
+  Send_CMD(VERTEX2II(Xloc, Yloc, Reference, 0));
+  Send_CMD(END());
+  Send_CMD(DISPLAY());                                       // End display list
+  Send_CMD(CMD_SWAP);                                        // Activate this display list
+  UpdateFIFO();                                              // Trigger the CoProcessor to start processing the FIFO
+}
+
+// Play an AVI into a bitmap at (Xloc, Yloc) using CMD_VIDEOFRAME.  Xsize and Ysize must match the video.
+// Two frame buffers are used starting at FrameAdd, so 2 * Xsize * Ysize * 2 bytes of RAM_G are needed below
+// VIDEO_DONE_ADDR.  FrameMs sets the frame period; 0 takes it from the AVI header.
+bool Video_PlayBitmap(char *filename, uint32_t FrameAdd, uint16_t Xsize, uint16_t Ysize, uint16_t Xloc, uint16_t Yloc, uint8_t Reference, uint32_t FrameMs, VideoStats *Stats)
+{
+  VideoFeeder Feeder;
+  uint32_t FrameSize = (uint32_t)Xsize * Ysize * 2;
+  uint32_t Start, Due, Now;
+  uint8_t Back = 0;                                          // Which of the two frame buffers we decode into
+  bool Result = true;
+
+  if ((FrameAdd + 2 * FrameSize) > VIDEO_DONE_ADDR)
+  {
+    Log("Video frames too big\n");
+    return false;
+  }
+  if (!Video_Open(filename, &Feeder, Stats))
+    return false;
+  if (FrameMs)
+    Stats->FrameMs = FrameMs;
+
+  MediaFifo_Init(VIDEO_FIFO_BASE, VIDEO_FIFO_SIZE);
+  Cmd_VideoStart();
+  Video_Feed(&Feeder, Stats);                                // Prime the media FIFO before the CoProcessor goes looking
+  UpdateFIFO();
+  Start = HAL_Millis();
+  Due = Start;                                               // When the frame being decoded should appear
+
+  do
+  {
+    Cmd_VideoFrame(FrameAdd + Back * FrameSize, VIDEO_DONE_ADDR);
+    UpdateFIFO();
+    if (!Video_Wait(&Feeder, Stats))
+    {
+      Result = false;
+      break;
+    }
+    Stats->Frames++;
+
+    Now = HAL_Millis();
+    if ((int32_t)(Now - Due) > (int32_t)Stats->FrameMs)     // More than a frame late - skip it to catch up
+    {
+      Stats->Dropped++;
+    }
+    else
+    {
+      while ((int32_t)(HAL_Millis() - Due) < 0)              // Early - keep the media FIFO full while we wait
+        Video_Feed(&Feeder, Stats);
+      Video_ShowFrame(FrameAdd + Back * FrameSize, Xsize, Ysize, Xloc, Yloc, Reference);
+      Back ^= 1;
+    }
+    Due += Stats->FrameMs;
+  } while (rd32(VIDEO_DONE_ADDR));                           // The CoProcessor writes 0 here after the last frame
+
+  FileClose();
+  Video_Finish(Stats, Start);
+  return (Result);
+}
+
+// Report how playback went.  Split in two because the Arduino log buffer is only 64 bytes.
+void Video_LogStats(VideoStats *Stats)
+{
+  Log("Video %lu frames, %lu dropped\n", Stats->Frames, Stats->Dropped);
+  Log("%lu bytes, %lu ms, %lu B/s\n", Stats->Bytes, Stats->ElapsedMs, Stats->Throughput);
+}
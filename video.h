@@ -0,0 +1,38 @@
+#ifndef VIDEO_H
+#define VIDEO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+// RAM_G layout used during video playback.  The media FIFO sits just below RAM_G_WORKING so that the
+// bottom of RAM_G is free for the decoded frame (a 480x272 RGB565 frame is 255KB).
+#define VIDEO_FIFO_SIZE       0x10000UL                              // 64KB ring - must be a multiple of 4
+#define VIDEO_FIFO_BASE       (RAM_G_WORKING - VIDEO_FIFO_SIZE)      // Media FIFO ring in RAM_G
+#define VIDEO_DONE_ADDR       (VIDEO_FIFO_BASE - 4)                  // Completion word for CMD_VIDEOFRAME
+#define VIDEO_STALL_MS        1000                                   // Give up when the CoProcessor makes no progress this long
+
+// Playback results.  Throughput is what actually went through SPI into the media FIFO, so comparing it with
+// the bitrate of the file tells you whether the current SPI clock can keep up with a given resolution.
+typedef struct
+{
+  uint32_t Frames;               // Frames decoded (bitmap playback only - CMD_PLAYVIDEO does not tell us)
+  uint32_t Dropped;              // Frames decoded too late to be shown
+  uint32_t Bytes;                // Bytes streamed from the file into the media FIFO
+  uint32_t ElapsedMs;            // Wall clock time of the whole playback
+  uint32_t Throughput;           // Sustained bytes per second
+  uint32_t FrameMs;              // Frame period used for pacing
+} VideoStats;
+
+bool Video_PlayFullScreen(char *filename, uint32_t Options, VideoStats *Stats);
+bool Video_PlayBitmap(char *filename, uint32_t FrameAdd, uint16_t Xsize, uint16_t Ysize, uint16_t Xloc, uint16_t Yloc, uint8_t Reference, uint32_t FrameMs, VideoStats *Stats);
+void Video_LogStats(VideoStats *Stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
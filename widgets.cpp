@@ -0,0 +1,384 @@
+// Retained widgets.  All function calls are hardware ambivalent.
+//
+// The screens in process.c are immediate mode: they send every command of the screen each time, so changing
+// one number means building the whole screen again.  Here the screen is a tree of widgets which remember their
+// state.  Changing a widget marks it and everything above it dirty, and WidgetTree::Render() does nothing at
+// all until something is.
+//
+// Each widget keeps the command words it was drawn with last time - its own followed by those of its children
+// - recorded with Eve_RecordStart() rather than sent.  When the tree is rendered only dirty widgets are drawn
+// again; a clean widget (and so its whole subtree) is a copy of the words it already has, and the whole tree
+// goes to the FIFO through a WorkBuffSz copy at a time (the Arduino SPI write overwrites what it sends, so the
+// cache itself never goes near it).  Every widget sets its own color and tag, so its words mean the same
+// wherever they land.  The price is RAM: a widget's words are held once for it and once more for each widget
+// above it, so keep trees shallow on small processors.
+//
+// Widgets which can be touched (buttons, sliders, dials) get a tag from the tree when they are added to it and
+// WidgetTree::Event() routes the tag events from input.c to them.  Sliders and dials are also given CMD_TRACK,
+// and WidgetTree::Poll() follows REG_TRACKER while one is held.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include "Eve2_81x.h"            // Matrix Orbital Eve2 Driver
+#include "Arduino_AL.h"          // include the hardware specific abstraction layer header for the specific hardware in use.
+#include "widgets.h"             // Every c file has it's header and this is the one for this file
+#include "input.h"               // Event types
+#include "dlcheck.h"             // Display list budget
+
+static uint32_t Scratch[WIDGET_SCRATCH_WORDS];                      // One widget's own words while they are recorded
+
+Widget::Widget(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  X = x;
+  Y = y;
+  W = w;
+  H = h;
+  Color = 0xFFFFFF;
+  Fg = 0x003870;                                                     // Eve's own defaults
+  Bg = 0x002040;
+  TagValue = 0;
+  Dirty = true;
+  EventHandler = 0;
+  Parent = 0;
+  User = 0;
+  Tree = 0;
+  FirstChild = NextSibling = 0;
+  Words = 0;
+  WordCount = WordSpace = 0;
+}
+
+Widget::~Widget()
+{
+  if (Parent)
+    Parent->Remove(this);
+  while (FirstChild)
+    Remove(FirstChild);
+  free(Words);
+}
+
+void Widget::Add(Widget *Child)
+{
+  Widget **Link = &FirstChild;
+
+  while (*Link)
+    Link = &(*Link)->NextSibling;
+  *Link = Child;
+  Child->NextSibling = 0;
+  Child->Parent = this;
+  if (Tree)
+    Tree->Attach(Child);
+  Invalidate();
+}
+
+void Widget::Remove(Widget *Child)
+{
+  Widget **Link = &FirstChild;
+
+  while (*Link && (*Link != Child))
+    Link = &(*Link)->NextSibling;
+  if (!*Link)
+    return;
+  *Link = Child->NextSibling;
+  if (Tree)
+    Tree->Detach(Child);
+  Child->Parent = 0;
+  Child->NextSibling = 0;
+  Invalidate();
+}
+
+// Anything dirty has everything above it dirty already, so this stops at the first one it finds
+void Widget::Invalidate(void)
+{
+  Widget *w;
+
+  for (w = this; w && !w->Dirty; w = w->Parent)
+    w->Dirty = true;
+}
+
+void Widget::SetPos(int16_t x, int16_t y)
+{
+  Changed((X != x) || (Y != y));
+  X = x;
+  Y = y;
+}
+
+void Widget::Begin(void)
+{
+  Send_CMD(COLOR_RGB(Color >> 16, Color >> 8, Color));
+  Send_CMD(TAG(TagValue));                                           // 0 for widgets which can not be touched
+}
+
+void Widget::Touch(uint8_t Type)
+{
+  if (EventHandler)
+    EventHandler(this, Type);
+}
+
+WButton::WButton(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t Font, const char *Text) : Widget(x, y, w, h)
+{
+  this->Font = Font;
+  Str = Text;
+  Down = false;
+}
+
+void WButton::Draw(void)
+{
+  Begin();
+  Cmd_FGcolor(Fg);
+  Cmd_Button(X, Y, W, H, Font, Down ? OPT_FLAT : 0, Str);            // Flat while held down
+}
+
+void WButton::Touch(uint8_t Type)
+{
+  Changed(Down != (Type == INPUT_TAG_DOWN));
+  Down = (Type == INPUT_TAG_DOWN);
+  Widget::Touch(Type);
+}
+
+WText::WText(int16_t x, int16_t y, uint8_t Font, uint16_t Options, const char *Text) : Widget(x, y)
+{
+  this->Font = Font;
+  this->Options = Options;
+  Str = Text;
+}
+
+void WText::Draw(void)
+{
+  Begin();
+  Cmd_Text(X, Y, Font, Options, Str);
+}
+
+WNumber::WNumber(int16_t x, int16_t y, uint8_t Font, uint16_t Options, int32_t Value) : Widget(x, y)
+{
+  this->Font = Font;
+  this->Options = Options;
+  this->Value = Value;
+}
+
+void WNumber::Draw(void)
+{
+  Begin();
+  Cmd_Number(X, Y, Font, Options, (uint32_t)Value);
+}
+
+WGauge::WGauge(int16_t x, int16_t y, int16_t r, uint16_t Options, uint8_t Major, uint8_t Minor, uint16_t Range) :
+  Widget(x, y, r, r)
+{
+  this->Options = Options;
+  this->Major = Major;
+  this->Minor = Minor;
+  this->Range = Range;
+  Value = 0;
+}
+
+void WGauge::Draw(void)
+{
+  Begin();
+  Cmd_BGcolor(Bg);
+  Cmd_Gauge(X, Y, W, Options, Major, Minor, Value, Range);
+}
+
+WSlider::WSlider(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t Range) : Widget(x, y, w, h)
+{
+  this->Range = Range;
+  Value = 0;
+}
+
+void WSlider::Draw(void)
+{
+  Begin();
+  Cmd_FGcolor(Fg);
+  Cmd_BGcolor(Bg);
+  Cmd_Slider(X, Y, W, H, 0, Value, Range);
+  Cmd_Track(X, Y, W, H, TagValue);
+}
+
+void WSlider::Track(uint16_t v)
+{
+  v = (uint32_t)v * Range / 65535;
+  if (v == Value)
+    return;
+  SetValue(v);
+  Widget::Touch(WIDGET_CHANGED);
+}
+
+WDial::WDial(int16_t x, int16_t y, int16_t r) : Widget(x, y, r, r)
+{
+  Value = 0;
+}
+
+void WDial::Draw(void)
+{
+  Begin();
+  Cmd_FGcolor(Fg);
+  Cmd_BGcolor(Bg);
+  Cmd_Dial(X, Y, W, 0, Value);
+  Cmd_Track(X, Y, 1, 1, TagValue);                                   // 1 x 1 makes it a rotary tracker
+}
+
+void WDial::Track(uint16_t v)
+{
+  if (v == Value)
+    return;
+  SetValue(v);
+  Widget::Touch(WIDGET_CHANGED);
+}
+
+WidgetTree::WidgetTree(uint32_t Background) : Widget(0, 0)
+{
+  this->Background = Background;
+  Tree = this;
+  memset(ByTag, 0, sizeof(ByTag));
+  Held = 0;
+  Frames = WordsDrawn = WordsReused = 0;
+}
+
+WidgetTree::~WidgetTree()
+{
+  while (FirstChild)
+    Remove(FirstChild);
+}
+
+// A widget (and whatever is below it) joins the tree
+void WidgetTree::Attach(Widget *w)
+{
+  Widget *c;
+  uint8_t n;
+
+  w->Tree = this;
+  if (w->Touchable())
+  {
+    for (n = 0; (n < WIDGET_TAGS) && ByTag[n]; n++)
+      ;
+    if (n == WIDGET_TAGS)
+    {
+      Log("Out of widget tags\n");                                   // It draws, but touching it does nothing
+    }
+    else
+    {
+      ByTag[n] = w;
+      w->TagValue = n + 1;
+      w->Dirty = false;                                              // The tag is part of its words, so draw it again
+      w->Invalidate();                                               // and everything above it
+    }
+  }
+  for (c = w->FirstChild; c; c = c->NextSibling)
+    Attach(c);
+}
+
+void WidgetTree::Detach(Widget *w)
+{
+  Widget *c;
+
+  for (c = w->FirstChild; c; c = c->NextSibling)
+    Detach(c);
+  if (w->TagValue)
+  {
+    ByTag[w->TagValue - 1] = 0;
+    if (Held == w->TagValue)
+      Held = 0;
+    w->TagValue = 0;
+    w->Dirty = true;
+  }
+  w->Tree = 0;
+}
+
+// Bring the words of w up to date: its children first (they need the scratch buffer too), then w itself
+bool WidgetTree::Build(Widget *w)
+{
+  Widget *c;
+  uint32_t Own, Total, *Grown;
+
+  if (!w->Dirty)
+    return true;
+  for (c = w->FirstChild; c; c = c->NextSibling)
+  {
+    if (!c->Dirty)
+      WordsReused += c->WordCount;
+    else if (!Build(c))
+      return false;
+  }
+
+  Eve_RecordStart(Scratch, WIDGET_SCRATCH_WORDS);
+  w->Draw();
+  Own = Eve_RecordStop();                                            // 0 if it overflowed, which has been logged
+  WordsDrawn += Own;
+
+  for (Total = Own, c = w->FirstChild; c; c = c->NextSibling)
+    Total += c->WordCount;
+  if (Total > w->WordSpace)
+  {
+    Grown = (uint32_t *)realloc(w->Words, Total * 4);
+    if (!Grown)
+    {
+      Log("Widget out of memory\n");
+      return false;
+    }
+    w->Words = Grown;
+    w->WordSpace = Total;
+  }
+  memcpy(w->Words, Scratch, Own * 4);
+  for (Total = Own, c = w->FirstChild; c; c = c->NextSibling)
+  {
+    memcpy(&w->Words[Total], c->Words, c->WordCount * 4);
+    Total += c->WordCount;
+  }
+  w->WordCount = Total;
+  w->Dirty = false;
+  return true;
+}
+
+// Send a frame when something has changed, or when Force says to anyway (Eve has lost it, say).
+// Returns true if a frame was sent.
+bool WidgetTree::Render(bool Force)
+{
+  uint32_t Chunk[WorkBuffSz / 4];
+  uint16_t n, Count;
+
+  if (!Dirty && !Force)
+    return false;
+  if (!Build(this))
+    return false;
+
+  Send_CMD(CMD_DLSTART);
+  Send_CMD(CLEAR_COLOR_RGB(Background >> 16, Background >> 8, Background));
+  Send_CMD(CLEAR(1, 1, 1));
+  for (n = 0; n < WordCount; n += Count)
+  {
+    Count = ((WordCount - n) > (WorkBuffSz / 4)) ? (WorkBuffSz / 4) : (WordCount - n);
+    memcpy(Chunk, &Words[n], Count * 4);
+    CoProWrCmdBuf((const uint8_t *)Chunk, Count * 4);               // Eve and all our hosts are little endian
+  }
+  Send_CMD(DISPLAY());
+  DlCheck_Swap();
+  Frames++;
+  return true;
+}
+
+// Route a tag event to its widget
+void WidgetTree::Event(uint8_t Type, uint8_t Tag)
+{
+  Widget *w = Find(Tag);
+
+  if (!w)
+    return;
+  if (w->Tracked())
+  {
+    if (Type == INPUT_TAG_DOWN)
+      Held = Tag;
+    else if (Held == Tag)
+      Held = 0;
+  }
+  w->Touch(Type);
+}
+
+// While a slider or dial is held, follow it.  Call this often - every frame or so.
+void WidgetTree::Poll(void)
+{
+  uint32_t Tracker;
+
+  if (!Held)
+    return;
+  Tracker = rd32(REG_TRACKER + RAM_REG);
+  if ((Tracker & 0xFF) == Held)
+    ByTag[Held - 1]->Track(Tracker >> 16);
+}
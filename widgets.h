@@ -0,0 +1,167 @@
+#ifndef WIDGETS_H
+#define WIDGETS_H
+
+// Retained widgets (C++).  Build a tree of widgets once, change their values as things happen, and call
+// Render() - which only sends a frame when something changed.  See widgets.cpp for how.
+
+#include <stdint.h>              // Find integer types like "uint8_t"
+#include <stdbool.h>             // Find type "bool"
+
+#define WIDGET_SCRATCH_WORDS  128                                    // Most words one widget may draw with
+#define WIDGET_TAGS           254                                    // Tags handed out, 1 - 254 (255 is Eve's default)
+#define WIDGET_CHANGED        0                                      // Handler Type when a slider or dial is dragged
+
+class WidgetTree;
+
+class Widget
+{
+public:
+  typedef void (*Handler)(Widget *w, uint8_t Type);                  // INPUT_TAG_DOWN, INPUT_TAG_UP or WIDGET_CHANGED
+
+  Widget(int16_t x, int16_t y, int16_t w = 0, int16_t h = 0);
+  virtual ~Widget();
+
+  void Add(Widget *Child);                                           // Children draw after (on top of) their parent
+  void Remove(Widget *Child);
+  void Invalidate(void);                                             // Draw this again next frame
+  void SetPos(int16_t x, int16_t y);
+  void SetColor(uint32_t rgb) { Changed(Color != rgb); Color = rgb; }  // Text and needle color, 0xRRGGBB
+  void SetFg(uint32_t rgb) { Changed(Fg != rgb); Fg = rgb; }         // CMD_FGCOLOR: button faces, slider knobs
+  void SetBg(uint32_t rgb) { Changed(Bg != rgb); Bg = rgb; }         // CMD_BGCOLOR: gauge faces, slider tracks
+  void OnEvent(Handler h) { EventHandler = h; }
+  uint8_t Tag(void) const { return TagValue; }
+
+  Widget *Parent;
+  void *User;                    // For the application
+
+protected:
+  friend class WidgetTree;
+
+  virtual void Draw(void) {}                                         // Emit the commands for this widget alone
+  virtual bool Touchable(void) const { return false; }               // Wants a tag
+  virtual bool Tracked(void) const { return false; }                 // Wants CMD_TRACK too
+  virtual void Touch(uint8_t Type);
+  virtual void Track(uint16_t /*Value*/) {}
+  void Changed(bool Really) { if (Really) Invalidate(); }
+  void Begin(void);                                                  // Color and tag, common to all
+
+  int16_t X, Y, W, H;
+  uint32_t Color, Fg, Bg;
+  uint8_t TagValue;
+  bool Dirty;
+  Handler EventHandler;
+  WidgetTree *Tree;
+  Widget *FirstChild, *NextSibling;
+  uint32_t *Words;               // This widget and everything below it, as drawn last time
+  uint16_t WordCount, WordSpace;
+};
+
+class WButton : public Widget
+{
+public:
+  WButton(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t Font, const char *Text);
+  void SetText(const char *Text) { Changed(Str != Text); Str = Text; }
+  bool Pressed(void) const { return Down; }
+protected:
+  void Draw(void);
+  bool Touchable(void) const { return true; }
+  void Touch(uint8_t Type);
+  const char *Str;
+  uint8_t Font;
+  bool Down;
+};
+
+class WText : public Widget
+{
+public:
+  WText(int16_t x, int16_t y, uint8_t Font, uint16_t Options, const char *Text);
+  void SetText(const char *Text) { Changed(Str != Text); Str = Text; }  // Call Invalidate() when the same buffer changes
+protected:
+  void Draw(void);
+  const char *Str;
+  uint8_t Font;
+  uint16_t Options;
+};
+
+class WNumber : public Widget
+{
+public:
+  WNumber(int16_t x, int16_t y, uint8_t Font, uint16_t Options, int32_t Value);
+  void SetValue(int32_t v) { Changed(Value != v); Value = v; }
+  int32_t GetValue(void) const { return Value; }
+protected:
+  void Draw(void);
+  uint8_t Font;
+  uint16_t Options;
+  int32_t Value;
+};
+
+class WGauge : public Widget
+{
+public:
+  WGauge(int16_t x, int16_t y, int16_t r, uint16_t Options, uint8_t Major, uint8_t Minor, uint16_t Range);
+  void SetValue(uint16_t v) { Changed(Value != v); Value = v; }
+  uint16_t GetValue(void) const { return Value; }
+protected:
+  void Draw(void);
+  uint16_t Options, Range, Value;
+  uint8_t Major, Minor;
+};
+
+class WSlider : public Widget
+{
+public:
+  WSlider(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t Range);
+  void SetValue(uint16_t v) { Changed(Value != v); Value = v; }
+  uint16_t GetValue(void) const { return Value; }
+protected:
+  void Draw(void);
+  bool Touchable(void) const { return true; }
+  bool Tracked(void) const { return true; }
+  void Track(uint16_t v);
+  uint16_t Range, Value;
+};
+
+class WDial : public Widget
+{
+public:
+  WDial(int16_t x, int16_t y, int16_t r);
+  void SetValue(uint16_t v) { Changed(Value != v); Value = v; }  // 0 - 65535 is once round
+  uint16_t GetValue(void) const { return Value; }
+protected:
+  void Draw(void);
+  bool Touchable(void) const { return true; }
+  bool Tracked(void) const { return true; }
+  void Track(uint16_t v);
+  uint16_t Value;
+};
+
+// The root of a tree, and what it takes to put it on the screen
+class WidgetTree : public Widget
+{
+public:
+  WidgetTree(uint32_t Background = 0);
+  ~WidgetTree();
+
+  bool Render(bool Force = false);                                   // Send a frame if anything changed
+  void Event(uint8_t Type, uint8_t Tag);                             // Hand over an input tag event
+  void Poll(void);                                                   // Follow a slider or dial being dragged
+  Widget *Find(uint8_t Tag) const { return Tag ? ByTag[Tag - 1] : 0; }
+
+  uint32_t Frames;               // Frames sent
+  uint32_t WordsDrawn;           // Words drawn afresh
+  uint32_t WordsReused;          // Words sent from the cache
+
+protected:
+  friend class Widget;
+
+  void Attach(Widget *w);
+  void Detach(Widget *w);
+  bool Build(Widget *w);
+
+  uint32_t Background;
+  Widget *ByTag[WIDGET_TAGS];
+  uint8_t Held;                  // Tag of a tracked widget being touched
+};
+
+#endif